@@ -3,8 +3,9 @@
 
 #include "tree.h"
 #include "tree_ast.h"
+#include "tree_compact.h"
 
-int TreeLoadPrefixFromFile (program_t *program, tree_t *tree,
+int TreeLoadPrefixFromFile (program_t *program, compactTree_t *compact,
                             const char *fileName);
 
 #endif // K_TREE_LOAD_PREFIX
\ No newline at end of file
@@ -2,9 +2,10 @@
 #define K_TREE_TO_ASM_H
 
 #include "tree_ast.h"
+#include "tree_compact.h"
 
 const char * const kDefaultAsmFile = "../processor/asm/my_asm/lang_auto_compiled.my_asm";
 
-int AssembleTreeToFile (program_t *program, const char *fileName);
+int AssembleTreeToFile (program_t *program, compactTree_t *compact, const char *fileName);
 
 #endif // K_TREE_TO_ASM
\ No newline at end of file
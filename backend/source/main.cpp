@@ -4,6 +4,7 @@
 
 #include "tree.h"
 #include "tree_ast.h"
+#include "tree_compact.h"
 #include "tree_load_prefix.h"
 #include "tree_to_asm.h"
 
@@ -18,13 +19,21 @@ int main(int argc, char **argv)
 
     program_t program = {};
 
-    TREE_DO_AND_RETURN (ProgramCtor (&program));
+    MAIN_DO_AND_RETURN (ProgramCtor (&program));
 
-    TREE_DO_AND_CLEAR (TreeLoadPrefixFromFile (&program, &program.ast, argv[1]),
+    // backend only reads the tree, so it's loaded straight into compact form
+    compactTree_t compact = {};
+
+    MAIN_DO_AND_CLEAR (CompactTreeCtor (&compact, 0),
                        ProgramDtor (&program));
 
-    TREE_DO_AND_RETURN (AssembleTreeToFile (&program, kDefaultAsmFile));
+    MAIN_DO_AND_CLEAR (TreeLoadPrefixFromFile (&program, &compact, argv[1]),
+                       CompactTreeDtor (&compact); ProgramDtor (&program));
+
+    MAIN_DO_AND_CLEAR (AssembleTreeToFile (&program, &compact, kDefaultAsmFile),
+                       CompactTreeDtor (&compact); ProgramDtor (&program));
 
+    CompactTreeDtor (&compact);
     ProgramDtor (&program);
 
     DEBUG_PRINT ("\n%s returned 0!\n", argv[0]);
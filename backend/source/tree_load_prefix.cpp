@@ -1,51 +1,69 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <assert.h>
 
 #include "tree_load_prefix.h"
 
 #include "tree.h"
 #include "tree_ast.h"
+#include "tree_compact.h"
 #include "utils.h"
 
-static int TreeLoadNode             (program_t *program, node_t **node,
-                                     char **curPos);
-static int TreeLoadNodeAndFill      (program_t *program, node_t **node,
-                                     char **curPos);
-static int TreeLoadChildNodes       (program_t *program, node_t **node,
+// node, whose children are loaded now
+struct treeLoadFrame_t
+{
+    compactIdx_t node       = kCompactNil;
+    size_t children         = 0;    // loaded so far, if it isn't block
+    size_t firstStatement   = 0;    // in stack of statements, if it's block
+};
+
+typedef dynamicArray_t <treeLoadFrame_t> treeLoadStack_t;
+
+static int TreeLoadNode             (program_t *program, compactTree_t *compact,
                                      char **curPos);
+static int TreeLoadSubtrees         (program_t *program, compactTree_t *compact, char **curPos,
+                                     treeLoadStack_t *stack, dynamicArray_t <compactIdx_t> *statements);
+static int TreeLoadAttach           (compactTree_t *compact, compactIdx_t child,
+                                     treeLoadStack_t *stack, dynamicArray_t <compactIdx_t> *statements);
+static int TreeLoadClose            (compactTree_t *compact, char **curPos,
+                                     treeLoadStack_t *stack, dynamicArray_t <compactIdx_t> *statements);
+static int TreeLoadNodeAndFill      (program_t *program, compactTree_t *compact,
+                                     compactIdx_t *node, char **curPos);
 static int TreeLoadDetectNodeType   (program_t *program, char **curPos, int *readBytes,
                                      type_t *type, value_t *value);
+static int TreeLoadNumber           (const char *curPos, int *readBytes, value_t *value);
 
-int TreeLoadPrefixFromFile (program_t *program, tree_t *tree,
+// Nodes are appended in the order they are read, so file in prefix form gives
+// compact tree in preorder without any conversion
+int TreeLoadPrefixFromFile (program_t *program, compactTree_t *compact,
                             const char *fileName)
 {
     assert (program);
-    assert (tree);
+    assert (compact);
     assert (fileName);
 
     DEBUG_PRINT ("\n========== LOADING TREE FROM \"%s\" ==========\n", fileName);
 
-    if (tree->root != NULL)
+    if (compact->root != kCompactNil)
     {
         ERROR_LOG ("%s", "TREE_ERROR_LOAD_INTO_NOT_EMPTY");
         
         return TREE_ERROR_LOAD_INTO_NOT_EMPTY;
     }
     
-    size_t bufferLen = 0;
-    program->buffer = ReadFile (fileName, &bufferLen);
-    if (program->buffer == NULL)
+    int status = SourceBufferOpen (&program->source, fileName);
+    if (status != COMMON_ERROR_OK)
         return TREE_ERROR_COMMON |
-               COMMON_ERROR_READING_FILE;
+               status;
 
-    char *curPos = program->buffer;
+    char *curPos = program->source.data;
 
     DEBUG_STR (fileName);
     DEBUG_STR (curPos);
     
-    int status = TreeLoadNode (program, &tree->root, &curPos);
+    status = TreeLoadNode (program, compact, &curPos);
 
     if (status != TREE_OK)
     {
@@ -54,62 +72,210 @@ int TreeLoadPrefixFromFile (program_t *program, tree_t *tree,
         return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
     }
 
-    TREE_DUMP (program, tree, "%s", "After load");
+    TREE_DO_AND_RETURN (NAMES_TABLE_VERIFY (&program->namesTable));
+    TREE_DO_AND_RETURN (CompactTreeVerify (compact));
+
+    DEBUG_LOG ("%lu nodes loaded", compact->nodes.size - 1);
     
     DEBUG_PRINT ("%s", "==========    END OF LOADING TREE    ==========\n\n");
 
     return TREE_OK;
 }
 
-int TreeLoadNode (program_t *program, node_t **node,
+// Nodes, whose children are being loaded, are kept on explicit stack, so depth of
+// the tree is limited only by program->ast.depthBudget. Statements of blocks are gathered
+// on one more stack, until block is closed and its size is known.
+// Old files with binary CONNECT nodes instead of blocks are loaded as they are
+int TreeLoadNode (program_t *program, compactTree_t *compact,
                   char **curPos)
 {
     assert (program);
-    assert (node);
+    assert (compact);
     assert (curPos);
     assert (*curPos);
 
-    tree_t *tree = &program->ast;
+    treeLoadStack_t stack = {};
+    dynamicArray_t <compactIdx_t> statements = {};
 
-    *curPos = SkipSpaces (*curPos);
+    int status = TreeLoadSubtrees (program, compact, curPos, &stack, &statements);
+
+    DynamicArrayDtor (&statements);
+    DynamicArrayDtor (&stack);
+
+    return status;
+}
+
+int TreeLoadSubtrees (program_t *program, compactTree_t *compact, char **curPos,
+                      treeLoadStack_t *stack, dynamicArray_t <compactIdx_t> *statements)
+{
+    assert (program);
+    assert (compact);
+    assert (curPos);
+    assert (*curPos);
+    assert (stack);
+    assert (statements);
 
-    if (**curPos == '(')
+    do
     {
-        NODE_CTOR (tree, *node);
+        *curPos = SkipSpaces (*curPos);
+
+        if (**curPos == ')' && stack->size > 0)
+        {
+            TREE_DO_AND_RETURN (TreeLoadClose (compact, curPos, stack, statements));
+
+            continue;
+        }
+
+        compactIdx_t child = kCompactNil;
+
+        // node is appended before its children, so it gets its index right here
+        if (**curPos == '(')
+        {
+            TREE_DO_AND_RETURN (TreeLoadNodeAndFill (program, compact, &child, curPos));
+        }
+        else if (strncmp (*curPos, "nil", sizeof("nil") - 1) == 0)
+        {
+            *curPos += sizeof ("nil") - 1;
+        }
+        else
+        {
+            ERROR_LOG ("%s", "Syntax error in tree dump file - uknown beginning of the node");
+            ERROR_LOG ("curPos = \"%s\";", *curPos);
+
+            return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
+        }
+
+        TREE_DO_AND_RETURN (TreeLoadAttach (compact, child, stack, statements));
 
-        int status = TreeLoadNodeAndFill (program, node, curPos);
+        if (child == kCompactNil)
+            continue;
 
-        return status;
+        TREE_DO_AND_RETURN (TreeStackPush (&program->ast, stack, {.node           = child, 
+                                                                  .children       = 0,
+                                                                  .firstStatement = statements->size}));
     }
-    else if (strncmp (*curPos, "nil", sizeof("nil") - 1) == 0)
+    while (stack->size > 0);
+
+    return TREE_OK;
+}
+
+// child goes to the first free place of the node on the top of the stack, or to the root
+int TreeLoadAttach (compactTree_t *compact, compactIdx_t child,
+                    treeLoadStack_t *stack, dynamicArray_t <compactIdx_t> *statements)
+{
+    assert (compact);
+    assert (stack);
+    assert (statements);
+
+    if (stack->size == 0)
     {
-        *curPos += sizeof ("nil") - 1;
+        compact->root = child;
+
+        return TREE_OK;
+    }
+
+    treeLoadFrame_t *frame = &stack->data[stack->size - 1];
+    compactNode_t *node    = &compact->nodes.data[frame->node];
+
+    if (node->kind == TYPE_BLOCK)
+    {
+        if (child == kCompactNil)
+        {
+            ERROR_LOG ("%s", "Syntax error in tree dump file - nil statement in block");
+
+            return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
+        }
 
-        *node = NULL;
+        int status = DynamicArrayPush (statements, child);
+        if (status != COMMON_ERROR_OK)
+            return TREE_ERROR_COMMON |
+                   status;
 
         return TREE_OK;
     }
-    else 
+
+    if (frame->children >= 2)
     {
-        ERROR_LOG ("%s", "Syntax error in tree dump file - uknown beginning of the node");
-        ERROR_LOG ("curPos = \"%s\";", *curPos);
+        ERROR_LOG ("%s", "Syntax error in tree dump file - missing closing bracket ')'");
 
         return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
     }
+
+    if (frame->children++ == 0)
+        node->left  = child;
+    else
+        node->right = child;
+
+    return TREE_OK;
 }
 
+// reads ')' of node on the top of the stack, block gets its range of statements here
+int TreeLoadClose (compactTree_t *compact, char **curPos,
+                   treeLoadStack_t *stack, dynamicArray_t <compactIdx_t> *statements)
+{
+    assert (compact);
+    assert (curPos);
+    assert (*curPos);
+    assert (stack);
+    assert (statements);
+    assert (stack->size > 0);
+
+    treeLoadFrame_t *frame = &stack->data[stack->size - 1];
+
+    if (compact->nodes.data[frame->node].kind == TYPE_BLOCK)
+    {
+        size_t size  = statements->size - frame->firstStatement;
+        size_t first = compact->statements.size;
+
+        if (first + size > UINT32_MAX)
+        {
+            ERROR_LOG ("%s", "Statements of blocks are out of 32-bit indexes");
+
+            return TREE_ERROR_TO_MUCH_NODES;
+        }
+
+        int status = DynamicArrayResize (&compact->statements, first + size);
+        if (status != COMMON_ERROR_OK)
+            return TREE_ERROR_COMMON |
+                   status;
+
+        if (size > 0)
+            memcpy (compact->statements.data + first, statements->data + frame->firstStatement,
+                    size * sizeof (compactIdx_t));
+
+        compact->nodes.data[frame->node].value = (uint32_t) size;
+        compact->nodes.data[frame->node].left  = (compactIdx_t) first;
+
+        statements->size = frame->firstStatement;
+    }
+    else if (frame->children != 2)
+    {
+        ERROR_LOG ("%s", "Syntax error in tree dump file - node must have two children or nil");
+        ERROR_LOG ("curPos = \'%s\';", *curPos);
+
+        return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
+    }
+
+    (*curPos)++;
+
+    DEBUG_LOG ("After loading subtrees of nodes[%u]. curPos = \'%s\'", frame->node, *curPos);
+
+    stack->size--;
 
-// FIXME: big function
-int TreeLoadNodeAndFill (program_t *program, node_t **node,
-                         char **curPos)
+    return TREE_OK;
+}
+
+// reads '(' and the node itself, not its children
+int TreeLoadNodeAndFill (program_t *program, compactTree_t *compact,
+                         compactIdx_t *node, char **curPos)
 {
     assert (program);
+    assert (compact);
     assert (node);
     assert (curPos);
     assert (*curPos);
 
     DEBUG_PRINT ("%s", "\n===== CREATING NEW NODE =====\n");
-    // DEBUG_STR (*curPos);
 
     (*curPos)++; // move after '('
 
@@ -123,31 +289,11 @@ int TreeLoadNodeAndFill (program_t *program, node_t **node,
         TreeLoadDetectNodeType (program, curPos, &readBytes, &type, &value)
     );
 
-    NodeFill (*node, type, value, NULL, NULL);
+    TREE_DO_AND_RETURN (CompactNodeAppend (compact, type, value, node));
     
     *curPos += readBytes;
-    // *curPos += 1; // because it can be '\0', not space
-    // DEBUG_STR (*curPos);
-    *curPos = SkipSpaces (*curPos);
-    
-    // DEBUG_STR (data);
-    NODE_DUMP (program, *node, "Created new %s node. curPos = \'%s\'", GetTypeName (type), *curPos);
 
-    int status = TreeLoadChildNodes (program, node, curPos);
-    if (status != TREE_OK)
-        return status;
-
-    *curPos = SkipSpaces (*curPos);
-    
-    if (**curPos != ')')
-    {
-        ERROR_LOG ("%s", "Syntax error in tree dump file - missing closing bracket ')'");
-        ERROR_LOG ("curPos = \'%s\';", *curPos);
-
-        return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
-    }
-
-    (*curPos)++;
+    DEBUG_LOG ("Created new %s node. curPos = \'%s\'", GetTypeName (type), *curPos);
 
     return TREE_OK;
 }
@@ -191,17 +337,35 @@ int TreeLoadDetectNodeType  (program_t *program, char **curPos, int *readBytes,
         *type = TYPE_VARIABLE;
         *value = {.idx = idx};
     }
-    else if (sscanf (*curPos, VALUE_NUMBER_FSTRING "%n", &value->number, readBytes) == 1)
+    else if (isdigit (**curPos) || (**curPos == '-' && isdigit ((*curPos)[1])))
     {
+        TREE_DO_AND_RETURN (TreeLoadNumber (*curPos, readBytes, value));
+
         *type = TYPE_CONST_NUM;
         
         DEBUG_LOG ("number " VALUE_NUMBER_FSTRING " detected", value->number);
     }
     else
     {
-        sscanf (*curPos, "%*s%n", readBytes);
-        
-        TryToFindNode (*curPos, *readBytes, type, value);
+        *readBytes = (int) strcspn (*curPos, " \t\n\v\f\r");
+
+        // statements are given to block, when it's closed
+        if ((size_t) *readBytes == sizeof (kBlockStandardName) - 1 &&
+            strncmp (*curPos, kBlockStandardName, sizeof (kBlockStandardName) - 1) == 0)
+        {
+            *type  = TYPE_BLOCK;
+            *value = {.block = NULL};
+        }
+        else
+        {
+            const keyword_t *keyword = FindKeywordByStandardName (*curPos, (size_t) *readBytes);
+
+            if (keyword != NULL)
+            {
+                *type = TYPE_KEYWORD;
+                value->idx = keyword->idx;
+            }
+        }
     }
 
     if (*type == TYPE_UKNOWN)
@@ -221,38 +385,31 @@ int TreeLoadDetectNodeType  (program_t *program, char **curPos, int *readBytes,
     return TREE_OK;
 }
 
-int TreeLoadChildNodes (program_t *program, node_t **node,
-                        char **curPos)
+// numbers in save file can be negative after simplification
+int TreeLoadNumber (const char *curPos, int *readBytes, value_t *value)
 {
-    assert (program);
-    assert (node);
     assert (curPos);
-    assert (*curPos);
+    assert (readBytes);
+    assert (value);
 
-    *curPos = SkipSpaces (*curPos);
+    bool isNegative = (*curPos == '-');
 
-    int status = TreeLoadNode (program, &(*node)->left, curPos);
-    if (status != TREE_OK)
-        return status;
+    numberLiteral_t literal = {};
+    size_t len = ScanNumber (curPos + isNegative, &literal);
 
-    if ((*node)->left != NULL)
+    uint64_t maxAbsValue = isNegative ? (uint64_t) kValueNumberMax + 1 : (uint64_t) kValueNumberMax;
+
+    if (len == 0 || literal.fractionDigits != 0 || literal.isOverflow || literal.integer > maxAbsValue)
     {
-        NODE_DUMP (program, (*node)->left, "After creating left subtree. \n"
-                                        "curPos = \'%s\'", *curPos);
+        ERROR_PRINT ("Bad number in save file: \"%.*s\"", (int) (len + isNegative), curPos);
+
+        return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
     }
 
-    *curPos = SkipSpaces (*curPos);
-    
-    status = TreeLoadNode (program, &(*node)->right, curPos);
-    if (status != TREE_OK)
-        return status;
+    int64_t number = isNegative ? -(int64_t) literal.integer : (int64_t) literal.integer;
+
+    value->number = (valueNumber_t) number;
+    *readBytes    = (int) (len + isNegative);
 
-    if ((*node)->right != NULL)
-    {
-        NODE_DUMP (program, (*node)->right, "After creating right subtree. \n"
-                                         "curPos = \'%s\'", *curPos);
-    }
-    
     return TREE_OK;
 }
-
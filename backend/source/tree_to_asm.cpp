@@ -7,15 +7,45 @@
 #include "tree_to_asm.h"
 
 #include "tree_ast.h"
+#include "tree_compact.h"
 
-static int AssembleNode (program_t *program, node_t *node, FILE *file);
-static int AssembleKeyword (program_t *program, node_t *node, FILE *file);
-
-static int AssembleIf (program_t *program, node_t *node, FILE *file);
+// Node is assembled in steps, code of its children is written between them
+enum assembleStep_t
+{
+    ASSEMBLE_NODE,          // nothing is written yet
+    ASSEMBLE_KEYWORD_END,   // arguments are assembled, instruction is left
+    ASSEMBLE_IF_JUMP,       // condition is assembled
+    ASSEMBLE_IF_END,        // body is assembled
+};
 
-int AssembleTreeToFile (program_t *program, const char *fileName)
+struct assembleTask_t
+{
+    compactIdx_t node       = kCompactNil;
+    assembleStep_t step     = ASSEMBLE_NODE;
+    size_t label            = 0;    // of if
+    size_t statement        = 0;    // of block, that is assembled next
+};
+
+typedef dynamicArray_t <assembleTask_t> assembleStack_t;
+
+static int AssembleNode     (program_t *program, compactTree_t *compact, compactIdx_t node,
+                             FILE *file);
+static int AssembleTask     (program_t *program, compactTree_t *compact,
+                             const assembleTask_t *task, FILE *file, assembleStack_t *stack);
+static int AssembleKeyword  (program_t *program, compactTree_t *compact,
+                             const assembleTask_t *task, FILE *file, assembleStack_t *stack);
+static int AssembleLater    (program_t *program, assembleStack_t *stack, compactIdx_t node,
+                             assembleStep_t step, size_t label);
+
+static int AssembleIf       (program_t *program, compactTree_t *compact,
+                             const assembleTask_t *task, FILE *file, assembleStack_t *stack);
+static int AssembleBlock    (program_t *program, compactTree_t *compact,
+                             const assembleTask_t *task, assembleStack_t *stack);
+
+int AssembleTreeToFile (program_t *program, compactTree_t *compact, const char *fileName)
 {
     assert (program);
+    assert (compact);
 
     DEBUG_LOG ("%s", "");
 
@@ -33,20 +63,65 @@ int AssembleTreeToFile (program_t *program, const char *fileName)
     fprintf (file, "CALL :main\n"
                    "HLT\n");
 
-    TREE_DO_AND_RETURN (AssembleNode (program, program->ast.root, file));
+    int status = TREE_OK;
 
-    return TREE_OK;
+    if (compact->root != kCompactNil)
+        status = AssembleNode (program, compact, compact->root, file);
+
+    fclose (file);
+
+    return status;
+}
+
+// Tasks are kept on explicit stack: the last pushed is done first, so steps of a node
+// are pushed in reverse order. Deep trees are limited only by program->ast.depthBudget
+int AssembleNode (program_t *program, compactTree_t *compact, compactIdx_t node, FILE *file)
+{
+    assert (program);
+    assert (compact);
+    assert (node != kCompactNil);
+    assert (file);
+
+    assembleStack_t stack = {};
+
+    int status = AssembleLater (program, &stack, node, ASSEMBLE_NODE, 0);
+
+    while (status == TREE_OK && stack.size > 0)
+    {
+        assembleTask_t task = stack.data[--stack.size];
+
+        status = AssembleTask (program, compact, &task, file, &stack);
+    }
+
+    DynamicArrayDtor (&stack);
+
+    return status;
 }
 
-int AssembleNode (program_t *program, node_t *node, FILE *file)
+int AssembleLater (program_t *program, assembleStack_t *stack, compactIdx_t node,
+                   assembleStep_t step, size_t label)
 {
     assert (program);
-    assert (node);
+    assert (stack);
+    assert (node != kCompactNil);
+
+    return TreeStackPush (&program->ast, stack, {.node = node, .step = step, .label = label});
+}
+
+int AssembleTask (program_t *program, compactTree_t *compact,
+                  const assembleTask_t *task, FILE *file, assembleStack_t *stack)
+{
+    assert (program);
+    assert (compact);
+    assert (task);
     assert (file);
+    assert (stack);
+
+    const compactNode_t *node = &compact->nodes.data[task->node];
 
-    DEBUG_PTR (node);
+    DEBUG_VAR ("%u", task->node);
 
-    switch (node->type)
+    switch ((type_t) node->kind)
     {
         case TYPE_UKNOWN:
             ERROR_LOG ("%s", "Uknown type of node");
@@ -54,47 +129,65 @@ int AssembleNode (program_t *program, node_t *node, FILE *file)
             return TREE_ERROR_INVALID_NODE;
 
         case TYPE_CONST_NUM:
-            fprintf (file, "PUSH " VALUE_NUMBER_FSTRING "\n", node->value.number);
+            fprintf (file, "PUSH " VALUE_NUMBER_FSTRING "\n", (valueNumber_t) node->value);
 
             break;
             
         case TYPE_KEYWORD:
-            return AssembleKeyword (program, node, file);
+            return AssembleKeyword (program, compact, task, file, stack);
 
         case TYPE_VARIABLE:
             fprintf (file, "PUSH %lu\n"
                            "POPR RAX\n"
-                           "PUSHM [RAX]\n\n", node->value.idx);
+                           "PUSHM [RAX]\n\n", (size_t) node->value);
             
             break;
         
+        case TYPE_BLOCK:
+            return AssembleBlock (program, compact, task, stack);
+
         case TYPE_NAME:
             assert (0 && "Чувак, ты не должен это ассемблировать");
 
         default:
-            assert (0 && "Add new type to AssembleNode");
+            assert (0 && "Add new type to AssembleTask");
             break;
     }
 
     return TREE_OK;
 }
 
-int AssembleKeyword (program_t *program, node_t *node, FILE *file)
+int AssembleKeyword (program_t *program, compactTree_t *compact,
+                     const assembleTask_t *task, FILE *file, assembleStack_t *stack)
 {
     assert (program);
-    assert (node);
+    assert (compact);
+    assert (task);
     assert (file);
-    assert (node->type == TYPE_KEYWORD);
+    assert (stack);
 
-    const keyword_t *keyword = FindKeywordByIdx ((keywordIdxes_t) node->value.idx);
+    // array isn't changed while assembling, so pointers to nodes stay valid
+    const compactNode_t *node  = &compact->nodes.data[task->node];
+    const compactNode_t *nodes = compact->nodes.data;
 
-    if (keyword->numberOfArgs >= 1)
-        TREE_DO_AND_RETURN (AssembleNode (program, node->left, file));
+    assert (node->kind == TYPE_KEYWORD);
 
-    if (keyword->numberOfArgs == 2)
-        TREE_DO_AND_RETURN (AssembleNode (program, node->right, file));
+    const keyword_t *keyword = FindKeywordByIdx ((keywordIdxes_t) node->value);
 
-    switch (node->value.idx)
+    // arguments go before instruction
+    if (task->step == ASSEMBLE_NODE && keyword->numberOfArgs >= 1)
+    {
+        TREE_DO_AND_RETURN (AssembleLater (program, stack, task->node, ASSEMBLE_KEYWORD_END, 0));
+
+        if (keyword->numberOfArgs == 2)
+            TREE_DO_AND_RETURN (AssembleLater (program, stack, node->right, ASSEMBLE_NODE, 0));
+
+        TREE_DO_AND_RETURN (AssembleLater (program, stack, node->left, ASSEMBLE_NODE, 0));
+
+        return TREE_OK;
+    }
+
+    switch (node->value)
     {
         case KEY_ADD:
             fprintf (file, "ADD\n\n");
@@ -120,88 +213,91 @@ int AssembleKeyword (program_t *program, node_t *node, FILE *file)
             fprintf (file, "OUT\n");
             break;
 
-        case KEY_IF: TREE_DO_AND_RETURN (AssembleIf (program, node, file) );
+        case KEY_IF: TREE_DO_AND_RETURN (AssembleIf (program, compact, task, file, stack));
             break;
 
         case KEY_DECLARATE:
         case KEY_ASSIGN:
-            TREE_DO_AND_RETURN (AssembleNode (program, node->right, file));
+            if (task->step == ASSEMBLE_NODE)
+            {
+                TREE_DO_AND_RETURN (AssembleLater (program, stack, task->node, ASSEMBLE_KEYWORD_END, 0));
+                TREE_DO_AND_RETURN (AssembleLater (program, stack, node->right, ASSEMBLE_NODE, 0));
+
+                break;
+            }
 
-            if (node->left->type != TYPE_VARIABLE)
+            if (node->left == kCompactNil || nodes[node->left].kind != TYPE_VARIABLE)
             {
                 ERROR_LOG ("%s", "Left child of declarate/assign node should be variable");
-                ERROR_LOG ("(but this is copy of pointer...) node[%p]", node); // FIXME:
+                ERROR_LOG ("node = nodes[%u]", task->node);
 
                 return TREE_ERROR_INVALID_NODE;
             }
 
             fprintf (file, "PUSH %lu\n"
                            "POPR RAX\n"
-                           "POPM [RAX]\n", node->left->value.idx);     
+                           "POPM [RAX]\n", (size_t) nodes[node->left].value);     
             break;
         
         case KEY_CONNECT:
-            if (node->left != NULL)
-                TREE_DO_AND_RETURN (AssembleNode (program, node->left, file));
-            
-            if (node->right != NULL)
-                TREE_DO_AND_RETURN (AssembleNode (program, node->right, file));
+            if (node->right != kCompactNil)
+                TREE_DO_AND_RETURN (AssembleLater (program, stack, node->right, ASSEMBLE_NODE, 0));
+
+            if (node->left != kCompactNil)
+                TREE_DO_AND_RETURN (AssembleLater (program, stack, node->left, ASSEMBLE_NODE, 0));
             break;
 
         case KEY_FUNC:
         {
-            node_t *arguments = node->left;
-            assert (arguments);
+            assert (node->left != kCompactNil);
+            const compactNode_t *arguments = &nodes[node->left];
 
-            node_t *functionName = arguments->left;
-            assert (functionName);
+            assert (arguments->left != kCompactNil);
+            const compactNode_t *functionName = &nodes[arguments->left];
 
-            const name_t *functionNameStr = NamesTableFindByIdx (&program->namesTable, functionName->value.idx);
+            const name_t *functionNameStr = NamesTableFindByIdx (&program->namesTable, functionName->value);
 
             fprintf (file, "\n:%.*s\n", (int) functionNameStr->len, functionNameStr->name);
 
-            if (arguments->right != NULL)
-                TREE_DO_AND_RETURN (AssembleNode (program, arguments->right, file));
+            compactIdx_t body = node->right;
+            assert (body != kCompactNil);
 
-            node_t *body = node->right;
-            assert (body);
+            TREE_DO_AND_RETURN (AssembleLater (program, stack, body, ASSEMBLE_NODE, 0));
 
-            TREE_DO_AND_RETURN (AssembleNode (program, body, file));
+            if (arguments->right != kCompactNil)
+                TREE_DO_AND_RETURN (AssembleLater (program, stack, arguments->right, ASSEMBLE_NODE, 0));
 
             break;
         }
 
         case KEY_MAIN:
         {
-            node_t *functionName = node->left;
-            assert (functionName);
+            assert (node->left != kCompactNil);
 
             fprintf (file, "\n:main\n");
 
-            node_t *body = node->right;
-            assert (body);
+            compactIdx_t body = node->right;
+            assert (body != kCompactNil);
 
-            TREE_DO_AND_RETURN (AssembleNode (program, body, file));
+            TREE_DO_AND_RETURN (AssembleLater (program, stack, body, ASSEMBLE_NODE, 0));
 
             break;
         }
 
         case KEY_RETURN:
-            assert (node->left);
+            assert (node->left != kCompactNil);
 
             fprintf (file, "\n; Calctulating return value\n");
 
-            // TREE_DO_AND_RETURN (AssembleNode (program, node->left, file)); // FIXME: check what this works
-
             fprintf (file, "POPR RAX\n"
                            "RET\n\n");
             break;
 
         case KEY_CALL:
         {
-            node_t *functionName = node->left;
+            const compactNode_t *functionName = &nodes[node->left];
 
-            const name_t *functionNameStr = NamesTableFindByIdx (&program->namesTable, functionName->value.idx);
+            const name_t *functionNameStr = NamesTableFindByIdx (&program->namesTable, functionName->value);
             assert (functionNameStr);
 
             fprintf (file, "\nCALL :%.*s\n", (int) functionNameStr->len, functionNameStr->name );
@@ -223,26 +319,76 @@ int AssembleKeyword (program_t *program, node_t *node, FILE *file)
     return TREE_OK;
 }
 
-int AssembleIf (program_t *program, node_t *node, FILE *file)
+// Label is taken when if is started, so nested ifs get their own labels
+int AssembleIf (program_t *program, compactTree_t *compact,
+                const assembleTask_t *task, FILE *file, assembleStack_t *stack)
 {
     assert (program);
-    assert (node);
+    assert (compact);
+    assert (task);
     assert (file);
+    assert (stack);
 
     static size_t ifCounter = 0;
 
-    fprintf (file, "; if\n");
+    const compactNode_t *node = &compact->nodes.data[task->node];
 
-    TREE_DO_AND_RETURN (AssembleNode (program, node->left, file));
+    switch (task->step)
+    {
+        case ASSEMBLE_NODE:
+        {
+            size_t label = ifCounter++;
 
-    fprintf (file, "PUSH 0\n"
-                   "JE :endif_%lu\n", ifCounter);
-    
-    TREE_DO_AND_RETURN (AssembleNode (program, node->right, file));
+            fprintf (file, "; if\n");
 
-    fprintf (file, ":endif_%lu\n\n", ifCounter);
+            TREE_DO_AND_RETURN (AssembleLater (program, stack, task->node,  ASSEMBLE_IF_END,  label));
+            TREE_DO_AND_RETURN (AssembleLater (program, stack, node->right, ASSEMBLE_NODE,    0));
+            TREE_DO_AND_RETURN (AssembleLater (program, stack, task->node,  ASSEMBLE_IF_JUMP, label));
+            TREE_DO_AND_RETURN (AssembleLater (program, stack, node->left,  ASSEMBLE_NODE,    0));
 
-    ifCounter++;
+            break;
+        }
+
+        case ASSEMBLE_IF_JUMP:
+            fprintf (file, "PUSH 0\n"
+                           "JE :endif_%lu\n", task->label);
+            break;
+
+        case ASSEMBLE_IF_END:
+            fprintf (file, ":endif_%lu\n\n", task->label);
+            break;
+
+        case ASSEMBLE_KEYWORD_END:
+        default:
+            assert (0 && "Wrong step of if");
+            break;
+    }
 
     return TREE_OK;
-}
\ No newline at end of file
+}
+
+// Block stays on the stack only until its last statement, so stack grows
+// with nesting of blocks, not with their length
+int AssembleBlock (program_t *program, compactTree_t *compact,
+                   const assembleTask_t *task, assembleStack_t *stack)
+{
+    assert (program);
+    assert (compact);
+    assert (task);
+    assert (stack);
+    assert (compact->nodes.data[task->node].kind == TYPE_BLOCK);
+
+    size_t size = CompactNodeChildrenCount (compact, task->node);
+
+    if (task->statement >= size)
+        return TREE_OK;
+
+    if (task->statement + 1 < size)
+        TREE_DO_AND_RETURN (TreeStackPush (&program->ast, stack, {.node      = task->node,
+                                                                  .step      = ASSEMBLE_NODE,
+                                                                  .label     = 0,
+                                                                  .statement = task->statement + 1}));
+
+    return AssembleLater (program, stack, *CompactNodeChild (compact, task->node, task->statement),
+                          ASSEMBLE_NODE, 0);
+}
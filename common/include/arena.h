@@ -0,0 +1,38 @@
+/*
+    Bump allocator: memory is taken from big blocks and is freed
+    only all together in ArenaDtor ()
+*/
+
+#ifndef K_ARENA_H
+#define K_ARENA_H
+
+#include <stdio.h>
+
+struct arenaBlock_t
+{
+    arenaBlock_t *next = NULL;
+
+    size_t size = 0;
+    size_t used = 0;
+
+    char *data = NULL; // points right after this header
+};
+
+struct arena_t
+{
+    arenaBlock_t *head = NULL;
+
+    size_t blockSize = 0;
+
+    size_t blocksCount = 0;
+    size_t bytesUsed   = 0;
+};
+
+const size_t kArenaDefaultBlockSize = 64 * 1024;
+
+void ArenaCtor      (arena_t *arena, size_t blockSize);
+void ArenaDtor      (arena_t *arena);
+void *ArenaAlloc    (arena_t *arena, size_t size, size_t align);
+char *ArenaStrDup   (arena_t *arena, const char *str, size_t len);
+
+#endif // K_ARENA_H
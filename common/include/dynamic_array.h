@@ -0,0 +1,238 @@
+/*
+    Growable array, header-only.
+    All containers (tokens, names table, stack, symbol table) get memory through
+    DynamicArrayGrowCapacity () and DynamicArrayRealloc (), so allocation policy
+    is tuned here. Trivially copyable elements are moved with realloc (),
+    others are move-constructed into new memory
+*/
+
+#ifndef K_DYNAMIC_ARRAY_H
+#define K_DYNAMIC_ARRAY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "debug.h"
+
+const size_t kDynamicArrayMinCapacity = 16;
+const size_t kDynamicArrayGrowFactor  = 2;
+
+template <typename T>
+struct dynamicArray_t
+{
+    T *data = NULL;
+
+    size_t size = 0;
+    size_t capacity = 0;
+};
+
+// capacity to grow to, so that at least `needed` elements fit
+inline size_t DynamicArrayGrowCapacity (size_t capacity, size_t needed)
+{
+    if (capacity < kDynamicArrayMinCapacity)
+        capacity = kDynamicArrayMinCapacity;
+
+    while (capacity < needed)
+        capacity *= kDynamicArrayGrowFactor;
+
+    return capacity;
+}
+
+// Moves first `size` elements to memory for newCapacity elements.
+// Returns NULL on error, old memory stays valid then
+template <typename T>
+T *DynamicArrayRealloc (T *data, size_t size, size_t newCapacity)
+{
+    assert (size <= newCapacity);
+    assert (newCapacity > 0);
+
+    if (newCapacity > SIZE_MAX / sizeof (T))
+        return NULL;
+
+    if constexpr (std::is_trivially_copyable <T>::value)
+    {
+        return (T *) realloc (data, newCapacity * sizeof (T));
+    }
+    else
+    {
+        T *newData = (T *) malloc (newCapacity * sizeof (T));
+        if (newData == NULL)
+            return NULL;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            new (newData + i) T (std::move (data[i]));
+            data[i].~T ();
+        }
+
+        free (data);
+
+        return newData;
+    }
+}
+
+template <typename T>
+int DynamicArrayReserve (dynamicArray_t <T> *array, size_t capacity)
+{
+    assert (array);
+
+    if (capacity <= array->capacity)
+        return COMMON_ERROR_OK;
+
+    T *newData = DynamicArrayRealloc (array->data, array->size, capacity);
+    if (newData == NULL)
+    {
+        ERROR_LOG ("Error reallocating memory for %lu elements - %s", capacity, strerror (errno));
+
+        return COMMON_ERROR_REALLOCATING_MEMORY;
+    }
+
+    array->data     = newData;
+    array->capacity = capacity;
+
+    return COMMON_ERROR_OK;
+}
+
+// capacityHint is a guess of final size (e.g. from file size), it can be 0
+template <typename T>
+int DynamicArrayCtor (dynamicArray_t <T> *array, size_t capacityHint)
+{
+    assert (array);
+
+    array->data     = NULL;
+    array->size     = 0;
+    array->capacity = 0;
+
+    if (capacityHint == 0)
+        return COMMON_ERROR_OK;
+
+    return DynamicArrayReserve (array, capacityHint);
+}
+
+template <typename T>
+void DynamicArrayDtor (dynamicArray_t <T> *array)
+{
+    assert (array);
+
+    if constexpr (!std::is_trivially_destructible <T>::value)
+    {
+        for (size_t i = 0; i < array->size; i++)
+            array->data[i].~T ();
+    }
+
+    free (array->data);
+
+    array->data     = NULL;
+    array->size     = 0;
+    array->capacity = 0;
+}
+
+template <typename T, typename U>
+int DynamicArrayPush (dynamicArray_t <T> *array, U &&value)
+{
+    assert (array);
+
+    if (array->size == array->capacity)
+    {
+        int status = DynamicArrayReserve (array, DynamicArrayGrowCapacity (array->capacity,
+                                                                           array->size + 1));
+        if (status != COMMON_ERROR_OK)
+            return status;
+    }
+
+    new (array->data + array->size) T (std::forward <U> (value));
+    array->size++;
+
+    return COMMON_ERROR_OK;
+}
+
+// Adds value-initialized element and gives pointer to it in *slot, so caller can fill
+// it in place. For small structs it's faster than DynamicArrayPush () of a temporary
+template <typename T>
+int DynamicArrayAppend (dynamicArray_t <T> *array, T **slot)
+{
+    assert (array);
+    assert (slot);
+
+    if (array->size == array->capacity)
+    {
+        int status = DynamicArrayReserve (array, DynamicArrayGrowCapacity (array->capacity,
+                                                                           array->size + 1));
+        if (status != COMMON_ERROR_OK)
+            return status;
+    }
+
+    *slot = new (array->data + array->size) T ();
+    array->size++;
+
+    return COMMON_ERROR_OK;
+}
+
+// new elements are value-initialized
+template <typename T>
+int DynamicArrayResize (dynamicArray_t <T> *array, size_t size)
+{
+    assert (array);
+
+    if (size > array->capacity)
+    {
+        int status = DynamicArrayReserve (array, DynamicArrayGrowCapacity (array->capacity, size));
+        if (status != COMMON_ERROR_OK)
+            return status;
+    }
+
+    for (size_t i = array->size; i < size; i++)
+        new (array->data + i) T ();
+
+    if constexpr (!std::is_trivially_destructible <T>::value)
+    {
+        for (size_t i = size; i < array->size; i++)
+            array->data[i].~T ();
+    }
+
+    array->size = size;
+
+    return COMMON_ERROR_OK;
+}
+
+template <typename T>
+int DynamicArrayShrinkToFit (dynamicArray_t <T> *array)
+{
+    assert (array);
+
+    if (array->size == array->capacity)
+        return COMMON_ERROR_OK;
+
+    if (array->size == 0)
+    {
+        free (array->data);
+
+        array->data     = NULL;
+        array->capacity = 0;
+
+        return COMMON_ERROR_OK;
+    }
+
+    T *newData = DynamicArrayRealloc (array->data, array->size, array->size);
+    if (newData == NULL)
+    {
+        ERROR_LOG ("Error reallocating memory for %lu elements - %s", array->size, strerror (errno));
+
+        return COMMON_ERROR_REALLOCATING_MEMORY;
+    }
+
+    array->data     = newData;
+    array->capacity = array->size;
+
+    return COMMON_ERROR_OK;
+}
+
+#endif // K_DYNAMIC_ARRAY_H
@@ -0,0 +1,130 @@
+/*
+    Keyword trie, generated at compile time from kKeywords[].
+    Trie works on raw UTF-8 bytes, lexer DFA (lexer_dfa.h) is built from it.
+    Trie of standard names is for save files (see FindKeywordByStandardName ()).
+*/
+
+#ifndef K_KEYWORD_TRIE_H
+#define K_KEYWORD_TRIE_H
+
+#include <stdio.h>
+
+#include "tree_ast.h"
+
+const int kKeywordTrieNoNode = -1;
+
+struct keywordTrieNode_t
+{
+    unsigned char byte  = 0;
+
+    int firstChild      = kKeywordTrieNoNode;
+    int nextSibling     = kKeywordTrieNoNode;
+
+    int keyword         = kKeywordTrieNoNode; // index in kKeywords[], if some keyword ends here
+};
+
+// What keywords are looked for by
+enum keywordTrieKey_t
+{
+    KEYWORD_TRIE_NAME,              // in source
+    KEYWORD_TRIE_STANDARD_NAME,     // in save file
+};
+
+constexpr const char *KeywordTrieKey (size_t keyword, keywordTrieKey_t key)
+{
+    return (key == KEYWORD_TRIE_NAME) ? kKeywords[keyword].name : kKeywords[keyword].standardName;
+}
+
+constexpr size_t KeywordTrieKeyLen (size_t keyword, keywordTrieKey_t key)
+{
+    return (key == KEYWORD_TRIE_NAME) ? kKeywords[keyword].nameLen : kKeywords[keyword].standardNameLen;
+}
+
+constexpr size_t KeywordTrieCountNodes (keywordTrieKey_t key)
+{
+    size_t nodesCount = 1; // root
+
+    for (size_t i = 0; i < kNumberOfKeywords; i++)
+        nodesCount += KeywordTrieKeyLen (i, key);
+
+    return nodesCount;
+}
+
+constexpr size_t KeywordTrieMaxNodes ()
+{
+    size_t names         = KeywordTrieCountNodes (KEYWORD_TRIE_NAME);
+    size_t standardNames = KeywordTrieCountNodes (KEYWORD_TRIE_STANDARD_NAME);
+
+    return (names > standardNames) ? names : standardNames;
+}
+
+const size_t kKeywordTrieMaxNodes = KeywordTrieMaxNodes ();
+
+struct keywordTrie_t
+{
+    keywordTrieNode_t nodes[kKeywordTrieMaxNodes] = {};
+
+    size_t size = 0;
+};
+
+constexpr keywordTrie_t KeywordTrieBuild (keywordTrieKey_t key = KEYWORD_TRIE_NAME)
+{
+    keywordTrie_t trie = {};
+    trie.size = 1;
+
+    for (size_t i = 0; i < kNumberOfKeywords; i++)
+    {
+        int cur = 0;
+
+        const char *keyword = KeywordTrieKey (i, key);
+
+        for (size_t j = 0; j < KeywordTrieKeyLen (i, key); j++)
+        {
+            unsigned char byte = (unsigned char) keyword[j];
+
+            int child = trie.nodes[cur].firstChild;
+            while (child != kKeywordTrieNoNode && trie.nodes[child].byte != byte)
+                child = trie.nodes[child].nextSibling;
+
+            if (child == kKeywordTrieNoNode)
+            {
+                child = (int) trie.size;
+                trie.size++;
+
+                trie.nodes[child].byte        = byte;
+                trie.nodes[child].nextSibling = trie.nodes[cur].firstChild;
+                trie.nodes[cur].firstChild    = child;
+            }
+
+            cur = child;
+        }
+
+        // first one wins, like it was with linear search (all these "TODO"s)
+        if (trie.nodes[cur].keyword == kKeywordTrieNoNode)
+            trie.nodes[cur].keyword = (int) i;
+    }
+
+    return trie;
+}
+
+// index in kKeywords[] of keyword, that is exactly str of len bytes, or kKeywordTrieNoNode
+inline int KeywordTrieFind (const keywordTrie_t *trie, const char *str, size_t len)
+{
+    int cur = 0;
+
+    for (size_t i = 0; i < len && cur != kKeywordTrieNoNode; i++)
+    {
+        int child = trie->nodes[cur].firstChild;
+        while (child != kKeywordTrieNoNode && trie->nodes[child].byte != (unsigned char) str[i])
+            child = trie->nodes[child].nextSibling;
+
+        cur = child;
+    }
+
+    if (cur == kKeywordTrieNoNode)
+        return kKeywordTrieNoNode;
+
+    return trie->nodes[cur].keyword;
+}
+
+#endif // K_KEYWORD_TRIE_H
@@ -0,0 +1,316 @@
+/*
+    Lexer DFA, generated at compile time from kKeywords[]. One transition per source byte
+    recognizes whitespace, numbers, names and keywords, so adding a keyword only adds
+    states to the table and doesn't make lexing slower.
+    Token is the longest accepted prefix; if keyword and name have the same length,
+    keyword wins. So "TODO" is a keyword, but "TODO_list" is a name, like it was with trie.
+    Once DFA knows that it is a name and not a keyword, rest of the name is scanned with SIMD.
+*/
+
+#ifndef K_LEXER_DFA_H
+#define K_LEXER_DFA_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "tree_ast.h"
+#include "keyword_trie.h"
+#include "simd_scan.h"
+
+enum lexerDfaStates_t
+{
+    LEXER_DFA_DEAD,
+    LEXER_DFA_SPACE,
+    LEXER_DFA_INTEGER,
+    LEXER_DFA_DOT,          // "1." - not accepted without digits after the dot
+    LEXER_DFA_FRACTION,
+    LEXER_DFA_NAME,         // name, that isn't a beginning of some keyword
+    LEXER_DFA_TRIE,         // trie node i is state LEXER_DFA_TRIE + i, root is the start
+};
+
+const uint16_t kLexerDfaStart = LEXER_DFA_TRIE;
+
+// what is accepted in state: one of these or kLexerDfaAcceptKeyword + index in kKeywords[]
+enum lexerDfaAccept_t
+{
+    LEXER_DFA_ACCEPT_NONE,
+    LEXER_DFA_ACCEPT_SPACE,
+    LEXER_DFA_ACCEPT_NUMBER,
+    LEXER_DFA_ACCEPT_NAME,
+};
+
+const uint8_t kLexerDfaAcceptKeyword = 4;
+
+static_assert (kLexerDfaAcceptKeyword + kNumberOfKeywords <= UINT8_MAX,
+               "keyword indexes should fit in lexerDfa_t::accept");
+
+constexpr bool LexerDfaIsSpace (unsigned char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+constexpr bool LexerDfaIsDigit (unsigned char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool LexerDfaIsNameStart (unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+constexpr bool LexerDfaIsNameChar (unsigned char c)
+{
+    return LexerDfaIsNameStart (c) || LexerDfaIsDigit (c);
+}
+
+constexpr bool LexerDfaIsKeywordByte (unsigned char c)
+{
+    for (size_t i = 0; i < kNumberOfKeywords; i++)
+    {
+        for (size_t j = 0; j < kKeywords[i].nameLen; j++)
+        {
+            if ((unsigned char) kKeywords[i].name[j] == c)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// Bytes of keywords get a class each, all the others are split by what they can be in token
+enum lexerDfaByteKinds_t
+{
+    LEXER_DFA_BYTE_OTHER,   // '\0' is here, nothing goes from it
+    LEXER_DFA_BYTE_SPACE,
+    LEXER_DFA_BYTE_DIGIT,
+    LEXER_DFA_BYTE_NAME,
+    LEXER_DFA_BYTE_DOT,
+
+    LEXER_DFA_BYTE_KINDS_COUNT
+};
+
+constexpr lexerDfaByteKinds_t LexerDfaByteKind (unsigned char c)
+{
+    if (LexerDfaIsSpace (c))     return LEXER_DFA_BYTE_SPACE;
+    if (LexerDfaIsDigit (c))     return LEXER_DFA_BYTE_DIGIT;
+    if (LexerDfaIsNameChar (c))  return LEXER_DFA_BYTE_NAME;
+    if (c == '.')                return LEXER_DFA_BYTE_DOT;
+
+    return LEXER_DFA_BYTE_OTHER;
+}
+
+constexpr size_t LexerDfaCountClasses ()
+{
+    size_t classesCount = LEXER_DFA_BYTE_KINDS_COUNT;
+
+    for (size_t c = 0; c <= UINT8_MAX; c++)
+    {
+        if (LexerDfaIsKeywordByte ((unsigned char) c))
+            classesCount++;
+    }
+
+    return classesCount;
+}
+
+const size_t kLexerDfaClassesCount  = LexerDfaCountClasses ();
+const size_t kLexerDfaStatesCount   = LEXER_DFA_TRIE + kKeywordTrieMaxNodes;
+
+static_assert (kLexerDfaStatesCount <= UINT16_MAX, "states should fit in lexerDfa_t::next");
+
+constexpr bool KeywordsFitLexerDfa ()
+{
+    for (size_t i = 0; i < kNumberOfKeywords; i++)
+    {
+        const char *name = kKeywords[i].name;
+        size_t len       = kKeywords[i].nameLen;
+
+        if (len == 0)
+            return false;
+
+        unsigned char first = (unsigned char) name[0];
+        unsigned char last  = (unsigned char) name[len - 1];
+
+        // numbers and whitespace aren't looked for in the trie
+        if (LexerDfaIsDigit (first) || LexerDfaIsSpace (first) || first == '.')
+            return false;
+
+        // keyword is cut from a name only if it ends with not a name char, or it's a name itself
+        if (!LexerDfaIsNameChar (last))
+            continue;
+
+        if (!LexerDfaIsNameStart (first))
+            return false;
+
+        for (size_t j = 0; j < len; j++)
+        {
+            if (!LexerDfaIsNameChar ((unsigned char) name[j]))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert (KeywordsFitLexerDfa (),
+               "keyword starts like a number, or ends with a name char, but isn't a name");
+
+struct lexerDfa_t
+{
+    uint8_t  classes [UINT8_MAX + 1] = {};
+
+    uint16_t next    [kLexerDfaStatesCount][kLexerDfaClassesCount] = {};
+    uint8_t  accept  [kLexerDfaStatesCount] = {};
+};
+
+constexpr lexerDfa_t LexerDfaBuild ()
+{
+    lexerDfa_t dfa = {};
+
+    const keywordTrie_t trie = KeywordTrieBuild ();
+
+    // some byte of every class, transitions are made by it
+    unsigned char classBytes[kLexerDfaClassesCount] = {};
+
+    size_t classesCount = LEXER_DFA_BYTE_KINDS_COUNT;
+
+    for (size_t c = 0; c <= UINT8_MAX; c++)
+    {
+        unsigned char byte = (unsigned char) c;
+
+        if (LexerDfaIsKeywordByte (byte))
+        {
+            dfa.classes[c] = (uint8_t) classesCount;
+            classesCount++;
+        }
+        else
+        {
+            dfa.classes[c] = (uint8_t) LexerDfaByteKind (byte);
+        }
+
+        classBytes[dfa.classes[c]] = byte;
+    }
+
+    // trie node path is a name, e.g. "TO" of "TODO". Children are added to trie after
+    // parents, so parent is always marked before its children
+    bool isNamePath[kKeywordTrieMaxNodes] = {};
+
+    for (size_t node = 0; node < trie.size; node++)
+    {
+        for (int child = trie.nodes[node].firstChild; child != kKeywordTrieNoNode; 
+             child = trie.nodes[child].nextSibling)
+        {
+            unsigned char byte = trie.nodes[child].byte;
+
+            isNamePath[child] = (node == 0) ? LexerDfaIsNameStart (byte) :
+                                              isNamePath[node] && LexerDfaIsNameChar (byte);
+        }
+    }
+
+    for (size_t cls = 0; cls < kLexerDfaClassesCount; cls++)
+    {
+        unsigned char byte = classBytes[cls];
+
+        if (LexerDfaIsSpace (byte))
+            dfa.next[LEXER_DFA_SPACE][cls]    = LEXER_DFA_SPACE;
+
+        if (LexerDfaIsDigit (byte))
+        {
+            dfa.next[LEXER_DFA_INTEGER][cls]  = LEXER_DFA_INTEGER;
+            dfa.next[LEXER_DFA_DOT][cls]      = LEXER_DFA_FRACTION;
+            dfa.next[LEXER_DFA_FRACTION][cls] = LEXER_DFA_FRACTION;
+        }
+
+        if (byte == '.')
+            dfa.next[LEXER_DFA_INTEGER][cls]  = LEXER_DFA_DOT;
+
+        if (LexerDfaIsNameChar (byte))
+            dfa.next[LEXER_DFA_NAME][cls]     = LEXER_DFA_NAME;
+
+        for (size_t node = 0; node < trie.size; node++)
+        {
+            uint16_t state = (uint16_t) (LEXER_DFA_TRIE + node);
+
+            int child = trie.nodes[node].firstChild;
+            while (child != kKeywordTrieNoNode && trie.nodes[child].byte != byte)
+                child = trie.nodes[child].nextSibling;
+
+            bool isRoot = (node == 0);
+
+            if (child != kKeywordTrieNoNode)
+            {
+                dfa.next[state][cls] = (uint16_t) (LEXER_DFA_TRIE + child);
+            }
+            else if (isRoot)
+            {
+                if      (LexerDfaIsSpace     (byte))   dfa.next[state][cls] = LEXER_DFA_SPACE;
+                else if (LexerDfaIsDigit     (byte))   dfa.next[state][cls] = LEXER_DFA_INTEGER;
+                else if (LexerDfaIsNameStart (byte))   dfa.next[state][cls] = LEXER_DFA_NAME;
+            }
+            else if (isNamePath[node] && LexerDfaIsNameChar (byte))
+            {
+                dfa.next[state][cls] = LEXER_DFA_NAME;
+            }
+        }
+    }
+
+    dfa.accept[LEXER_DFA_SPACE]    = LEXER_DFA_ACCEPT_SPACE;
+    dfa.accept[LEXER_DFA_INTEGER]  = LEXER_DFA_ACCEPT_NUMBER;
+    dfa.accept[LEXER_DFA_FRACTION] = LEXER_DFA_ACCEPT_NUMBER;
+    dfa.accept[LEXER_DFA_NAME]     = LEXER_DFA_ACCEPT_NAME;
+
+    for (size_t node = 1; node < trie.size; node++)
+    {
+        if (trie.nodes[node].keyword != kKeywordTrieNoNode)
+            dfa.accept[LEXER_DFA_TRIE + node] = (uint8_t) (kLexerDfaAcceptKeyword +
+                                                           trie.nodes[node].keyword);
+        else if (isNamePath[node])
+            dfa.accept[LEXER_DFA_TRIE + node] = LEXER_DFA_ACCEPT_NAME;
+    }
+
+    return dfa;
+}
+
+extern const lexerDfa_t kLexerDfa;
+
+// Length of the longest token at str, *accept is what it is (LEXER_DFA_ACCEPT_NONE and 0
+// if no token begins here). Runs until the dead state, '\0' always leads to it
+inline size_t LexerDfaMatch (const char *str, uint8_t *accept)
+{
+    assert (str);
+    assert (accept);
+
+    const unsigned char *pos = (const unsigned char *) str;
+
+    uint16_t state = kLexerDfaStart;
+
+    size_t  matchLen    = 0;
+    uint8_t matchAccept = LEXER_DFA_ACCEPT_NONE;
+
+    for (size_t i = 0; ; i++)
+    {
+        state = kLexerDfa.next[state][kLexerDfa.classes[pos[i]]];
+
+        if (state == LEXER_DFA_DEAD)
+            break;
+
+        if (state == LEXER_DFA_NAME)
+        {
+            *accept = LEXER_DFA_ACCEPT_NAME;
+            return i + ScanName (str + i);
+        }
+
+        if (kLexerDfa.accept[state] != LEXER_DFA_ACCEPT_NONE)
+        {
+            matchLen    = i + 1;
+            matchAccept = kLexerDfa.accept[state];
+        }
+    }
+
+    *accept = matchAccept;
+
+    return matchLen;
+}
+
+#endif // K_LEXER_DFA_H
@@ -0,0 +1,30 @@
+/*
+    Scanning of character runs for lexers: whitespace, names and newlines.
+    SSE2 and AVX2 kernels are chosen once at startup with __builtin_cpu_supports (),
+    other CPUs get scalar ones. Build flags:
+        -D SCAN_NO_AVX2     - SSE2 kernels at most
+        -D SCAN_NO_SIMD     - scalar kernels only
+    Kernels read whole aligned 16/32 byte blocks, so they can look a bit before str
+    and after the terminating '\0', but never cross a page boundary
+*/
+
+#ifndef K_SIMD_SCAN_H
+#define K_SIMD_SCAN_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// length of whitespace run at str (same characters as isspace () in "C" locale)
+size_t ScanSpaces           (const char *str);
+// length of [A-Za-z0-9_] run at str
+size_t ScanName             (const char *str);
+
+size_t ScanCountNewLines    (const char *buffer, size_t len);
+// offset of the byte after every '\n' is written to lineStarts, returns number of them.
+// lineStarts must fit ScanCountNewLines (buffer, len) elements, len must be < UINT32_MAX
+size_t ScanNewLines         (const char *buffer, size_t len, uint32_t *lineStarts);
+
+// "avx2", "sse2" or "scalar"
+const char *ScanKernelsName ();
+
+#endif // K_SIMD_SCAN_H
@@ -1,3 +1,12 @@
+/*
+    Stack checks depend on build flags:
+        -D PRINT_DEBUG          - unused part of data is poisoned; every operation checks
+                                  only cells near the top, whole data is checked once
+                                  per capacity operations (O(1) amortized)
+        -D STACK_FULL_VERIFY    - whole data is checked on every operation (O(capacity))
+        -D STACK_RELEASE        - no poison and no checks even with PRINT_DEBUG
+*/
+
 #ifndef K_STACK_H
 #define K_STACK_H
 
@@ -11,6 +20,10 @@ const char * const stackDataTypeStr = "size_t";
 const stackDataType CANARY = (stackDataType) 0xEDAc0ffe;
 const stackDataType POISON = 1337228272;
 
+#if defined (PRINT_DEBUG) && !defined (STACK_RELEASE)
+    #define STACK_POISON_CHECK
+#endif // PRINT_DEBUG && !STACK_RELEASE
+
 #ifdef PRINT_DEBUG
     #define STACK_DUMP(stackName, comment) StackDump (&stackName, comment, __FILE__, __LINE__, __func__)
 
@@ -19,13 +32,17 @@ const stackDataType POISON = 1337228272;
                                                                .file = __FILE__,             \
                                                                .line = __LINE__,             \
                                                                .func = __func__})
-    #define STACK_ERROR(stack) StackError (stack)
 #else
     #define STACK_DUMP(stack, comment) 
     #define STACK_CREATE(stackName, size) StackCtor (&stackName, size)
-    #define STACK_ERROR(stack) STACK_OK
 #endif // PRINT_DEBUG
 
+#ifdef STACK_POISON_CHECK
+    #define STACK_ERROR(stack) StackVerify (stack)
+#else
+    #define STACK_ERROR(stack) STACK_OK
+#endif // STACK_POISON_CHECK
+
 struct stack_t 
 {
 #ifdef STACK_CANARY
@@ -40,6 +57,10 @@ struct stack_t
     varInfo_t varInfo;
 #endif // PRINT_DEBUG
 
+#ifdef STACK_POISON_CHECK
+    size_t operationsCount;
+#endif // STACK_POISON_CHECK
+
 #ifdef STACK_CANARY
     stackDataType canaryEnd = (stackDataType) CANARY;
 #endif // STACK_CANARY
@@ -64,6 +85,7 @@ enum stackErrors
 
 void StackPrintError (int error);
 int StackError (stack_t *stack);
+int StackVerify (stack_t *stack);
 int StackCtor (stack_t *stack, size_t capacity
                ON_DEBUG(, varInfo_t varInfo));
 int StackPush (stack_t *stack, stackDataType value);
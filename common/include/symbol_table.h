@@ -0,0 +1,31 @@
+/*
+    Set of declared names with nested scopes.
+    Names have dense ids (see namesTable_t), so id itself is a perfect hash:
+    membership test is one lookup in array indexed by id
+*/
+
+#ifndef K_SYMBOL_TABLE_H
+#define K_SYMBOL_TABLE_H
+
+#include <stdio.h>
+
+#include "stack.h"
+#include "dynamic_array.h"
+
+struct symbolTable_t
+{
+    dynamicArray_t <bool> isDeclared = {}; // [name idx]
+
+    stack_t declared                 = {}; // names in order of declaration
+    stack_t scopeStarts              = {}; // declared.size at the moment scope was opened
+};
+
+int SymbolTableCtor         (symbolTable_t *table);
+void SymbolTableDtor        (symbolTable_t *table);
+bool SymbolTableIsDeclared  (symbolTable_t *table, size_t nameIdx);
+int SymbolTableDeclare      (symbolTable_t *table, size_t nameIdx);
+int SymbolTablePushScope    (symbolTable_t *table);
+int SymbolTablePopScope     (symbolTable_t *table);
+int SymbolTableTruncate     (symbolTable_t *table, size_t declaredCount);
+
+#endif // K_SYMBOL_TABLE_H
@@ -0,0 +1,41 @@
+/*
+    Fixed set of worker threads for data-parallel loops.
+    ThreadPoolRun () calls task (arg, i) for every i in [0, tasksCount) and returns
+    when all of them are done. Tasks are taken in order from a shared counter,
+    so chunks of different cost are balanced. Calling thread takes tasks too
+*/
+
+#ifndef K_THREAD_POOL_H
+#define K_THREAD_POOL_H
+
+#include <stdio.h>
+#include <pthread.h>
+
+typedef void (*threadPoolTask_t) (void *arg, size_t taskIdx);
+
+struct threadPool_t
+{
+    pthread_t *workers  = NULL;
+    size_t workersCount = 0;
+
+    pthread_mutex_t mutex   = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t  hasWork = PTHREAD_COND_INITIALIZER;
+    pthread_cond_t  allDone = PTHREAD_COND_INITIALIZER;
+
+    // current loop, guarded by mutex
+    threadPoolTask_t task   = NULL;
+    void *taskArg           = NULL;
+    size_t tasksCount       = 0;
+    size_t nextTask         = 0;
+    size_t doneTasks        = 0;
+
+    bool isStopping         = false;
+};
+
+// threadsCount includes calling thread, so 1 means no workers at all
+int ThreadPoolCtor  (threadPool_t *pool, size_t threadsCount);
+void ThreadPoolDtor (threadPool_t *pool);
+
+void ThreadPoolRun  (threadPool_t *pool, threadPoolTask_t task, void *arg, size_t tasksCount);
+
+#endif // K_THREAD_POOL_H
@@ -1,14 +1,123 @@
 #ifndef K_TOKENIZATOR_H
 #define K_TOKENIZATOR_H
 
+#include <stdio.h>
+#include <assert.h>
+
 #include "tree_ast.h"
 
-int GetTokens (const char *fileName, program_t *program);
+// parser looks at most one token ahead, so a few last tokens are enough
+const size_t kTokensStreamWindow        = 8;
+const size_t kTokensStreamBlockSize     = 64 * 1024;
+
+// Source is read by fixed size blocks. Token is lexed only when whole of it is in
+// the block (there is whitespace after it or file is over), otherwise not lexed tail
+// is moved to the block beginning and the next part of file is read after it
+struct tokenStream_t
+{
+    FILE *file          = NULL;
+
+    char *block         = NULL;     // blockSize bytes + '\0'
+    size_t blockSize    = 0;        // grows only if some token doesn't fit in it
+
+    char *curPos        = NULL;
+    char *dataEnd       = NULL;     // *dataEnd == '\0'
+    char *lastSpace     = NULL;     // last whitespace in block, tokens before it are whole
+    size_t blockOffset  = 0;        // of block[0] in source
+
+    bool isEof          = false;    // file is read to the end
+    bool isEnd          = false;    // no more tokens: end of source or error
+    int status          = TREE_OK;
+
+    size_t line         = 1;        // position of curPos, column is in UTF-8 characters
+    size_t column       = 1;
+
+    size_t tokenLines   [kTokensStreamWindow] = {};
+    size_t tokenColumns [kTokensStreamWindow] = {};
+
+    namesTable_t *namesTable = NULL; // new names are copied to program->names,
+                                     // block is overwritten
+};
+
+// Bytes [begin, end) of source are replaced by text
+struct sourceEdit_t
+{
+    size_t begin        = 0;
+    size_t end          = 0;
+
+    const char *text    = NULL; // not in the source itself
+    size_t textLen      = 0;
+};
+
+// Tokens [first, oldEnd) were replaced by [first, newEnd), others are the same (but can be moved)
+struct tokensEdit_t
+{
+    size_t first    = 0;
+    size_t oldEnd   = 0;
+    size_t newEnd   = 0;
+};
+
+int GetTokens (const char *fileName, program_t *program, size_t threadsCount);
+int GetTokensAfterEdit (program_t *program, const sourceEdit_t *edit, tokensEdit_t *tokensEdit);
+int TokenStreamOpen (const char *fileName, program_t *program, size_t blockSize);
+int TokenStreamPull (tokensArray_t *tokens, size_t tokenIdx);
 
 int TokensArrayCtor (tokensArray_t *tokens);
 void TokensArrayDtor (tokensArray_t *tokens);
+int TokensArrayReserve (tokensArray_t *tokens, size_t capacity);
+int TokenAdd (tokensArray_t *tokens, type_t type, value_t value, uint32_t offset);
+
+int FillTokensArray (char *buffer, char *begin, char *end,
+                     tokensArray_t *tokens, namesTable_t *namesTable);
+
+void TokensFindLineAndColumn (tokensArray_t *tokens, size_t offset,   size_t *line, size_t *column);
+void TokenGetLineAndColumn   (tokensArray_t *tokens, size_t tokenIdx, size_t *line, size_t *column);
 
 void DumpTokens    (program_t *program);
-int PrintToken (FILE *file, program_t *program, token_t *token);
+int PrintToken (FILE *file, program_t *program, size_t tokenIdx);
+
+// index of the first token, that is still kept
+inline size_t TokensFirstKept (const tokensArray_t *tokens)
+{
+    if (tokens->stream == NULL || tokens->size <= kTokensStreamWindow)
+        return 0;
+
+    return tokens->size - kTokensStreamWindow;
+}
+
+inline size_t TokenSlot (const tokensArray_t *tokens, size_t tokenIdx)
+{
+    assert (tokenIdx >= TokensFirstKept (tokens));
+
+    if (tokens->stream == NULL)
+        return tokenIdx;
+
+    return tokenIdx % kTokensStreamWindow;
+}
+
+// false if there is no token tokenIdx. Stream is lexed up to it
+inline bool TokensHave (tokensArray_t *tokens, size_t tokenIdx)
+{
+    if (tokenIdx < tokens->size)
+        return true;
+
+    return tokens->stream != NULL && TokenStreamPull (tokens, tokenIdx) == TREE_OK &&
+           tokenIdx < tokens->size;
+}
+
+inline type_t TokenType (const tokensArray_t *tokens, size_t tokenIdx)
+{
+    return (type_t) tokens->kinds[TokenSlot (tokens, tokenIdx)];
+}
+
+inline value_t TokenValue (const tokensArray_t *tokens, size_t tokenIdx)
+{
+    size_t slot = TokenSlot (tokens, tokenIdx);
+
+    if (tokens->kinds[slot] == TYPE_CONST_NUM)
+        return {.number = (valueNumber_t) tokens->payloads[slot]};
+
+    return {.idx = tokens->payloads[slot]};
+}
 
 #endif // K_TOKENIZATOR
\ No newline at end of file
@@ -2,9 +2,12 @@
 #define K_TREE_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
 
 #include "tree_log.h"
 #include "debug.h"
+#include "arena.h"
 
 typedef union value_t treeDataType;
 
@@ -35,6 +38,36 @@ const char ktreeSaveFileName[]       = "ast_forest/tree.ast";
             }                                       \
         } while (0)
 
+// for main (): statuses are bit masks and don't fit in exit code, so it is 1 on error
+#define MAIN_DO_AND_CLEAR(action, clearAction)                          \
+        do                                                              \
+        {                                                               \
+            int statusMacro = action;                                   \
+            DEBUG_VAR("%d", statusMacro);                               \
+                                                                        \
+            if (statusMacro != TREE_OK)                                 \
+            {                                                           \
+                clearAction;                                            \
+                                                                        \
+                DEBUG_VAR("%d", statusMacro);                           \
+                ERROR_PRINT ("%s", "Error occured in \"" #action "\""); \
+                return 1;                                               \
+            }                                                           \
+        } while (0)
+
+#define MAIN_DO_AND_RETURN(action)                                      \
+        do                                                              \
+        {                                                               \
+            int statusMacro = action;                                   \
+            DEBUG_VAR("%d", statusMacro);                               \
+                                                                        \
+            if (statusMacro != TREE_OK)                                 \
+            {                                                           \
+                ERROR_PRINT ("%s", "Error occured in \"" #action "\""); \
+                return 1;                                               \
+            }                                                           \
+        } while (0)
+
 #define NODE_CTOR(tree, node)                       \
         node = NodeCtor (tree);                     \
         if (node == NULL)                           \
@@ -77,20 +110,27 @@ enum type_t // NOTE: maybe move to tree_ast.h
     TYPE_KEYWORD,
     TYPE_VARIABLE, // FIXME: maybe remove
     TYPE_NAME,
+    TYPE_BLOCK,    // statements are in value.block, left and right are NULL
 };
 
 typedef int valueNumber_t;
 #define VALUE_NUMBER_FSTRING "%d"
+const valueNumber_t kValueNumberMin = INT_MIN;
+const valueNumber_t kValueNumberMax = INT_MAX;
+
+struct nodeBlock_t;
 
 union value_t
 {
     valueNumber_t number;
     size_t idx;
+    nodeBlock_t *block;
 };
 
 struct node_t
 {
     type_t type = TYPE_UKNOWN;
+    uint32_t refs = 0;  // references to node, if it's shared in tree->shared, else 0
     treeDataType value;
 
     // node_t *parent = NULL; FIXME: add parents
@@ -98,11 +138,49 @@ struct node_t
     node_t *right = NULL;
 };
 
+// Statements of block in order of execution, instead of left-deep chain of CONNECT nodes.
+// Array is in the same piece of tree->nodes right after the header
+struct nodeBlock_t
+{
+    size_t size = 0;
+    node_t **statements = NULL;
+};
+
+// Traversals keep pending nodes on explicit stack, not on call stack. Budget limits it,
+// so broken or hostile input fails with TREE_ERROR_TOO_DEEP instead of eating all memory
+const size_t kTreeDefaultDepthBudget = 1 << 24;
+
+// Nodes are bumped from slabs of this many nodes, one malloc () per slab
+const size_t kTreeSlabNodes = 1 << 14;
+
+const size_t kNodeTableMinCapacity = 1 << 10;
+
+// Shared nodes of DAG mode by (type, value, left, right), open addressing
+struct nodeTable_t
+{
+    node_t **buckets    = NULL;
+    size_t capacity     = 0;    // power of 2
+    size_t size         = 0;
+};
+
+// Tree owns all its nodes and arrays of blocks: they are in tree->nodes. Deleted nodes
+// are put to free list and are taken again first, whole tree is released by freeing slabs
 struct tree_t
 {
     node_t *root = NULL;
 
     size_t size = 0;
+    size_t allocsCount = 0;     // all nodes ever taken by NodeAlloc (), size is only live ones
+    size_t depthBudget = kTreeDefaultDepthBudget;
+
+    arena_t nodes       = {};
+    node_t *freeNodes   = NULL; // linked through left
+
+    // DAG mode: NodeCtorAndFill () gives the same node for the same (type, value, left,
+    // right) and counts references, NodeCopy () of it only adds one. Nodes, that are filled
+    // after they're made, blocks and parents of not shared nodes aren't shared
+    bool isShared       = false;
+    nodeTable_t shared  = {};
 
     treeLog_t *log = NULL;
 
@@ -125,6 +203,8 @@ enum treeError_t
     TREE_ERROR_SYNTAX_IN_SAVE_FILE      = 1 << 8, // FIXME: TREE_ERROR_IN_SOURCE_FILE
     TREE_ERROR_NODE_NOT_FOUND           = 1 << 9,
     TREE_ERROR_INVALID_TOKEN            = 1 << 10,
+    TREE_ERROR_NAMES_TABLE              = 1 << 11,
+    TREE_ERROR_TOO_DEEP                 = 1 << 12,
 
     TREE_ERROR_STACK                    = 1 << 30,
     TREE_ERROR_COMMON                   = 1 << 31
@@ -138,6 +218,13 @@ void NodeFill           (node_t *node, type_t type, treeDataType value,
 node_t *NodeCtorAndFill (tree_t *tree,
                          type_t type, treeDataType value, 
                          node_t *leftChild, node_t *rightChild);
+nodeBlock_t *BlockCtor  (tree_t *tree, node_t **statements, size_t size);
+node_t *NodeCtorBlock   (tree_t *tree, node_t **statements, size_t size);
+size_t NodeChildrenCount(const node_t *node);
+node_t **NodeChild      (node_t *node, size_t childIdx);
+void NodeUnpack         (node_t *node, node_t **leftChild, node_t **rightChild);
+node_t *NodeRebuild     (tree_t *tree, node_t *node, node_t *leftChild, node_t *rightChild);
+void NodeDeleteUnpacked (tree_t *tree, node_t **node);
 void TreeDelete         (tree_t *tree, node_t **node);
 void TreeDtor           (tree_t *tree);
 void TreeCopy           (tree_t *source, tree_t *dest);
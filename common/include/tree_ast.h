@@ -2,9 +2,15 @@
 #define K_TREE_AST_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
 
 #include "tree.h"
 #include "stack.h"
+#include "dynamic_array.h"
+#include "utils.h"
+#include "symbol_table.h"
+#include "arena.h"
 
 enum keywordIdxes_t
 {
@@ -46,37 +52,57 @@ enum keywordIdxes_t
     KEY_CALL,
 };
 
-struct token_t
-{
-    type_t type = TYPE_UKNOWN;
-    value_t value = {.idx = KEY_UKNOWN};
+struct tokenStream_t;
 
-    size_t line = 1;
-    size_t position = 1;
-};
+// Token stream as structure of arrays: parser mostly looks only at kinds and payloads,
+// so they are packed tight. Line and column are found by offset only for error messages.
+// If stream isn't NULL, tokens are lexed when parser asks for them and arrays are a ring
+// of the last kTokensStreamWindow tokens, token i is in slot i % kTokensStreamWindow
 struct tokensArray_t
 {
-    token_t *data = NULL;
+    uint8_t  *kinds    = NULL;  // type_t
+    uint32_t *payloads = NULL;  // keyword idx, name idx or number
+    uint32_t *offsets  = NULL;  // byte offset of token in source
 
-    size_t size = 0;
+    size_t size     = 0;
     size_t capacity = 0;
 
+    dynamicArray_t <uint32_t> lineStarts = {}; // byte offset of every line beginning
+
     const char *fileName = NULL;
-}; // TODO: array Ctor and make it universal on void*
+    const char *source   = NULL; // columns are counted in it only for error messages
+
+    bool isQuiet = false; // lexical errors aren't printed (chunks of parallel lexer)
+
+    tokenStream_t *stream = NULL;
+
+    arena_t *names = NULL; // if not NULL, new names are copied here: source isn't kept as it is
+};
 
 struct name_t
 {
-    char *name   = NULL;
+    const char *name = NULL; // points into program source, not '\0'-terminated
     size_t len   = 0;
+    size_t hash  = 0;
 
     size_t idx   = 0;
 };
-struct namesTable_t
+// Names get dense ids: name with idx i is always data[i]
+struct namesTable_t : dynamicArray_t <name_t>
 {
-    name_t *data = NULL;
+    // open addressing hash table, stores idx + 1 (0 is an empty bucket)
+    size_t *buckets = NULL;
+    size_t bucketsCapacity = 0; // always power of 2
+};
 
-    size_t size = 0;
-    size_t capacity = 0;
+// Top-level function, it's parsed again alone if only its tokens are edited
+struct functionSpan_t
+{
+    size_t firstToken   = 0;
+    size_t endToken     = 0;    // token after "воу"
+
+    node_t **node       = NULL; // child of CONNECT node, that holds the function
+    size_t nameIdx      = 0;
 };
 
 struct program_t
@@ -85,14 +111,17 @@ struct program_t
 
     tree_t ast = {};
 
+    dynamicArray_t <functionSpan_t> functionSpans = {}; // in order of source
+
     namesTable_t namesTable = {};
 
-    stack_t variables = {};
-    stack_t functions = {};
+    symbolTable_t variables = {};
+    symbolTable_t functions = {};
 
     tokensArray_t tokens = {};
 
-    char *buffer   = NULL;
+    sourceBuffer_t source = {}; // lives as long as program, names point into it
+    arena_t names         = {}; // or here, if source is streamed or edited
 };
 
 struct keyword_t
@@ -100,27 +129,44 @@ struct keyword_t
     const char *name            = NULL;
     const char *standardName    = NULL;
     size_t nameLen              = 0;
+    size_t standardNameLen      = 0;
     keywordIdxes_t idx          = KEY_UKNOWN;
     bool isFunction             = 0;
     size_t numberOfArgs         = 0;
+
+    int precedence              = 0;        // of binary operator, 0 if it isn't one
+    bool isRightAssoc           = false;
 };
 
 #define KEYWORD(nameKey, stndatdNameKey, idxKey, isFunctionKey, numberOfArgsKey)    \
         {.name          = nameKey,                                                  \
          .standardName  = stndatdNameKey,                                           \
          .nameLen       = sizeof (nameKey) - 1,                                     \
+         .standardNameLen = sizeof (stndatdNameKey) - 1,                            \
          .idx           = idxKey,                                                   \
          .isFunction    = isFunctionKey,                                            \
          .numberOfArgs  = numberOfArgsKey}
 
-const keyword_t kKeywords[] = 
+// Binary operator of expressions, bigger precedence binds tighter
+#define OPERATOR(nameKey, stndatdNameKey, idxKey, precedenceKey, isRightAssocKey)   \
+        {.name          = nameKey,                                                  \
+         .standardName  = stndatdNameKey,                                           \
+         .nameLen       = sizeof (nameKey) - 1,                                     \
+         .standardNameLen = sizeof (stndatdNameKey) - 1,                            \
+         .idx           = idxKey,                                                   \
+         .isFunction    = 0,                                                        \
+         .numberOfArgs  = 2,                                                        \
+         .precedence    = precedenceKey,                                            \
+         .isRightAssoc  = isRightAssocKey}
+
+constexpr keyword_t kKeywords[] = 
 {
     KEYWORD ("хз",                       "uknown",      KEY_UKNOWN,         0,  0),
-    KEYWORD ("фит",                      "+",           KEY_ADD,            0,  2),
-    KEYWORD ("дисс",                     "-",           KEY_SUB,            0,  2),
-    KEYWORD ("хайп",                     "*",           KEY_MUL,            0,  2),
-    KEYWORD ("антихайп",                 "/",           KEY_DIV,            0,  2),
-    KEYWORD ("TODO",                     "^",           KEY_POW,            0,  2),
+    OPERATOR ("фит",                     "+",           KEY_ADD,            1,  0),
+    OPERATOR ("дисс",                    "-",           KEY_SUB,            1,  0),
+    OPERATOR ("хайп",                    "*",           KEY_MUL,            2,  0),
+    OPERATOR ("антихайп",                "/",           KEY_DIV,            2,  0),
+    OPERATOR ("TODO",                    "^",           KEY_POW,            3,  1),
     KEYWORD ("TODO",                     "log",         KEY_LOG,            1,  2),
     KEYWORD ("TODO",                     "ln",          KEY_LN,             1,  1),
     KEYWORD ("TODO",                     "sin",         KEY_SIN,            1,  1),
@@ -152,30 +198,72 @@ const keyword_t kKeywords[] =
     KEYWORD ("лучше_я_сдохну_чем_стану", "return",      KEY_RETURN,         1,  1),
     KEYWORD ("зачитать" ,                "call",        KEY_CALL,           0,  0),
 };
-const size_t kNumberOfKeywords = sizeof(kKeywords) / sizeof(keyword_t);
+constexpr size_t kNumberOfKeywords = sizeof(kKeywords) / sizeof(keyword_t);
+
+constexpr bool KeywordsIndexedByIdx ()
+{
+    for (size_t i = 0; i < kNumberOfKeywords; i++)
+    {
+        if ((size_t) kKeywords[i].idx != i)
+            return false;
+    }
+
+    return true;
+}
+
+static_assert (KeywordsIndexedByIdx (), 
+               "kKeywords[i].idx must be equal to i, FindKeywordByIdx() relies on it");
+
+// TYPE_BLOCK node in save files, it isn't a keyword
+const char kBlockStandardName[] = "{}";
+
+#ifdef PRINT_DEBUG
+    #define NAMES_TABLE_VERIFY(namesTable) NamesTableVerify (namesTable)
+#else
+    #define NAMES_TABLE_VERIFY(namesTable) TREE_OK
+#endif // PRINT_DEBUG
+
+// Explicit stacks of all tree traversals grow only through this, so they respect the budget
+template <typename T>
+int TreeStackPush (const tree_t *tree, dynamicArray_t <T> *stack, const T &frame)
+{
+    assert (tree);
+    assert (stack);
+
+    if (stack->size >= tree->depthBudget)
+    {
+        ERROR_LOG ("Tree is deeper than depth budget (%lu)", tree->depthBudget);
 
+        return TREE_ERROR_TOO_DEEP;
+    }
+
+    int status = DynamicArrayPush (stack, frame);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    return TREE_OK;
+}
 
 int ProgramCtor     (program_t *program);
 void ProgramDtor    (program_t *program);
 
 int NamesTableCtor  (namesTable_t *namesTable);
 void NamesTableDtor (namesTable_t *namesTable);
+int NamesTableVerify (namesTable_t *namesTable);
 
 const char *GetTypeName (type_t type);
 
 const name_t *NamesTableFindByIdx (namesTable_t *namesTable, size_t idx);
-const name_t *NamesTableFindByStr (namesTable_t *namesTable, char *varName, size_t varNameLen);
+const name_t *NamesTableFindByStr (namesTable_t *namesTable, const char *varName, size_t varNameLen);
 const keyword_t *FindKeywordByIdx (keywordIdxes_t idx);
+const keyword_t *FindKeywordByStandardName (const char *standardName, size_t len);
 
 const keyword_t *FindBuiltinFunctionByIdx (keywordIdxes_t idx);
 
-int CheckForReallocNamesTable (namesTable_t *namesTable);
-
-int NamesTableFindOrAdd (namesTable_t *namesTable, char *varName, size_t len, 
+int NamesTableFindOrAdd (namesTable_t *namesTable, const char *varName, size_t len, 
                          size_t *idx);
-
-void TryToFindOperator (char *str, int len, type_t *type, treeDataType *value);
-void TryToFindNode     (char *str, int len, type_t *type, treeDataType *value);
+int NamesTableCopyNames (namesTable_t *namesTable, arena_t *arena);
 
 int TreeAstSaveToFile  (program_t *program, const char *fileName);
 int PrintNode          (FILE *file, program_t *program, node_t *node, bool exitQuotes);
@@ -183,7 +271,15 @@ int PrintNode          (FILE *file, program_t *program, node_t *node, bool exitQ
 int TreeCalculate      (program_t *program, tree_t *ast);
 double NodeCalculate   (program_t *program, node_t *node);
 
-void TreeSimplify      (program_t *program, tree_t *tree);
+// What TreeSimplify () may change, each level does what the previous one does too
+enum simplifyLevel_t
+{
+    SIMPLIFY_NONE           = 0,
+    SIMPLIFY_EXPRESSIONS    = 1,    // constants are folded, x * 1, x + 0, ... are dropped
+    SIMPLIFY_STATEMENTS     = 2,    // ifs with constant condition, code after return
+};
+
+int TreeSimplify       (program_t *program, tree_t *tree, simplifyLevel_t level);
 
 void NamesTableDump    (namesTable_t *namesTable);
 
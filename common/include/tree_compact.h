@@ -0,0 +1,56 @@
+#ifndef K_TREE_COMPACT_H
+#define K_TREE_COMPACT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "tree.h"
+#include "tree_ast.h"
+#include "dynamic_array.h"
+
+// Index of node in compactTree_t::nodes, nodes[0] is never used: index 0 is nil
+typedef uint32_t compactIdx_t;
+
+const compactIdx_t kCompactNil      = 0;
+const size_t kCompactMaxNodes       = UINT32_MAX;
+
+// Half the size of node_t. Value is number, idx of keyword or name. Block has its
+// number of statements in value, and left is the first of them in compactTree_t::statements
+struct compactNode_t
+{
+    uint8_t  kind           = TYPE_UKNOWN;  // type_t
+    uint32_t value          = 0;
+    compactIdx_t left       = kCompactNil;
+    compactIdx_t right      = kCompactNil;
+};
+
+static_assert (sizeof (compactNode_t) == 16, "compactNode_t should stay 16 bytes");
+
+// AST in one contiguous array. Nodes are in preorder, so every child comes after its
+// parent and root is nodes[1]: passes can go through the array instead of the pointers
+struct compactTree_t
+{
+    dynamicArray_t <compactNode_t> nodes      = {};
+    dynamicArray_t <compactIdx_t>  statements = {};   // of all blocks, each block is a range
+
+    compactIdx_t root = kCompactNil;
+};
+
+int CompactTreeCtor         (compactTree_t *compact, size_t capacityHint);
+void CompactTreeDtor        (compactTree_t *compact);
+
+int CompactTreeFromTree     (compactTree_t *compact, tree_t *tree);
+int CompactTreeToTree       (compactTree_t *compact, tree_t *tree);
+
+int CompactNodeAppend       (compactTree_t *compact, type_t type, treeDataType value,
+                             compactIdx_t *idx);
+
+int CompactTreeVerify       (compactTree_t *compact);
+int CompactTreeSaveToFile   (program_t *program, compactTree_t *compact, const char *fileName);
+int CompactNodeSaveToFile   (FILE *file, program_t *program, compactTree_t *compact,
+                             compactIdx_t node);
+
+size_t CompactNodeChildrenCount (const compactTree_t *compact, compactIdx_t node);
+compactIdx_t *CompactNodeChild  (compactTree_t *compact, compactIdx_t node, size_t childIdx);
+
+#endif // K_TREE_COMPACT_H
@@ -2,11 +2,43 @@
 #define K_UTILS_H
 
 #include <stdio.h>
+#include <stdint.h>
+
+// File contents followed by '\0'. Regular files are mmap()-ed read-only without copying,
+// pipes and stdin ("-") are read into allocated memory. Edited source is always allocated
+struct sourceBuffer_t
+{
+    char *data          = NULL;  // read-only if mapped, data[size] == '\0'
+    size_t size         = 0;
+
+    size_t mappedLen    = 0;     // 0 if data is allocated
+};
+
+int SourceBufferOpen    (sourceBuffer_t *source, const char *fileName);
+void SourceBufferClose  (sourceBuffer_t *source);
+int SourceBufferEdit    (sourceBuffer_t *source, size_t begin, size_t end, 
+                         const char *text, size_t textLen);
+
+// Number ::= digits ('.' digits)?, value is integer + fraction / 10^fractionDigits.
+// No sign, no locale; parts that don't fit in uint64_t set isOverflow
+struct numberLiteral_t
+{
+    uint64_t integer        = 0;
+    uint64_t fraction       = 0;
+    size_t fractionDigits   = 0;    // 0 if there is no '.'
+
+    bool isOverflow         = false;
+};
+
+// returns length of the literal, 0 if str doesn't begin with a digit
+size_t ScanNumber   (const char *str, numberLiteral_t *literal);
+
+// number of UTF-8 characters in len bytes (continuation bytes aren't counted)
+size_t Utf8Length   (const char *str, size_t len);
 
 int SafeMkdir       (const char *fileName);
 void ClearBuffer    ();
 char *SkipSpaces    (char *buffer);
-char *ReadFile      (const char *inputFileName, size_t *bufferLen);
 int SafeReadLine    (char **str, size_t *len);
 char *SkipSpacesAndCount (char *buffer, size_t *line, size_t *position);
 
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "arena.h"
+
+#include "debug.h"
+
+static arenaBlock_t *ArenaAddBlock (arena_t *arena, size_t minSize);
+
+void ArenaCtor (arena_t *arena, size_t blockSize)
+{
+    assert (arena);
+    assert (blockSize > 0);
+
+    arena->head        = NULL;
+    arena->blockSize   = blockSize;
+    arena->blocksCount = 0;
+    arena->bytesUsed   = 0;
+}
+
+void ArenaDtor (arena_t *arena)
+{
+    assert (arena);
+
+    arenaBlock_t *block = arena->head;
+
+    while (block != NULL)
+    {
+        arenaBlock_t *next = block->next;
+
+        free (block);
+
+        block = next;
+    }
+
+    arena->head        = NULL;
+    arena->blocksCount = 0;
+    arena->bytesUsed   = 0;
+}
+
+arenaBlock_t *ArenaAddBlock (arena_t *arena, size_t minSize)
+{
+    assert (arena);
+
+    size_t size = arena->blockSize;
+    if (size < minSize)
+        size = minSize;
+
+    arenaBlock_t *block = (arenaBlock_t *) malloc (sizeof (arenaBlock_t) + size);
+    if (block == NULL)
+    {
+        ERROR_LOG ("Error allocating memory for arena block - %s", strerror (errno));
+
+        return NULL;
+    }
+
+    block->next = arena->head;
+    block->size = size;
+    block->used = 0;
+    block->data = (char *) (block + 1);
+
+    arena->head = block;
+    arena->blocksCount++;
+
+    DEBUG_LOG ("New arena block [%p] of %lu bytes", block, size);
+
+    return block;
+}
+
+// align should be power of 2
+void *ArenaAlloc (arena_t *arena, size_t size, size_t align)
+{
+    assert (arena);
+    assert (align != 0 && (align & (align - 1)) == 0);
+
+    arenaBlock_t *block = arena->head;
+
+    size_t offset = 0;
+    if (block != NULL)
+    {
+        uintptr_t freeStart = (uintptr_t) (block->data + block->used);
+
+        offset = block->used + (align - freeStart % align) % align;
+    }
+
+    if (block == NULL || offset + size > block->size)
+    {
+        block = ArenaAddBlock (arena, size + align);
+        if (block == NULL)
+            return NULL;
+
+        uintptr_t dataStart = (uintptr_t) block->data;
+
+        offset = (align - dataStart % align) % align;
+    }
+
+    void *result = block->data + offset;
+
+    block->used = offset + size;
+    arena->bytesUsed += size;
+
+    return result;
+}
+
+// copy of str[0..len) terminated with '\0'
+char *ArenaStrDup (arena_t *arena, const char *str, size_t len)
+{
+    assert (arena);
+    assert (str);
+
+    char *copy = (char *) ArenaAlloc (arena, len + 1, 1);
+    if (copy == NULL)
+        return NULL;
+
+    memcpy (copy, str, len);
+    copy[len] = '\0';
+
+    return copy;
+}
@@ -17,6 +17,7 @@ void PrintCommonError (int error)
     CHECK_ERROR (COMMON_ERROR_NULL_POINTER,         "Some pointer is NULL, but it should not be NULL");
     CHECK_ERROR (COMMON_ERROR_READING_INPUT,        "Error reading data from stdin");
     CHECK_ERROR (COMMON_ERROR_WRITE_TO_FILE,        "Error while writing some data to file");
+    CHECK_ERROR (COMMON_ERROR_CREATING_THREAD,      "Error creating thread");
 }
 
 #undef CHECK_ERROR
\ No newline at end of file
@@ -0,0 +1,3 @@
+#include "lexer_dfa.h"
+
+extern constexpr lexerDfa_t kLexerDfa = LexerDfaBuild ();
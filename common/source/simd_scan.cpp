@@ -0,0 +1,450 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "simd_scan.h"
+
+#if !defined (__x86_64__) && !defined (SCAN_NO_SIMD)
+    #define SCAN_NO_SIMD
+#endif // !__x86_64__ && !SCAN_NO_SIMD
+
+#ifndef SCAN_NO_SIMD
+    #include <immintrin.h>
+#endif // SCAN_NO_SIMD
+
+// aligned loads may touch bytes outside of the string (but in the same page)
+#define SCAN_KERNEL         __attribute__ ((no_sanitize_address))
+#define SCAN_KERNEL_AVX2    __attribute__ ((no_sanitize_address, target ("avx2,popcnt")))
+
+struct scanKernels_t
+{
+    size_t (*spaces)        (const char *str);
+    size_t (*name)          (const char *str);
+
+    size_t (*countNewLines) (const char *buffer, size_t len);
+    size_t (*newLines)      (const char *buffer, size_t len, uint32_t *lineStarts);
+
+    const char *kernelsName;
+};
+
+static scanKernels_t ScanSelectKernels ();
+
+static const scanKernels_t kScanKernels = ScanSelectKernels ();
+
+static inline bool IsSpace (char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool IsNameChar (char c)
+{
+    return (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') ||
+            c == '_';
+}
+
+// Often there is just one space between tokens or one letter in a name,
+// so first byte is checked before calling a kernel for the rest of the run
+size_t ScanSpaces (const char *str)
+{
+    assert (str);
+
+    if (!IsSpace (str[0]))
+        return 0;
+
+    return 1 + kScanKernels.spaces (str + 1);
+}
+
+size_t ScanName (const char *str)
+{
+    assert (str);
+
+    if (!IsNameChar (str[0]))
+        return 0;
+
+    return 1 + kScanKernels.name (str + 1);
+}
+
+size_t ScanCountNewLines (const char *buffer, size_t len)
+{
+    assert (buffer);
+
+    return kScanKernels.countNewLines (buffer, len);
+}
+
+size_t ScanNewLines (const char *buffer, size_t len, uint32_t *lineStarts)
+{
+    assert (buffer);
+    assert (lineStarts);
+    assert (len < UINT32_MAX);
+
+    return kScanKernels.newLines (buffer, len, lineStarts);
+}
+
+const char *ScanKernelsName ()
+{
+    return kScanKernels.kernelsName;
+}
+
+// ================ scalar ================
+
+static size_t ScanSpacesScalar (const char *str)
+{
+    size_t len = 0;
+
+    while (IsSpace (str[len]))
+        len++;
+
+    return len;
+}
+
+static size_t ScanNameScalar (const char *str)
+{
+    size_t len = 0;
+
+    while (IsNameChar (str[len]))
+        len++;
+
+    return len;
+}
+
+static size_t ScanCountNewLinesScalar (const char *buffer, size_t len)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < len; i++)
+        count += (buffer[i] == '\n');
+
+    return count;
+}
+
+static size_t ScanNewLinesScalar (const char *buffer, size_t len, uint32_t *lineStarts)
+{
+    size_t count = 0;
+
+    const char *end = buffer + len;
+
+    for (const char *newLine = (const char *) memchr (buffer, '\n', len);
+         newLine != NULL;
+         newLine = (const char *) memchr (newLine + 1, '\n', size_t (end - newLine - 1)))
+    {
+        lineStarts[count] = (uint32_t) (newLine + 1 - buffer);
+        count++;
+    }
+
+    return count;
+}
+
+#ifndef SCAN_NO_SIMD
+
+// ================ common for SIMD ================
+
+// bit i of mask is set if byte i of block matches
+
+static inline const char *AlignDown (const char *str, size_t alignment)
+{
+    return str - ((uintptr_t) str & (alignment - 1));
+}
+
+static inline uint32_t LowBits (size_t count)
+{
+    return (uint32_t) ((1ULL << count) - 1);
+}
+
+static inline size_t WriteLineStarts (uint32_t mask, ptrdiff_t blockOffset, uint32_t *lineStarts)
+{
+    size_t count = 0;
+
+    for (; mask != 0; mask &= mask - 1)
+    {
+        lineStarts[count] = (uint32_t) (blockOffset + __builtin_ctz (mask) + 1);
+        count++;
+    }
+
+    return count;
+}
+
+// ================ SSE2 ================
+
+const size_t kSse2Block = 16;
+
+// bytes in [low, high], compared as unsigned
+SCAN_KERNEL static inline __m128i Sse2InRange (__m128i bytes, char low, char high)
+{
+    __m128i shifted = _mm_sub_epi8 (bytes, _mm_set1_epi8 (low));
+
+    return _mm_cmpeq_epi8 (_mm_min_epu8 (shifted, _mm_set1_epi8 ((char) (high - low))), shifted);
+}
+
+SCAN_KERNEL static inline uint32_t Sse2SpacesMask (const char *block)
+{
+    __m128i bytes = _mm_load_si128 ((const __m128i *) block);
+
+    __m128i spaces = _mm_or_si128 (_mm_cmpeq_epi8 (bytes, _mm_set1_epi8 (' ')),
+                                   Sse2InRange (bytes, '\t', '\r'));
+
+    return (uint32_t) _mm_movemask_epi8 (spaces);
+}
+
+SCAN_KERNEL static inline uint32_t Sse2NameMask (const char *block)
+{
+    __m128i bytes = _mm_load_si128 ((const __m128i *) block);
+
+    __m128i letters = Sse2InRange (_mm_or_si128 (bytes, _mm_set1_epi8 (0x20)), 'a', 'z');
+    __m128i digits  = Sse2InRange (bytes, '0', '9');
+
+    __m128i name = _mm_or_si128 (_mm_or_si128 (letters, digits),
+                                 _mm_cmpeq_epi8 (bytes, _mm_set1_epi8 ('_')));
+
+    return (uint32_t) _mm_movemask_epi8 (name);
+}
+
+SCAN_KERNEL static inline uint32_t Sse2NewLinesMask (const char *block)
+{
+    __m128i bytes = _mm_load_si128 ((const __m128i *) block);
+
+    return (uint32_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (bytes, _mm_set1_epi8 ('\n')));
+}
+
+SCAN_KERNEL static size_t ScanSpacesSse2 (const char *str)
+{
+    const char *block = AlignDown (str, kSse2Block);
+    size_t shift = size_t (str - block);
+
+    uint32_t stop = (~Sse2SpacesMask (block) & LowBits (kSse2Block)) >> shift;
+    size_t len = kSse2Block - shift;
+
+    while (stop == 0)
+    {
+        block += kSse2Block;
+
+        stop = ~Sse2SpacesMask (block) & LowBits (kSse2Block);
+        if (stop != 0)
+            return len + (size_t) __builtin_ctz (stop);
+
+        len += kSse2Block;
+    }
+
+    return (size_t) __builtin_ctz (stop);
+}
+
+SCAN_KERNEL static size_t ScanNameSse2 (const char *str)
+{
+    const char *block = AlignDown (str, kSse2Block);
+    size_t shift = size_t (str - block);
+
+    uint32_t stop = (~Sse2NameMask (block) & LowBits (kSse2Block)) >> shift;
+    size_t len = kSse2Block - shift;
+
+    while (stop == 0)
+    {
+        block += kSse2Block;
+
+        stop = ~Sse2NameMask (block) & LowBits (kSse2Block);
+        if (stop != 0)
+            return len + (size_t) __builtin_ctz (stop);
+
+        len += kSse2Block;
+    }
+
+    return (size_t) __builtin_ctz (stop);
+}
+
+SCAN_KERNEL static size_t ScanCountNewLinesSse2 (const char *buffer, size_t len)
+{
+    if (len == 0)
+        return 0;
+
+    const char *end   = buffer + len;
+    const char *block = AlignDown (buffer, kSse2Block);
+
+    uint32_t mask = Sse2NewLinesMask (block) & ~LowBits (size_t (buffer - block));
+    size_t count = 0;
+
+    while ((size_t) (end - block) > kSse2Block)
+    {
+        count += (size_t) __builtin_popcount (mask);
+
+        block += kSse2Block;
+        mask = Sse2NewLinesMask (block);
+    }
+
+    return count + (size_t) __builtin_popcount (mask & LowBits (size_t (end - block)));
+}
+
+SCAN_KERNEL static size_t ScanNewLinesSse2 (const char *buffer, size_t len, uint32_t *lineStarts)
+{
+    if (len == 0)
+        return 0;
+
+    const char *end   = buffer + len;
+    const char *block = AlignDown (buffer, kSse2Block);
+
+    uint32_t mask = Sse2NewLinesMask (block) & ~LowBits (size_t (buffer - block));
+    size_t count = 0;
+
+    while ((size_t) (end - block) > kSse2Block)
+    {
+        count += WriteLineStarts (mask, block - buffer, lineStarts + count);
+
+        block += kSse2Block;
+        mask = Sse2NewLinesMask (block);
+    }
+
+    mask &= LowBits (size_t (end - block));
+
+    return count + WriteLineStarts (mask, block - buffer, lineStarts + count);
+}
+
+// ================ AVX2 ================
+
+const size_t kAvx2Block = 32;
+
+SCAN_KERNEL_AVX2 static inline __m256i Avx2InRange (__m256i bytes, char low, char high)
+{
+    __m256i shifted = _mm256_sub_epi8 (bytes, _mm256_set1_epi8 (low));
+
+    return _mm256_cmpeq_epi8 (_mm256_min_epu8 (shifted, _mm256_set1_epi8 ((char) (high - low))), shifted);
+}
+
+SCAN_KERNEL_AVX2 static inline uint32_t Avx2SpacesMask (const char *block)
+{
+    __m256i bytes = _mm256_load_si256 ((const __m256i *) block);
+
+    __m256i spaces = _mm256_or_si256 (_mm256_cmpeq_epi8 (bytes, _mm256_set1_epi8 (' ')),
+                                      Avx2InRange (bytes, '\t', '\r'));
+
+    return (uint32_t) _mm256_movemask_epi8 (spaces);
+}
+
+SCAN_KERNEL_AVX2 static inline uint32_t Avx2NameMask (const char *block)
+{
+    __m256i bytes = _mm256_load_si256 ((const __m256i *) block);
+
+    __m256i letters = Avx2InRange (_mm256_or_si256 (bytes, _mm256_set1_epi8 (0x20)), 'a', 'z');
+    __m256i digits  = Avx2InRange (bytes, '0', '9');
+
+    __m256i name = _mm256_or_si256 (_mm256_or_si256 (letters, digits),
+                                    _mm256_cmpeq_epi8 (bytes, _mm256_set1_epi8 ('_')));
+
+    return (uint32_t) _mm256_movemask_epi8 (name);
+}
+
+SCAN_KERNEL_AVX2 static inline uint32_t Avx2NewLinesMask (const char *block)
+{
+    __m256i bytes = _mm256_load_si256 ((const __m256i *) block);
+
+    return (uint32_t) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (bytes, _mm256_set1_epi8 ('\n')));
+}
+
+SCAN_KERNEL_AVX2 static size_t ScanSpacesAvx2 (const char *str)
+{
+    const char *block = AlignDown (str, kAvx2Block);
+    size_t shift = size_t (str - block);
+
+    uint32_t stop = ~Avx2SpacesMask (block) >> shift;
+    size_t len = kAvx2Block - shift;
+
+    while (stop == 0)
+    {
+        block += kAvx2Block;
+
+        stop = ~Avx2SpacesMask (block);
+        if (stop != 0)
+            return len + (size_t) __builtin_ctz (stop);
+
+        len += kAvx2Block;
+    }
+
+    return (size_t) __builtin_ctz (stop);
+}
+
+SCAN_KERNEL_AVX2 static size_t ScanNameAvx2 (const char *str)
+{
+    const char *block = AlignDown (str, kAvx2Block);
+    size_t shift = size_t (str - block);
+
+    uint32_t stop = ~Avx2NameMask (block) >> shift;
+    size_t len = kAvx2Block - shift;
+
+    while (stop == 0)
+    {
+        block += kAvx2Block;
+
+        stop = ~Avx2NameMask (block);
+        if (stop != 0)
+            return len + (size_t) __builtin_ctz (stop);
+
+        len += kAvx2Block;
+    }
+
+    return (size_t) __builtin_ctz (stop);
+}
+
+SCAN_KERNEL_AVX2 static size_t ScanCountNewLinesAvx2 (const char *buffer, size_t len)
+{
+    if (len == 0)
+        return 0;
+
+    const char *end   = buffer + len;
+    const char *block = AlignDown (buffer, kAvx2Block);
+
+    uint32_t mask = Avx2NewLinesMask (block) & ~LowBits (size_t (buffer - block));
+    size_t count = 0;
+
+    while ((size_t) (end - block) > kAvx2Block)
+    {
+        count += (size_t) __builtin_popcount (mask);
+
+        block += kAvx2Block;
+        mask = Avx2NewLinesMask (block);
+    }
+
+    return count + (size_t) __builtin_popcount (mask & LowBits (size_t (end - block)));
+}
+
+SCAN_KERNEL_AVX2 static size_t ScanNewLinesAvx2 (const char *buffer, size_t len, uint32_t *lineStarts)
+{
+    if (len == 0)
+        return 0;
+
+    const char *end   = buffer + len;
+    const char *block = AlignDown (buffer, kAvx2Block);
+
+    uint32_t mask = Avx2NewLinesMask (block) & ~LowBits (size_t (buffer - block));
+    size_t count = 0;
+
+    while ((size_t) (end - block) > kAvx2Block)
+    {
+        count += WriteLineStarts (mask, block - buffer, lineStarts + count);
+
+        block += kAvx2Block;
+        mask = Avx2NewLinesMask (block);
+    }
+
+    mask &= LowBits (size_t (end - block));
+
+    return count + WriteLineStarts (mask, block - buffer, lineStarts + count);
+}
+
+#endif // SCAN_NO_SIMD
+
+// called from static initializer, so cpu info must be initialized by hand
+scanKernels_t ScanSelectKernels ()
+{
+#ifndef SCAN_NO_SIMD
+    __builtin_cpu_init ();
+
+#ifndef SCAN_NO_AVX2
+    if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("popcnt"))
+        return {ScanSpacesAvx2, ScanNameAvx2, ScanCountNewLinesAvx2, ScanNewLinesAvx2, "avx2"};
+#endif // SCAN_NO_AVX2
+
+    if (__builtin_cpu_supports ("sse2"))
+        return {ScanSpacesSse2, ScanNameSse2, ScanCountNewLinesSse2, ScanNewLinesSse2, "sse2"};
+#endif // SCAN_NO_SIMD
+
+    return {ScanSpacesScalar, ScanNameScalar, ScanCountNewLinesScalar, ScanNewLinesScalar, "scalar"};
+}
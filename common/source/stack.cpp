@@ -4,6 +4,7 @@
 
 #include "debug.h"
 #include "stack.h"
+#include "dynamic_array.h"
 
 const size_t maxCapacity = (1UL << 32);
 
@@ -41,6 +42,43 @@ size_t GetCapacity (stack_t *stack)
 #endif
 }
 
+static int StackRealloc (stack_t *stack, size_t newCapacity);
+
+// memory is moved by DynamicArrayRealloc (), so allocation policy is common for all containers
+int StackRealloc (stack_t *stack, size_t newCapacity)
+{
+    assert (stack);
+
+    size_t oldCapacity = stack->capacity;
+    size_t keptCount   = stack->size;
+#ifdef STACK_CANARY
+    keptCount += 1;
+#endif // STACK_CANARY
+
+    stack->capacity = newCapacity;
+
+    stackDataType *newData = DynamicArrayRealloc (GetOrigData (stack->data), keptCount, 
+                                                  GetCapacity (stack));
+    if (newData == NULL)
+    {
+        stack->capacity = oldCapacity;
+
+        return NULL_DATA;
+    }
+
+#ifdef STACK_CANARY
+    newData += 1;
+#endif // STACK_CANARY
+
+    stack->data = newData;
+
+#ifdef STACK_CANARY
+    *GetCanaryEnd (stack) = CANARY;
+#endif // STACK_CANARY
+
+    return STACK_OK;
+}
+
 void StackPrintError (int error)
 {
     DEBUG_LOG ("error = %d\n", error);
@@ -64,7 +102,10 @@ void StackPrintError (int error)
     printf("%s", COLOR_END);
 }
 
-int StackError (stack_t *stack)
+static int StackCheckFields (stack_t *stack);
+
+// O(1) checks of everything except poison
+int StackCheckFields (stack_t *stack)
 {
     int error = STACK_OK;
 
@@ -106,7 +147,17 @@ int StackError (stack_t *stack)
     }
 #endif // STACK_CANARY
 
-#ifdef PRINT_DEBUG
+    return error;
+}
+
+// full check, O(capacity)
+int StackError (stack_t *stack)
+{
+    int error = StackCheckFields (stack);
+    if (error & (NULL_STRUCT | NULL_DATA))
+        return error;
+
+#ifdef STACK_POISON_CHECK
     for (size_t i = 0; i < stack->size; i++)
     {
         if (stack->data[i] == POISON)
@@ -123,11 +174,42 @@ int StackError (stack_t *stack)
             break;
         }
     }
-#endif //PRINT_DEBUG
+#endif // STACK_POISON_CHECK
 
     return error;
 }
 
+// Check made on every operation: only cells near the top are checked for poison,
+// full check is made once per capacity operations, so it is O(1) amortized
+int StackVerify (stack_t *stack)
+{
+#ifdef STACK_FULL_VERIFY
+    return StackError (stack);
+#else
+    int error = StackCheckFields (stack);
+    if (error & (NULL_STRUCT | NULL_DATA | OVERFLOW))
+        return error;
+
+#ifdef STACK_POISON_CHECK
+    stack->operationsCount++;
+    if (stack->operationsCount >= stack->capacity)
+    {
+        stack->operationsCount = 0;
+
+        return error | StackError (stack);
+    }
+
+    if (stack->size > 0 && stack->data[stack->size - 1] == POISON)
+        error |= POISON_VALUE_IN_DATA;
+
+    if (stack->size < stack->capacity && stack->data[stack->size] != POISON)
+        error |= WRONG_VALUE_IN_POISON;
+#endif // STACK_POISON_CHECK
+
+    return error;
+#endif // STACK_FULL_VERIFY
+}
+
 int StackCtor (stack_t *stack, size_t capacity
                ON_DEBUG (, varInfo_t varInfo))
 {
@@ -155,11 +237,15 @@ int StackCtor (stack_t *stack, size_t capacity
 
 #ifdef PRINT_DEBUG
     stack->varInfo = varInfo;
+#endif // PRINT_DEBUG
+
+#ifdef STACK_POISON_CHECK
+    stack->operationsCount = 0;
     for (size_t i = 0; i < capacity; i++)
     {
         stack->data[i] = POISON;
     }
-#endif // PRINT_DEBUG
+#endif // STACK_POISON_CHECK
 
     return STACK_ERROR (stack);
 }
@@ -172,31 +258,18 @@ int StackPush (stack_t *stack, stackDataType value)
 
     if (stack->size == stack->capacity)
     {
-        stack->capacity *= 2;
-        if (stack->capacity == 0)
-            stack->capacity = 2;
-
-        stackDataType *newData = (stackDataType *) realloc (GetOrigData (stack->data), 
-                                                            GetCapacity (stack) * sizeof(stackDataType));
-#ifdef STACK_CANARY
-        newData += 1;
-#endif // STACK_CANARY
-
-        if (GetOrigData(newData) == NULL)
-            return NULL_DATA;
+        error = StackRealloc (stack, DynamicArrayGrowCapacity (stack->capacity, stack->size + 1));
+        if (error != STACK_OK)
+            return error;
 
-        stack->data = newData;
-#ifdef STACK_CANARY
-    *GetCanaryEnd (stack) = CANARY;
-#endif // STACK_CANARY
-    }
-
-#ifdef PRINT_DEBUG
-    for (size_t i = stack->size + 1; i < stack->capacity; i++)
-    {
-        stack->data[i] = POISON;
+#ifdef STACK_POISON_CHECK
+        // only new cells: stack was full, so there were no unused ones
+        for (size_t i = stack->size; i < stack->capacity; i++)
+        {
+            stack->data[i] = POISON;
+        }
+#endif // STACK_POISON_CHECK
     }
-#endif // PRINT_DEBUG
 
     stack->data[stack->size] = value;
     stack->size++;
@@ -213,31 +286,18 @@ int StackPop (stack_t *stack, stackDataType *value)
     if (stack->size == 0)
         return TRYING_TO_POP_FROM_EMPTY_STACK;
 
-    if (stack->size * 4 <= stack->capacity)
+    if (stack->size * 4 <= stack->capacity && stack->capacity / 2 >= kDynamicArrayMinCapacity)
     {
-        stack->capacity /= 2;
-
-        stackDataType *newData = (stackDataType *) realloc (GetOrigData (stack->data), 
-                                                            GetCapacity(stack) * sizeof(stackDataType));
-#ifdef STACK_CANARY
-        newData += 1;
-#endif // STACK_CANARY
-
-        if (GetOrigData (newData) == NULL)
-            return NULL_DATA;
-
-        stack->data = newData;
-        
-#ifdef STACK_CANARY
-    *GetCanaryEnd (stack) = CANARY;
-#endif // STACK_CANARY
+        error = StackRealloc (stack, stack->capacity / 2);
+        if (error != STACK_OK)
+            return error;
     }
 
     stack->size--;
     *value = stack->data[stack->size];
-#ifdef PRINT_DEBUG
+#ifdef STACK_POISON_CHECK
     stack->data[stack->size] = POISON;
-#endif // PRINT_DEBUG
+#endif // STACK_POISON_CHECK
     return STACK_ERROR (stack);
 }
 
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "symbol_table.h"
+
+#include "tree.h"
+#include "stack.h"
+
+int SymbolTableCtor (symbolTable_t *table)
+{
+    assert (table);
+
+    const size_t kDefaultStackCapacity = 16;
+
+    int status = DynamicArrayCtor (&table->isDeclared, 0);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    status = STACK_CREATE (table->declared, kDefaultStackCapacity);
+    if (status != STACK_OK)
+        return TREE_ERROR_STACK |
+               status;
+
+    status = STACK_CREATE (table->scopeStarts, kDefaultStackCapacity);
+    if (status != STACK_OK)
+        return TREE_ERROR_STACK |
+               status;
+
+    return TREE_OK;
+}
+
+void SymbolTableDtor (symbolTable_t *table)
+{
+    assert (table);
+
+    DynamicArrayDtor (&table->isDeclared);
+
+    StackDtor (&table->declared);
+    StackDtor (&table->scopeStarts);
+}
+
+bool SymbolTableIsDeclared (symbolTable_t *table, size_t nameIdx)
+{
+    assert (table);
+
+    return nameIdx < table->isDeclared.size && table->isDeclared.data[nameIdx];
+}
+
+// name is declared in the innermost scope
+int SymbolTableDeclare (symbolTable_t *table, size_t nameIdx)
+{
+    assert (table);
+    assert (!SymbolTableIsDeclared (table, nameIdx));
+
+    if (nameIdx >= table->isDeclared.size)
+    {
+        int status = DynamicArrayResize (&table->isDeclared, nameIdx + 1);
+        if (status != COMMON_ERROR_OK)
+            return TREE_ERROR_COMMON |
+                   status;
+    }
+
+    int status = StackPush (&table->declared, nameIdx);
+    if (status != STACK_OK)
+        return TREE_ERROR_STACK |
+               status;
+
+    table->isDeclared.data[nameIdx] = true;
+
+    return TREE_OK;
+}
+
+int SymbolTablePushScope (symbolTable_t *table)
+{
+    assert (table);
+
+    int status = StackPush (&table->scopeStarts, table->declared.size);
+    if (status != STACK_OK)
+        return TREE_ERROR_STACK |
+               status;
+
+    return TREE_OK;
+}
+
+// forgets all names declared since the last SymbolTablePushScope ()
+int SymbolTablePopScope (symbolTable_t *table)
+{
+    assert (table);
+
+    size_t scopeStart = 0;
+
+    int status = StackPop (&table->scopeStarts, &scopeStart);
+    if (status != STACK_OK)
+        return TREE_ERROR_STACK |
+               status;
+
+    return SymbolTableTruncate (table, scopeStart);
+}
+
+// forgets all names, but the first declaredCount ones
+int SymbolTableTruncate (symbolTable_t *table, size_t declaredCount)
+{
+    assert (table);
+
+    while (table->declared.size > declaredCount)
+    {
+        size_t nameIdx = 0;
+
+        int status = StackPop (&table->declared, &nameIdx);
+        if (status != STACK_OK)
+            return TREE_ERROR_STACK |
+                   status;
+
+        table->isDeclared.data[nameIdx] = false;
+    }
+
+    return TREE_OK;
+}
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "thread_pool.h"
+
+#include "debug.h"
+
+static void *ThreadPoolWorker       (void *poolPtr);
+static void ThreadPoolTakeTasks     (threadPool_t *pool);
+
+int ThreadPoolCtor (threadPool_t *pool, size_t threadsCount)
+{
+    assert (pool);
+    assert (threadsCount > 0);
+
+    *pool = {};
+
+    if (threadsCount == 1)
+        return COMMON_ERROR_OK;
+
+    pool->workers = (pthread_t *) calloc (threadsCount - 1, sizeof (pthread_t));
+    if (pool->workers == NULL)
+    {
+        ERROR_LOG ("Error allocating memory for %lu threads", threadsCount - 1);
+
+        return COMMON_ERROR_ALLOCATING_MEMORY;
+    }
+
+    for (size_t i = 0; i < threadsCount - 1; i++)
+    {
+        int status = pthread_create (&pool->workers[i], NULL, ThreadPoolWorker, pool);
+        if (status != 0)
+        {
+            ERROR_LOG ("Error creating thread - %s", strerror (status));
+
+            ThreadPoolDtor (pool);
+
+            return COMMON_ERROR_CREATING_THREAD;
+        }
+
+        pool->workersCount++;
+    }
+
+    return COMMON_ERROR_OK;
+}
+
+void ThreadPoolDtor (threadPool_t *pool)
+{
+    assert (pool);
+
+    pthread_mutex_lock (&pool->mutex);
+    pool->isStopping = true;
+    pthread_cond_broadcast (&pool->hasWork);
+    pthread_mutex_unlock (&pool->mutex);
+
+    for (size_t i = 0; i < pool->workersCount; i++)
+        pthread_join (pool->workers[i], NULL);
+
+    free (pool->workers);
+
+    pool->workers      = NULL;
+    pool->workersCount = 0;
+}
+
+void ThreadPoolRun (threadPool_t *pool, threadPoolTask_t task, void *arg, size_t tasksCount)
+{
+    assert (pool);
+    assert (task);
+
+    pthread_mutex_lock (&pool->mutex);
+
+    pool->task       = task;
+    pool->taskArg    = arg;
+    pool->tasksCount = tasksCount;
+    pool->nextTask   = 0;
+    pool->doneTasks  = 0;
+
+    pthread_cond_broadcast (&pool->hasWork);
+
+    ThreadPoolTakeTasks (pool);
+
+    while (pool->doneTasks < pool->tasksCount)
+        pthread_cond_wait (&pool->allDone, &pool->mutex);
+
+    pool->task       = NULL;
+    pool->taskArg    = NULL;
+    pool->tasksCount = 0;
+    pool->nextTask   = 0;
+    pool->doneTasks  = 0;
+
+    pthread_mutex_unlock (&pool->mutex);
+}
+
+// called and returns with locked mutex
+void ThreadPoolTakeTasks (threadPool_t *pool)
+{
+    assert (pool);
+
+    while (pool->nextTask < pool->tasksCount)
+    {
+        threadPoolTask_t task = pool->task;
+        void *taskArg         = pool->taskArg;
+        size_t taskIdx        = pool->nextTask;
+
+        pool->nextTask++;
+
+        pthread_mutex_unlock (&pool->mutex);
+
+        task (taskArg, taskIdx);
+
+        pthread_mutex_lock (&pool->mutex);
+
+        pool->doneTasks++;
+        if (pool->doneTasks == pool->tasksCount)
+            pthread_cond_signal (&pool->allDone);
+    }
+}
+
+void *ThreadPoolWorker (void *poolPtr)
+{
+    assert (poolPtr);
+
+    threadPool_t *pool = (threadPool_t *) poolPtr;
+
+    pthread_mutex_lock (&pool->mutex);
+
+    while (true)
+    {
+        while (!pool->isStopping && pool->nextTask >= pool->tasksCount)
+            pthread_cond_wait (&pool->hasWork, &pool->mutex);
+
+        if (pool->isStopping)
+            break;
+
+        ThreadPoolTakeTasks (pool);
+    }
+
+    pthread_mutex_unlock (&pool->mutex);
+
+    return NULL;
+}
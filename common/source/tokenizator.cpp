@@ -1,34 +1,62 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <ctype.h>
 #include <assert.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "tokenizator.h"
 
+#include "lexer_dfa.h"
+#include "simd_scan.h"
+#include "thread_pool.h"
 #include "utils.h"
 
-int FillTokensArray (char *buffer, program_t *program);
+int TokenAddNext (char **curPos, tokensArray_t *tokens, namesTable_t *namesTable, 
+                  uint32_t offset);
 
-int TryToFindOperator (char **curPos, program_t *program, size_t line, size_t position);
+int TokenAddMatched (char **curPos, size_t len, uint8_t accept,
+                     tokensArray_t *tokens, namesTable_t *namesTable, uint32_t offset);
 
-int TokenAddNumber (char **curPos, tokensArray_t *tokens, size_t line, size_t position);
+int TokenAddNumber (char **curPos, tokensArray_t *tokens, uint32_t offset);
 
-int TokenAddName (char **curPos, tokensArray_t *tokens, namesTable_t *namesTable,
-                  size_t line, size_t position);
+int TokenAddName (char **curPos, size_t len, tokensArray_t *tokens, namesTable_t *namesTable,
+                  uint32_t offset);
 
-int TokenAdd (tokensArray_t *tokens, type_t type, value_t value, 
-              size_t line, size_t position);
+static int TokensArrayShrink    (tokensArray_t *tokens);
+static int TokensIndexLines     (tokensArray_t *tokens, const char *buffer, size_t bufferLen);
 
-int CheckForReallocTokens (tokensArray_t *tokens);
+static int GetTokensSequential  (program_t *program);
+static int GetTokensParallel    (program_t *program, size_t threadsCount);
+
+static size_t TokensFindByOffset    (tokensArray_t *tokens, size_t offset);
+static size_t LineStartsFindAfter   (dynamicArray_t <uint32_t> *lineStarts, size_t offset);
+static int    TokensEditLines       (tokensArray_t *tokens, const char *buffer, 
+                                     const sourceEdit_t *edit);
+static int    TokensSplice          (tokensArray_t *tokens, size_t first, size_t last, 
+                                     size_t splicedFirst, const sourceEdit_t *edit);
+
+static size_t TokensCountColumn (tokensArray_t *tokens, size_t lineStart, size_t offset);
+
+static int  TokenStreamRead     (tokenStream_t *stream);
+static void TokenStreamDtor     (tokenStream_t *stream);
 
 #define LEXICAL_ERROR(format, ...)                                      \
         {                                                               \
+            if (tokens->isQuiet)                                        \
+                return TREE_ERROR_SYNTAX_IN_SAVE_FILE;                  \
+                                                                        \
+            size_t errorLine   = 0;                                     \
+            size_t errorColumn = 0;                                     \
+            TokensFindLineAndColumn (tokens, offset,                    \
+                                     &errorLine, &errorColumn);         \
+                                                                        \
             ERROR_PRINT ("%s:%lu:%lu Lexical Error - " format,          \
                          tokens->fileName,                              \
-                         line,                                          \
-                         position,                                      \
+                         errorLine,                                     \
+                         errorColumn,                                   \
                          __VA_ARGS__);                                  \
                                                                         \
             return TREE_ERROR_SYNTAX_IN_SAVE_FILE;                      \
@@ -40,235 +68,1244 @@ int TokensArrayCtor (tokensArray_t *tokens)
     
     const size_t kTokensInitCapacity = 16;
 
-    tokens->size     = 0;
-    tokens->capacity = kTokensInitCapacity;
+    tokens->kinds    = NULL;
+    tokens->payloads = NULL;
+    tokens->offsets  = NULL;
 
-    tokens->data = (token_t *) calloc (tokens->capacity, sizeof (token_t));
+    tokens->size     = 0;
+    tokens->capacity = 0;
 
-    if (tokens->data == NULL)
-    {
-        ERROR_LOG ("Error allocating memory for tokens->data - %s",
-                    strerror (errno));
+    tokens->isQuiet  = false;
+    tokens->stream   = NULL;
+    tokens->names    = NULL;
 
+    int status = DynamicArrayCtor (&tokens->lineStarts, 0);
+    if (status != COMMON_ERROR_OK)
         return TREE_ERROR_COMMON |
-               COMMON_ERROR_ALLOCATING_MEMORY;
-    }
+               status;
 
-    return TREE_OK;
+    return TokensArrayReserve (tokens, kTokensInitCapacity);
 }
 
 void TokensArrayDtor (tokensArray_t *tokens)
 {
     assert (tokens);
     
-    free (tokens->data);
-    tokens->data = NULL;
+    free (tokens->kinds);
+    free (tokens->payloads);
+    free (tokens->offsets);
 
-    tokens->fileName = NULL;
+    tokens->kinds    = NULL;
+    tokens->payloads = NULL;
+    tokens->offsets  = NULL;
 
     tokens->size     = 0;
     tokens->capacity = 0;
+
+    DynamicArrayDtor (&tokens->lineStarts);
+
+    tokens->fileName = NULL;
+    tokens->source   = NULL;
+
+    if (tokens->stream != NULL)
+    {
+        TokenStreamDtor (tokens->stream);
+
+        free (tokens->stream);
+        tokens->stream = NULL;
+    }
+}
+
+// all columns are reallocated together, capacity is updated only if all of them succeed
+int TokensArrayReserve (tokensArray_t *tokens, size_t capacity)
+{
+    assert (tokens);
+
+    if (capacity <= tokens->capacity)
+        return TREE_OK;
+
+    uint8_t *kinds = DynamicArrayRealloc (tokens->kinds, tokens->size, capacity);
+    if (kinds != NULL)
+        tokens->kinds = kinds;
+
+    uint32_t *payloads = DynamicArrayRealloc (tokens->payloads, tokens->size, capacity);
+    if (payloads != NULL)
+        tokens->payloads = payloads;
+
+    uint32_t *offsets = DynamicArrayRealloc (tokens->offsets, tokens->size, capacity);
+    if (offsets != NULL)
+        tokens->offsets = offsets;
+
+    if (kinds == NULL || payloads == NULL || offsets == NULL)
+    {
+        ERROR_LOG ("Error reallocating memory for %lu tokens - %s", capacity, strerror (errno));
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_REALLOCATING_MEMORY;
+    }
+
+    tokens->capacity = capacity;
+
+    return TREE_OK;
+}
+
+int TokensArrayShrink (tokensArray_t *tokens)
+{
+    assert (tokens);
+
+    if (tokens->size == tokens->capacity || tokens->size == 0)
+        return TREE_OK;
+
+    uint8_t *kinds = DynamicArrayRealloc (tokens->kinds, tokens->size, tokens->size);
+    if (kinds != NULL)
+        tokens->kinds = kinds;
+
+    uint32_t *payloads = DynamicArrayRealloc (tokens->payloads, tokens->size, tokens->size);
+    if (payloads != NULL)
+        tokens->payloads = payloads;
+
+    uint32_t *offsets = DynamicArrayRealloc (tokens->offsets, tokens->size, tokens->size);
+    if (offsets != NULL)
+        tokens->offsets = offsets;
+
+    if (kinds == NULL || payloads == NULL || offsets == NULL)
+    {
+        ERROR_LOG ("Error reallocating memory for %lu tokens - %s", tokens->size, strerror (errno));
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_REALLOCATING_MEMORY;
+    }
+
+    tokens->capacity = tokens->size;
+
+    return TREE_OK;
+}
+
+// lineStarts[i] is offset of line i + 1, so position of any offset is found by binary search
+int TokensIndexLines (tokensArray_t *tokens, const char *buffer, size_t bufferLen)
+{
+    assert (tokens);
+    assert (buffer);
+
+    // newlines are counted first, so line starts are written without reallocations
+    size_t newLinesCount = ScanCountNewLines (buffer, bufferLen);
+
+    int status = DynamicArrayResize (&tokens->lineStarts, newLinesCount + 1);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    tokens->lineStarts.data[0] = 0;
+
+    ScanNewLines (buffer, bufferLen, tokens->lineStarts.data + 1);
+
+    return TREE_OK;
+}
+
+// Line and column are counted from 1, column is in UTF-8 characters. Lexer tracks only
+// byte offsets, characters are counted here, when some error is reported.
+// In stream mode there are no line starts, offset can be only of the token being lexed
+void TokensFindLineAndColumn (tokensArray_t *tokens, size_t offset, size_t *line, size_t *column)
+{
+    assert (tokens);
+    assert (line);
+    assert (column);
+
+    if (tokens->stream != NULL)
+    {
+        *line   = tokens->stream->line;
+        *column = tokens->stream->column;
+
+        return;
+    }
+
+    const uint32_t *lineStarts = tokens->lineStarts.data;
+
+    if (tokens->lineStarts.size == 0)
+    {
+        *line   = 1;
+        *column = TokensCountColumn (tokens, 0, offset);
+
+        return;
+    }
+
+    // last line beginning not after offset
+    size_t left  = 0;
+    size_t right = tokens->lineStarts.size;
+
+    while (right - left > 1)
+    {
+        size_t middle = left + (right - left) / 2;
+
+        if (lineStarts[middle] <= offset)
+            left = middle;
+        else
+            right = middle;
+    }
+
+    *line   = left + 1;
+    *column = TokensCountColumn (tokens, lineStarts[left], offset);
+}
+
+size_t TokensCountColumn (tokensArray_t *tokens, size_t lineStart, size_t offset)
+{
+    assert (tokens);
+    assert (lineStart <= offset);
+
+    if (tokens->source == NULL)
+        return offset - lineStart + 1;
+
+    return Utf8Length (tokens->source + lineStart, offset - lineStart) + 1;
+}
+
+// tokenIdx can be equal to tokens->size, then position of the last token is given
+void TokenGetLineAndColumn (tokensArray_t *tokens, size_t tokenIdx, size_t *line, size_t *column)
+{
+    assert (tokens);
+    assert (line);
+    assert (column);
+
+    if (tokenIdx >= tokens->size && tokens->size > 0)
+        tokenIdx = tokens->size - 1;
+
+    if (tokens->stream != NULL && tokens->size > 0)
+    {
+        *line   = tokens->stream->tokenLines   [TokenSlot (tokens, tokenIdx)];
+        *column = tokens->stream->tokenColumns [TokenSlot (tokens, tokenIdx)];
+
+        return;
+    }
+
+    size_t offset = 0;
+
+    if (tokenIdx < tokens->size)
+        offset = tokens->offsets[tokenIdx];
+
+    TokensFindLineAndColumn (tokens, offset, line, column);
+}
+
+// part of the source lexed by one task of parallel lexer
+struct lexerChunk_t
+{
+    char *begin = NULL;
+    char *end   = NULL;
+
+    tokensArray_t tokens    = {};   // offsets are from the source beginning, line starts - from chunk begin
+    namesTable_t names      = {};   // chunk's own name ids, they are remapped while merging
+
+    size_t *namesRemap  = NULL;     // chunk name id -> program name id
+    size_t firstToken   = 0;        // positions in merged arrays
+    size_t firstLine    = 0;
+
+    int status = TREE_OK;
+};
+
+struct parallelLexer_t
+{
+    char *buffer            = NULL;
+
+    lexerChunk_t *chunks    = NULL;
+    size_t chunksCount      = 0;
+
+    tokensArray_t *tokens   = NULL; // merged
+};
+
+static void LexChunkTask        (void *lexerPtr, size_t chunkIdx);
+static void CopyChunkTask       (void *lexerPtr, size_t chunkIdx);
+static int  MergeChunksNames    (parallelLexer_t *lexer, namesTable_t *namesTable);
+static void LexerChunksSplit    (parallelLexer_t *lexer, size_t bufferLen);
+static void LexerChunksDtor     (parallelLexer_t *lexer);
+
+// whitespace is always between tokens, so source can be split by it
+constexpr bool KeywordsHaveNoSpaces ()
+{
+    for (size_t i = 0; i < kNumberOfKeywords; i++)
+    {
+        for (size_t j = 0; j < kKeywords[i].nameLen; j++)
+        {
+            char c = kKeywords[i].name[j];
+
+            if (c == ' ' || (c >= '\t' && c <= '\r'))
+                return false;
+        }
+    }
+
+    return true;
 }
 
-int GetTokens (const char *fileName, program_t *program)
+static_assert (KeywordsHaveNoSpaces (), "parallel lexer splits source by whitespace");
+
+// smaller sources are lexed sequentially, threads aren't worth it
+const size_t kLexerMinChunkSize     = 1 << 20;
+const size_t kLexerChunksPerThread  = 4;
+
+// about one token per kSourceBytesPerToken bytes of source, extra capacity is cut afterwards
+const size_t kSourceBytesPerToken   = 8;
+
+// threadsCount = 0 means number of online CPUs. Result doesn't depend on threadsCount
+int GetTokens (const char *fileName, program_t *program, size_t threadsCount)
 {
     assert (program);
 
-    size_t bufferLen = 0;
-    program->buffer = ReadFile (fileName, &bufferLen);
+    int status = SourceBufferOpen (&program->source, fileName);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    program->tokens.fileName = fileName;
+    program->tokens.source   = program->source.data;
+
+    if (program->source.size >= UINT32_MAX)
+    {
+        ERROR_PRINT ("%s: source is bigger than 4 GB, token offsets don't fit in 32 bits", fileName);
 
-    if (program->buffer == NULL)
         return TREE_ERROR_COMMON |
                COMMON_ERROR_READING_FILE;
+    }
 
-    program->tokens.fileName = fileName;
+    if (threadsCount == 0)
+        threadsCount = (size_t) sysconf (_SC_NPROCESSORS_ONLN);
 
-    TREE_DO_AND_CLEAR (FillTokensArray (program->buffer, program), 
-                       DumpTokens (program));
+    if (threadsCount > 1 && program->source.size >= 2 * kLexerMinChunkSize)
+        status = GetTokensParallel (program, threadsCount);
+    else
+        status = GetTokensSequential (program);
+
+    if (status != TREE_OK)
+        return status;
+
+    TREE_DO_AND_RETURN (NAMES_TABLE_VERIFY (&program->namesTable));
 
     DEBUG_LOG ("Tokens number - %lu", program->tokens.size);
 
     return TREE_OK;
 }
 
-#define IS_PREVIOUS_TOKEN_KEYWORD(keyword)                                      \
-        (program->tokens.size >= 1 &&                                           \
-         program->tokens.data[program->tokens.size - 1].type == TYPE_KEYWORD && \
-         program->tokens.data[program->tokens.size - 1].value.idx == keyword)
+int GetTokensSequential (program_t *program)
+{
+    assert (program);
+
+    char *buffer     = program->source.data;
+    size_t bufferLen = program->source.size;
+
+    TREE_DO_AND_RETURN (TokensIndexLines (&program->tokens, buffer, bufferLen));
+
+    TREE_DO_AND_RETURN (TokensArrayReserve (&program->tokens, bufferLen / kSourceBytesPerToken));
+
+    TREE_DO_AND_CLEAR (FillTokensArray (buffer, buffer, buffer + bufferLen, 
+                                        &program->tokens, &program->namesTable), 
+                       DumpTokens (program));
+
+    TREE_DO_AND_RETURN (TokensArrayShrink (&program->tokens));
+
+    return TREE_OK;
+}
 
-int FillTokensArray (char *buffer, program_t *program)
+// Chunks are lexed into their own tokens and names tables on a thread pool.
+// Then names are added to program's table chunk by chunk, so ids are given in order of
+// first appearance, like in sequential lexer, and token arrays are copied with remapped ids.
+// If some chunk fails, source is lexed again sequentially to report the first error
+int GetTokensParallel (program_t *program, size_t threadsCount)
 {
-    assert (buffer);
     assert (program);
+    assert (threadsCount > 1);
+
+    char *buffer = program->source.data;
+
+    // sequential lexer stops at '\0'
+    const char *nullByte = (const char *) memchr (buffer, '\0', program->source.size);
+    size_t bufferLen = (nullByte == NULL) ? program->source.size : size_t (nullByte - buffer);
+
+    parallelLexer_t lexer = {.buffer = buffer, .tokens = &program->tokens};
+
+    lexer.chunksCount = threadsCount * kLexerChunksPerThread;
+    if (lexer.chunksCount > bufferLen / kLexerMinChunkSize)
+        lexer.chunksCount = bufferLen / kLexerMinChunkSize;
+
+    if (lexer.chunksCount < 2)
+        return GetTokensSequential (program);
+
+    lexer.chunks = (lexerChunk_t *) calloc (lexer.chunksCount, sizeof (lexerChunk_t));
+    if (lexer.chunks == NULL)
+    {
+        ERROR_LOG ("Error allocating memory for %lu lexer chunks", lexer.chunksCount);
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_ALLOCATING_MEMORY;
+    }
 
-    size_t line     = 1;
-    size_t position = 1;
+    LexerChunksSplit (&lexer, bufferLen);
 
-    for (char *curPos = buffer; *curPos != '\0';)
+    threadPool_t pool = {};
+
+    int status = ThreadPoolCtor (&pool, threadsCount);
+    if (status != COMMON_ERROR_OK)
+    {
+        LexerChunksDtor (&lexer);
+
+        return TREE_ERROR_COMMON |
+               status;
+    }
+
+    ThreadPoolRun (&pool, LexChunkTask, &lexer, lexer.chunksCount);
+
+    for (size_t i = 0; i < lexer.chunksCount && status == TREE_OK; i++)
+        status = lexer.chunks[i].status;
+
+    if (status == TREE_OK)
+        status = MergeChunksNames (&lexer, &program->namesTable);
+
+    if (status == TREE_OK)
+        ThreadPoolRun (&pool, CopyChunkTask, &lexer, lexer.chunksCount);
+
+    ThreadPoolDtor (&pool);
+    LexerChunksDtor (&lexer);
+
+    if (status != TREE_OK)
     {
-        curPos = SkipSpacesAndCount (curPos, &line, &position);
+        DEBUG_LOG ("Parallel lexing failed (%d), lexing sequentially", status);
+
+        const char *fileName = program->tokens.fileName;
+
+        TokensArrayDtor (&program->tokens);
+        NamesTableDtor  (&program->namesTable);
+
+        TREE_DO_AND_RETURN (TokensArrayCtor (&program->tokens));
+        TREE_DO_AND_RETURN (NamesTableCtor  (&program->namesTable));
+
+        program->tokens.fileName = fileName;
+        program->tokens.source   = program->source.data;
+
+        return GetTokensSequential (program);
+    }
+
+    return TREE_OK;
+}
 
-        DEBUG_STR (curPos);
-        DEBUG_VAR ("%lu", line);
-        DEBUG_VAR ("%lu", position);
+// Chunks are about equal, every boundary is moved to the first byte after whitespace
+void LexerChunksSplit (parallelLexer_t *lexer, size_t bufferLen)
+{
+    assert (lexer);
+    assert (lexer->chunks);
+
+    char *bufferEnd = lexer->buffer + bufferLen;
+    char *begin     = lexer->buffer;
 
-        char *curPosBeforeToken = curPos;
+    size_t chunksCount = 0;
 
-        // FIXME: calc position after adding correct token
+    for (size_t i = 0; i < lexer->chunksCount && begin < bufferEnd; i++)
+    {
+        char *end = bufferEnd;
 
-        if (isdigit (*curPos))
+        if (i + 1 < lexer->chunksCount)
         {
-            TREE_DO_AND_RETURN (TokenAddNumber (&curPos, &program->tokens, line, position));
+            end = lexer->buffer + bufferLen / lexer->chunksCount * (i + 1);
+            if (end < begin)
+                end = begin;
 
-            DEBUG_LOG ("After adding number: \"%s\"", curPos);
+            while (end < bufferEnd && !isspace ((unsigned char) *end))
+                end++;
 
-            position += size_t (curPos - curPosBeforeToken);
-            
-            continue;
+            if (end < bufferEnd)
+                end++;
         }
 
-        int status = TryToFindOperator (&curPos, program, line, position);
-        if (status == TREE_OK)
+        lexer->chunks[chunksCount].begin = begin;
+        lexer->chunks[chunksCount].end   = end;
+        chunksCount++;
+
+        begin = end;
+    }
+
+    lexer->chunksCount = chunksCount;
+}
+
+void LexChunkTask (void *lexerPtr, size_t chunkIdx)
+{
+    assert (lexerPtr);
+
+    parallelLexer_t *lexer = (parallelLexer_t *) lexerPtr;
+    lexerChunk_t    *chunk = &lexer->chunks[chunkIdx];
+
+    size_t chunkLen = size_t (chunk->end - chunk->begin);
+
+    chunk->status = TokensArrayCtor (&chunk->tokens);
+    if (chunk->status == TREE_OK)
+        chunk->status = NamesTableCtor (&chunk->names);
+    if (chunk->status == TREE_OK)
+        chunk->status = TokensArrayReserve (&chunk->tokens, chunkLen / kSourceBytesPerToken);
+    if (chunk->status != TREE_OK)
+        return;
+
+    chunk->tokens.isQuiet = true;
+
+    chunk->status = FillTokensArray (lexer->buffer, chunk->begin, chunk->end, 
+                                     &chunk->tokens, &chunk->names);
+    if (chunk->status != TREE_OK)
+        return;
+
+    size_t newLinesCount = ScanCountNewLines (chunk->begin, chunkLen);
+    if (newLinesCount == 0)
+        return;
+
+    dynamicArray_t <uint32_t> *lineStarts = &chunk->tokens.lineStarts;
+
+    int status = DynamicArrayResize (lineStarts, newLinesCount);
+    if (status != COMMON_ERROR_OK)
+    {
+        chunk->status = TREE_ERROR_COMMON |
+                        status;
+        return;
+    }
+
+    ScanNewLines (chunk->begin, chunkLen, lineStarts->data);
+}
+
+// sequential, but only distinct names of every chunk are looked up
+int MergeChunksNames (parallelLexer_t *lexer, namesTable_t *namesTable)
+{
+    assert (lexer);
+    assert (namesTable);
+
+    size_t tokensCount = 0;
+    size_t linesCount  = 1;
+
+    for (size_t i = 0; i < lexer->chunksCount; i++)
+    {
+        lexerChunk_t *chunk = &lexer->chunks[i];
+
+        chunk->firstToken = tokensCount;
+        chunk->firstLine  = linesCount;
+
+        tokensCount += chunk->tokens.size;
+        linesCount  += chunk->tokens.lineStarts.size;
+
+        chunk->namesRemap = (size_t *) calloc (chunk->names.size + 1, sizeof (size_t));
+        if (chunk->namesRemap == NULL)
         {
-            position += size_t (curPos - curPosBeforeToken) / 2; 
-            // 2 bytes per char moment. I do not want to use windows CP-1251
+            ERROR_LOG ("Error allocating memory for %lu names", chunk->names.size);
 
-            continue;
+            return TREE_ERROR_COMMON |
+                   COMMON_ERROR_ALLOCATING_MEMORY;
         }
 
-        TREE_DO_AND_RETURN (TokenAddName (&curPos, &program->tokens, &program->namesTable, 
-                                          line, position));
+        for (size_t j = 0; j < chunk->names.size; j++)
+        {
+            const name_t *name = &chunk->names.data[j];
 
-        position += size_t (curPos - curPosBeforeToken);
+            TREE_DO_AND_RETURN (NamesTableFindOrAdd (namesTable, name->name, name->len, 
+                                                     &chunk->namesRemap[j]));
+        }
     }
 
+    // every name takes at least 2 bytes with separator, and source is less than 4 GB
+    assert (namesTable->size <= UINT32_MAX);
+
+    TREE_DO_AND_RETURN (TokensArrayReserve (lexer->tokens, tokensCount));
+
+    int status = DynamicArrayResize (&lexer->tokens->lineStarts, linesCount);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    lexer->tokens->size = tokensCount;
+    lexer->tokens->lineStarts.data[0] = 0;
+
     return TREE_OK;
 }
 
-#undef IS_PREVIOUS_TOKEN_KEYWORD
+void CopyChunkTask (void *lexerPtr, size_t chunkIdx)
+{
+    assert (lexerPtr);
+
+    parallelLexer_t *lexer  = (parallelLexer_t *) lexerPtr;
+    lexerChunk_t    *chunk  = &lexer->chunks[chunkIdx];
+    tokensArray_t   *tokens = lexer->tokens;
+
+    size_t count = chunk->tokens.size;
+    size_t first = chunk->firstToken;
+
+    memcpy (tokens->kinds   + first, chunk->tokens.kinds,   count * sizeof (tokens->kinds[0]));
+    memcpy (tokens->offsets + first, chunk->tokens.offsets, count * sizeof (tokens->offsets[0]));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t payload = chunk->tokens.payloads[i];
+
+        if (chunk->tokens.kinds[i] == TYPE_NAME)
+            payload = (uint32_t) chunk->namesRemap[payload];
+
+        tokens->payloads[first + i] = payload;
+    }
+
+    uint32_t chunkOffset = (uint32_t) (chunk->begin - lexer->buffer);
+
+    const dynamicArray_t <uint32_t> *lineStarts = &chunk->tokens.lineStarts;
+
+    for (size_t i = 0; i < lineStarts->size; i++)
+        tokens->lineStarts.data[chunk->firstLine + i] = chunkOffset + lineStarts->data[i];
+}
+
+void LexerChunksDtor (parallelLexer_t *lexer)
+{
+    assert (lexer);
+
+    for (size_t i = 0; i < lexer->chunksCount; i++)
+    {
+        TokensArrayDtor (&lexer->chunks[i].tokens);
+        NamesTableDtor  (&lexer->chunks[i].names);
+
+        free (lexer->chunks[i].namesRemap);
+    }
+
+    free (lexer->chunks);
 
-int TryToFindOperator (char **curPos, program_t *program, size_t line, size_t position)
+    lexer->chunks      = NULL;
+    lexer->chunksCount = 0;
+}
+
+// Source is edited and only tokens around the edit are lexed again. No token has whitespace
+// in it, so lexing restarts after the last whitespace before the edit and old tokens are
+// kept after the first whitespace after it. Names keep their ids, new ones are added.
+// If lexing fails, tokens are cleared and the whole source is lexed on the next edit
+int GetTokensAfterEdit (program_t *program, const sourceEdit_t *edit, tokensEdit_t *tokensEdit)
 {
-    assert (curPos);
-    assert (*curPos);
     assert (program);
+    assert (edit);
+    assert (tokensEdit);
+    assert (program->tokens.stream == NULL);
 
-    for (size_t i = 0; i < kNumberOfKeywords; i++)
+    tokensArray_t  *tokens = &program->tokens;
+    sourceBuffer_t *source = &program->source;
+
+    if (edit->begin > edit->end || edit->end > source->size ||
+        (edit->textLen > 0 && memchr (edit->text, '\0', edit->textLen) != NULL))
+    {
+        ERROR_LOG ("Wrong edit [%lu, %lu) of %lu bytes source", edit->begin, edit->end, source->size);
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_WRONG_USER_INPUT;
+    }
+
+    size_t oldLen = edit->end - edit->begin;
+
+    if (source->size - oldLen + edit->textLen >= UINT32_MAX)
     {
-        if (strncmp (*curPos, kKeywords[i].name, kKeywords[i].nameLen) == 0)
+        ERROR_PRINT ("%s: edited source is bigger than 4 GB, token offsets don't fit in 32 bits", 
+                     tokens->fileName);
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_WRONG_USER_INPUT;
+    }
+
+    // names point into source until the first edit
+    if (tokens->names == NULL)
+    {
+        TREE_DO_AND_RETURN (NamesTableCopyNames (&program->namesTable, &program->names));
+
+        tokens->names = &program->names;
+    }
+
+    // sequential lexer stops at '\0', it's easier to lex the whole source then
+    bool isWhole = (tokens->size == 0 || memchr (source->data, '\0', source->size) != NULL);
+
+    size_t restart = edit->begin;
+    while (restart > 0 && !isspace ((unsigned char) source->data[restart - 1]))
+        restart--;
+
+    size_t firstToken = TokensFindByOffset (tokens, restart);
+
+    int status = SourceBufferEdit (source, edit->begin, edit->end, edit->text, edit->textLen);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    char *buffer = source->data;
+
+    tokens->source = buffer;
+
+    TREE_DO_AND_RETURN (TokensEditLines (tokens, buffer, edit));
+
+    size_t syncPos = edit->begin + edit->textLen;
+    while (syncPos < source->size && !isspace ((unsigned char) buffer[syncPos]))
+        syncPos++;
+
+    if (syncPos < source->size)
+        syncPos++;
+
+    // offsets of old tokens aren't moved yet
+    size_t lastToken = TokensFindByOffset (tokens, syncPos - edit->textLen + oldLen);
+
+    if (isWhole)
+    {
+        restart     = 0;
+        syncPos     = source->size;
+        firstToken  = 0;
+        lastToken   = tokens->size;
+    }
+
+    // new tokens are added after the old ones and moved to their place afterwards
+    size_t oldSize = tokens->size;
+
+    status = FillTokensArray (buffer, buffer + restart, buffer + syncPos, tokens, &program->namesTable);
+    if (status != TREE_OK)
+    {
+        tokens->size = 0;
+
+        return status;
+    }
+
+    size_t newCount = tokens->size - oldSize;
+
+    // tokens, that are lexed the same, aren't reported as changed
+    size_t same = 0;
+    while (same < newCount && firstToken + same < lastToken &&
+           tokens->kinds   [oldSize + same] == tokens->kinds   [firstToken + same] &&
+           tokens->payloads[oldSize + same] == tokens->payloads[firstToken + same])
+        same++;
+
+    tokensEdit->first = firstToken + same;
+
+    same = 0;
+    while (same < newCount - (tokensEdit->first - firstToken) && 
+           lastToken - same > tokensEdit->first &&
+           tokens->kinds   [tokens->size - 1 - same] == tokens->kinds   [lastToken - 1 - same] &&
+           tokens->payloads[tokens->size - 1 - same] == tokens->payloads[lastToken - 1 - same])
+        same++;
+
+    tokensEdit->oldEnd = lastToken - same;
+    tokensEdit->newEnd = firstToken + newCount - same;
+
+    TREE_DO_AND_RETURN (TokensSplice (tokens, firstToken, lastToken, oldSize, edit));
+
+    DEBUG_LOG ("Edit [%lu, %lu) -> %lu bytes: tokens [%lu, %lu) -> [%lu, %lu), lexed %lu",
+               edit->begin, edit->end, edit->textLen, 
+               tokensEdit->first, tokensEdit->oldEnd, tokensEdit->first, tokensEdit->newEnd, newCount);
+
+    return TREE_OK;
+}
+
+// index of the first token with offset not less than given one
+size_t TokensFindByOffset (tokensArray_t *tokens, size_t offset)
+{
+    assert (tokens);
+
+    size_t left  = 0;
+    size_t right = tokens->size;
+
+    while (left < right)
+    {
+        size_t middle = left + (right - left) / 2;
+
+        if (tokens->offsets[middle] < offset)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+
+    return left;
+}
+
+// index of the first line start after offset
+size_t LineStartsFindAfter (dynamicArray_t <uint32_t> *lineStarts, size_t offset)
+{
+    assert (lineStarts);
+
+    size_t left  = 0;
+    size_t right = lineStarts->size;
+
+    while (left < right)
+    {
+        size_t middle = left + (right - left) / 2;
+
+        if (lineStarts->data[middle] <= offset)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+
+    return left;
+}
+
+// Line starts after the edit are moved, the ones in the edited text are found again.
+// Line start after a removed '\n' is in (begin, end]
+int TokensEditLines (tokensArray_t *tokens, const char *buffer, const sourceEdit_t *edit)
+{
+    assert (tokens);
+    assert (buffer);
+    assert (edit);
+
+    dynamicArray_t <uint32_t> *lineStarts = &tokens->lineStarts;
+
+    size_t removedFirst = LineStartsFindAfter (lineStarts, edit->begin);
+    size_t removedEnd   = LineStartsFindAfter (lineStarts, edit->end);
+
+    size_t oldSize    = lineStarts->size;
+    size_t addedCount = ScanCountNewLines (buffer + edit->begin, edit->textLen);
+    size_t newSize    = oldSize - (removedEnd - removedFirst) + addedCount;
+
+    if (newSize > oldSize)
+    {
+        int status = DynamicArrayResize (lineStarts, newSize);
+        if (status != COMMON_ERROR_OK)
+            return TREE_ERROR_COMMON |
+                   status;
+    }
+
+    uint32_t *data = lineStarts->data;
+
+    memmove (data + removedFirst + addedCount, data + removedEnd, 
+             (oldSize - removedEnd) * sizeof (data[0]));
+
+    for (size_t i = removedFirst + addedCount; i < newSize; i++)
+        data[i] = (uint32_t) (data[i] - (edit->end - edit->begin) + edit->textLen);
+
+    ScanNewLines (buffer + edit->begin, edit->textLen, data + removedFirst);
+
+    for (size_t i = removedFirst; i < removedFirst + addedCount; i++)
+        data[i] += (uint32_t) edit->begin;
+
+    lineStarts->size = newSize;
+
+    return TREE_OK;
+}
+
+// Tokens [first, last) are replaced by the ones from splicedFirst to the end,
+// offsets of tokens after them are moved by the edit
+int TokensSplice (tokensArray_t *tokens, size_t first, size_t last, size_t splicedFirst, 
+                  const sourceEdit_t *edit)
+{
+    assert (tokens);
+    assert (edit);
+    assert (first <= last && last <= splicedFirst && splicedFirst <= tokens->size);
+
+    size_t splicedCount = tokens->size - splicedFirst;
+    size_t tailCount    = splicedFirst - last;
+
+    uint8_t  *kinds     = NULL;
+    uint32_t *payloads  = NULL;
+    uint32_t *offsets   = NULL;
+
+    if (splicedCount > 0)
+    {
+        kinds    = (uint8_t  *) calloc (splicedCount, sizeof (kinds[0]));
+        payloads = (uint32_t *) calloc (splicedCount, sizeof (payloads[0]));
+        offsets  = (uint32_t *) calloc (splicedCount, sizeof (offsets[0]));
+
+        if (kinds == NULL || payloads == NULL || offsets == NULL)
         {
-            TREE_DO_AND_RETURN (TokenAdd (&program->tokens, TYPE_KEYWORD, {.idx = kKeywords[i].idx}, 
-                                          line, position));
+            ERROR_LOG ("Error allocating memory for %lu tokens - %s", splicedCount, strerror (errno));
 
-            (*curPos) += kKeywords[i].nameLen;
+            free (kinds);
+            free (payloads);
+            free (offsets);
 
-            DEBUG_STR (kKeywords[i].name);
-            DEBUG_VAR ("%d", kKeywords[i].idx);
-            DEBUG_VAR ("%lu", line);
-            
-            return TREE_OK;
+            return TREE_ERROR_COMMON |
+                   COMMON_ERROR_ALLOCATING_MEMORY;
         }
+
+        memcpy (kinds,    tokens->kinds    + splicedFirst, splicedCount * sizeof (kinds[0]));
+        memcpy (payloads, tokens->payloads + splicedFirst, splicedCount * sizeof (payloads[0]));
+        memcpy (offsets,  tokens->offsets  + splicedFirst, splicedCount * sizeof (offsets[0]));
+    }
+
+    size_t tailFirst = first + splicedCount;
+
+    memmove (tokens->kinds    + tailFirst, tokens->kinds    + last, tailCount * sizeof (kinds[0]));
+    memmove (tokens->payloads + tailFirst, tokens->payloads + last, tailCount * sizeof (payloads[0]));
+    memmove (tokens->offsets  + tailFirst, tokens->offsets  + last, tailCount * sizeof (offsets[0]));
+
+    for (size_t i = tailFirst; i < tailFirst + tailCount; i++)
+        tokens->offsets[i] = (uint32_t) (tokens->offsets[i] - (edit->end - edit->begin) + edit->textLen);
+
+    if (splicedCount > 0)
+    {
+        memcpy (tokens->kinds    + first, kinds,    splicedCount * sizeof (kinds[0]));
+        memcpy (tokens->payloads + first, payloads, splicedCount * sizeof (payloads[0]));
+        memcpy (tokens->offsets  + first, offsets,  splicedCount * sizeof (offsets[0]));
     }
 
-    return TREE_ERROR_INVALID_TOKEN;
+    free (kinds);
+    free (payloads);
+    free (offsets);
+
+    tokens->size = tailFirst + tailCount;
+
+    return TREE_OK;
 }
 
-int CheckForReallocTokens (tokensArray_t *tokens)
+// Tokens aren't lexed here, parser pulls them with TokensHave (). Lexer memory doesn't depend
+// on source size: block, window of the last tokens and the names table
+int TokenStreamOpen (const char *fileName, program_t *program, size_t blockSize)
 {
-    assert (tokens);
+    assert (fileName);
+    assert (program);
+    assert (blockSize > 0);
 
-    if (tokens->size < tokens->capacity)
-        return TREE_OK;
+    tokensArray_t *tokens = &program->tokens;
 
-    if (tokens->capacity == 0)
-        tokens->capacity = 1;
-    
-    tokens->capacity *= 2;
+    assert (tokens->stream == NULL);
+    assert (tokens->size == 0);
+
+    tokenStream_t *stream = (tokenStream_t *) calloc (1, sizeof (tokenStream_t));
+    if (stream == NULL)
+    {
+        ERROR_LOG ("Error allocating memory for token stream - %s", strerror (errno));
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_ALLOCATING_MEMORY;
+    }
+
+    *stream = {};
 
-    token_t *newData = (token_t *) realloc (tokens->data, tokens->capacity * sizeof (token_t));
+    // from now on it's freed by TokensArrayDtor ()
+    tokens->stream   = stream;
+    tokens->fileName = fileName;
 
-    if (newData == NULL)
+    stream->namesTable = &program->namesTable;
+    tokens->names      = &program->names;
+
+    stream->file = fopen (fileName, "rb");
+    if (stream->file == NULL)
     {
-        ERROR_LOG ("Error reallocating memory - %s", strerror (errno));
+        ERROR_LOG ("Error opening file \"%s\" - %s", fileName, strerror (errno));
 
         return TREE_ERROR_COMMON |
-                COMMON_ERROR_ALLOCATING_MEMORY;
+               COMMON_ERROR_OPENING_FILE;
+    }
+
+    stream->block = (char *) calloc (blockSize + 1, sizeof (char));
+    if (stream->block == NULL)
+    {
+        ERROR_LOG ("Error allocating memory for %lu bytes block - %s", blockSize, strerror (errno));
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_ALLOCATING_MEMORY;
+    }
+
+    stream->blockSize = blockSize;
+    stream->curPos    = stream->block;
+    stream->dataEnd   = stream->block;
+
+    return TokensArrayReserve (tokens, kTokensStreamWindow);
+}
+
+void TokenStreamDtor (tokenStream_t *stream)
+{
+    assert (stream);
+
+    if (stream->file != NULL)
+        fclose (stream->file);
+
+    free (stream->block);
+
+    *stream = {};
+}
+
+// Tokens are lexed until there is token tokenIdx or source is over.
+// Source ends at the end of file or at '\0', trailing whitespace is fine
+int TokenStreamPull (tokensArray_t *tokens, size_t tokenIdx)
+{
+    assert (tokens);
+    assert (tokens->stream);
+
+    tokenStream_t *stream = tokens->stream;
+
+    while (tokens->size <= tokenIdx && !stream->isEnd)
+    {
+        stream->curPos = SkipSpacesAndCount (stream->curPos, &stream->line, &stream->column);
+
+        bool isBlockOver = (stream->curPos == stream->dataEnd);
+
+        if ((isBlockOver && stream->isEof) || (!isBlockOver && *stream->curPos == '\0'))
+        {
+            stream->isEnd = true;
+            break;
+        }
+
+        // token can continue in the next part of file
+        if (isBlockOver || (!stream->isEof && (stream->lastSpace == NULL || 
+                                               stream->curPos > stream->lastSpace)))
+        {
+            stream->status = TokenStreamRead (stream);
+            if (stream->status != TREE_OK)
+                stream->isEnd = true;
+
+            continue;
+        }
+
+        char *tokenBegin = stream->curPos;
+        size_t slot      = tokens->size % kTokensStreamWindow;
+
+        stream->tokenLines  [slot] = stream->line;
+        stream->tokenColumns[slot] = stream->column;
+
+        // only low 32 bits for huge sources, positions of tokens are in tokenLines and tokenColumns
+        uint32_t offset = (uint32_t) (stream->blockOffset + size_t (tokenBegin - stream->block));
+
+        stream->status = TokenAddNext (&stream->curPos, tokens, stream->namesTable, offset);
+        if (stream->status != TREE_OK)
+        {
+            stream->isEnd = true;
+            break;
+        }
+
+        // whitespace is ASCII, so only tokens can have multibyte characters
+        stream->column += Utf8Length (tokenBegin, size_t (stream->curPos - tokenBegin));
+    }
+
+    return stream->status;
+}
+
+// Not lexed tail is moved to the block beginning and the rest of block is read from file
+int TokenStreamRead (tokenStream_t *stream)
+{
+    assert (stream);
+    assert (!stream->isEof);
+
+    size_t tailLen = size_t (stream->dataEnd - stream->curPos);
+
+    // one token takes the whole block
+    if (tailLen == stream->blockSize)
+    {
+        size_t newBlockSize = 2 * stream->blockSize;
+
+        char *newBlock = (char *) realloc (stream->block, newBlockSize + 1);
+        if (newBlock == NULL)
+        {
+            ERROR_LOG ("Error reallocating memory for %lu bytes block - %s", 
+                       newBlockSize, strerror (errno));
+
+            return TREE_ERROR_COMMON |
+                   COMMON_ERROR_REALLOCATING_MEMORY;
+        }
+
+        DEBUG_LOG ("Token stream block is grown to %lu bytes", newBlockSize);
+
+        stream->block     = newBlock;
+        stream->blockSize = newBlockSize;
+    }
+    else
+    {
+        stream->blockOffset += size_t (stream->curPos - stream->block);
+
+        memmove (stream->block, stream->curPos, tailLen);
+    }
+
+    size_t freeLen = stream->blockSize - tailLen;
+    size_t readLen = fread (stream->block + tailLen, sizeof (char), freeLen, stream->file);
+
+    if (readLen < freeLen)
+    {
+        if (ferror (stream->file))
+        {
+            ERROR_LOG ("Error reading source - %s", strerror (errno));
+
+            return TREE_ERROR_COMMON |
+                   COMMON_ERROR_READING_FILE;
+        }
+
+        stream->isEof = true;
+    }
+
+    stream->curPos  = stream->block;
+    stream->dataEnd = stream->block + tailLen + readLen;
+
+    *stream->dataEnd = '\0';
+
+    stream->lastSpace = NULL;
+
+    for (char *pos = stream->dataEnd; pos > stream->block; pos--)
+    {
+        if (isspace ((unsigned char) pos[-1]))
+        {
+            stream->lastSpace = pos - 1;
+            break;
+        }
     }
-    
-    tokens->data = newData;
 
     return TREE_OK;
 }
 
-int TokenAdd (tokensArray_t *tokens, type_t type, value_t value, 
-              size_t line, size_t position)
+// Tokens beginning in [begin, end) are added, offsets are counted from buffer.
+// end is either end of the source or a byte after whitespace, so no token crosses it
+int FillTokensArray (char *buffer, char *begin, char *end,
+                     tokensArray_t *tokens, namesTable_t *namesTable)
 {
+    assert (buffer);
+    assert (begin);
+    assert (end);
     assert (tokens);
+    assert (namesTable);
+
+    // whitespace at the end of a chunk (next token belongs to the next one) is skipped too
+    for (char *curPos = begin; curPos < end && *curPos != '\0';)
+    {
+        // indentation is long, SIMD skips it faster than DFA
+        if (LexerDfaIsSpace ((unsigned char) *curPos))
+        {
+            curPos = SkipSpaces (curPos);
+            continue;
+        }
 
-    TREE_DO_AND_RETURN (CheckForReallocTokens (tokens));
+        uint8_t accept = LEXER_DFA_ACCEPT_NONE;
+        size_t  len    = LexerDfaMatch (curPos, &accept);
 
-    tokens->data[tokens->size] = {.type = type, .value = value,
-                                  .line = line, .position = position};
-    tokens->size++;
+        uint32_t offset = (uint32_t) (curPos - buffer);
+
+        TREE_DO_AND_RETURN (TokenAddMatched (&curPos, len, accept, tokens, namesTable, offset));
+    }
 
     return TREE_OK;
 }
 
-int TokenAddNumber (char **curPos, tokensArray_t *tokens, size_t line, size_t position)
+// *curPos is at the beginning of a token (not whitespace)
+int TokenAddNext (char **curPos, tokensArray_t *tokens, namesTable_t *namesTable, 
+                  uint32_t offset)
 {
     assert (curPos);
     assert (*curPos);
-    assert (tokens);
-
-    int bytesRead = 0;
-    int number = 0;
 
-    // FIXME: this can read negative numbers, which isn't in our Gramma
-    int status = sscanf (*curPos, "%d%n", &number, &bytesRead);
-    if (status < 1)
-        return TREE_ERROR_COMMON |
-               COMMON_ERROR_SSCANF;
+    uint8_t accept = LEXER_DFA_ACCEPT_NONE;
+    size_t  len    = LexerDfaMatch (*curPos, &accept);
 
-    *curPos += bytesRead;
+    assert (accept != LEXER_DFA_ACCEPT_SPACE);
 
-    return TokenAdd (tokens, TYPE_CONST_NUM, {.number = number}, line, position);
+    return TokenAddMatched (curPos, len, accept, tokens, namesTable, offset);
 }
 
-int TokenAddName (char **curPos, tokensArray_t *tokens, namesTable_t *namesTable,
-                  size_t line, size_t position)
+// token of len bytes at *curPos is accepted by lexer DFA as accept
+int TokenAddMatched (char **curPos, size_t len, uint8_t accept,
+                     tokensArray_t *tokens, namesTable_t *namesTable, uint32_t offset)
 {
     assert (curPos);
     assert (*curPos);
     assert (tokens);
     assert (namesTable);
-    
-    if (!isalpha (**curPos) && **curPos != '_')
+
+    DEBUG_VAR ("%u", offset);
+    DEBUG_VAR ("%d", accept);
+
+    switch (accept)
     {
-        LEXICAL_ERROR ("Uknown token: Variables can't start with '%c'", 
-                       **curPos);
+        case LEXER_DFA_ACCEPT_NUMBER:
+            return TokenAddNumber (curPos, tokens, offset);
+
+        case LEXER_DFA_ACCEPT_NAME:
+            return TokenAddName (curPos, len, tokens, namesTable, offset);
+
+        case LEXER_DFA_ACCEPT_NONE:
+            LEXICAL_ERROR ("Uknown token: Variables can't start with '%c'", 
+                           **curPos);
+
+        case LEXER_DFA_ACCEPT_SPACE:
+        default:
+            break;
     }
 
-    char *nameStr = *curPos;
-        
-    (*curPos)++;
+    assert (accept >= kLexerDfaAcceptKeyword);
 
-    DEBUG_VAR ("%p", *curPos);
+    const keyword_t *keyword = &kKeywords[accept - kLexerDfaAcceptKeyword];
+
+    DEBUG_STR (keyword->name);
+    DEBUG_VAR ("%d", keyword->idx);
+
+    TREE_DO_AND_RETURN (TokenAdd (tokens, TYPE_KEYWORD, {.idx = keyword->idx}, offset));
+
+    (*curPos) += len;
+
+    return TREE_OK;
+}
+
+int TokenAdd (tokensArray_t *tokens, type_t type, value_t value, uint32_t offset)
+{
+    assert (tokens);
+    assert (type == TYPE_CONST_NUM || value.idx <= UINT32_MAX);
+
+    if (tokens->size == tokens->capacity && tokens->stream == NULL)
+        TREE_DO_AND_RETURN (TokensArrayReserve (tokens, DynamicArrayGrowCapacity (tokens->capacity,
+                                                                                  tokens->size + 1)));
+
+    // in stream mode the oldest token is overwritten
+    size_t slot = (tokens->stream == NULL) ? tokens->size : tokens->size % kTokensStreamWindow;
+
+    tokens->kinds[slot] = (uint8_t) type;
+
+    if (type == TYPE_CONST_NUM)
+        tokens->payloads[slot] = (uint32_t) value.number;
+    else
+        tokens->payloads[slot] = (uint32_t) value.idx;
+
+    tokens->offsets[slot] = offset;
+
+    tokens->size++;
+
+    return TREE_OK;
+}
 
-    while (isalpha (**curPos) || isdigit (**curPos) || **curPos == '_')
+int TokenAddNumber (char **curPos, tokensArray_t *tokens, uint32_t offset)
+{
+    assert (curPos);
+    assert (*curPos);
+    assert (tokens);
+
+    numberLiteral_t literal = {};
+
+    size_t len = ScanNumber (*curPos, &literal);
+    assert (len > 0);
+
+    // numbers are valueNumber_t, so only fractions like "2.0" can be stored
+    if (literal.fraction != 0)
+    {
+        LEXICAL_ERROR ("Fractional number %.*s: only integer values are supported", 
+                       (int) len, *curPos);
+    }
+
+    if (literal.isOverflow || literal.integer > (uint64_t) kValueNumberMax)
     {
-        DEBUG_LOG ("**curPos(variable name) = \"%c\"", **curPos);
-        DEBUG_VAR ("%p", *curPos);
-        
-        (*curPos)++;
+        LEXICAL_ERROR ("Number %.*s is too big, max is " VALUE_NUMBER_FSTRING, 
+                       (int) len, *curPos, kValueNumberMax);
     }
 
+    *curPos += len;
+
+    return TokenAdd (tokens, TYPE_CONST_NUM, {.number = (valueNumber_t) literal.integer}, offset);
+}
+
+int TokenAddName (char **curPos, size_t len, tokensArray_t *tokens, namesTable_t *namesTable,
+                  uint32_t offset)
+{
+    assert (curPos);
+    assert (*curPos);
+    assert (tokens);
+    assert (namesTable);
+    assert (len > 0);
+
+    char *nameStr = *curPos;
+
+    (*curPos) += len;
+
+    DEBUG_VAR ("%p", *curPos);
+
     size_t idx = 0;
 
     TREE_DO_AND_RETURN (NamesTableFindOrAdd (namesTable, nameStr, size_t(*curPos - nameStr), &idx));
 
-    TREE_DO_AND_RETURN (TokenAdd (tokens, TYPE_NAME, {.idx = idx}, line, position));
+    if (idx > UINT32_MAX)
+        LEXICAL_ERROR ("Too many names (%lu), name ids don't fit in 32 bits", idx);
+
+    // new name points into stream block or edited source, which will be overwritten
+    if (tokens->names != NULL && namesTable->data[idx].name == nameStr)
+    {
+        const char *nameCopy = ArenaStrDup (tokens->names, nameStr, namesTable->data[idx].len);
+        if (nameCopy == NULL)
+            return TREE_ERROR_COMMON |
+                   COMMON_ERROR_ALLOCATING_MEMORY;
+
+        namesTable->data[idx].name = nameCopy;
+    }
 
-    NamesTableDump (namesTable);
+    TREE_DO_AND_RETURN (TokenAdd (tokens, TYPE_NAME, {.idx = idx}, offset));
 
     return TREE_OK;
 }
@@ -279,33 +1316,40 @@ void DumpTokens (program_t *program)
 
     DEBUG_PRINT ("%s", "\n========== TOKENS ==========\n");
 
-    for (size_t i = 0; i < program->tokens.size; i++)
-    {
-        token_t *token = &program->tokens.data[i];
+    tokensArray_t *tokens = &program->tokens;
 
+    for (size_t i = TokensFirstKept (tokens); i < tokens->size; i++)
+    {
         DEBUG_PRINT ("token[%lu]: \n", i);
 
         DEBUG_PRINT ("%s", "\t ");
         ON_DEBUG (
-            PrintToken (stderr, program, token);
+            PrintToken (stderr, program, i);
         );
         DEBUG_PRINT ("%s", "\n");
 
-        DEBUG_PRINT ("\t type = %s\n", GetTypeName (token->type));
+        DEBUG_PRINT ("\t type = %s\n", GetTypeName (TokenType (tokens, i)));
 
-        if (token->type == TYPE_CONST_NUM)
+        if (TokenType (tokens, i) == TYPE_CONST_NUM)
         {
-            DEBUG_PRINT ("\t value.number = " VALUE_NUMBER_FSTRING, token->value.number);
+            DEBUG_PRINT ("\t value.number = " VALUE_NUMBER_FSTRING, TokenValue (tokens, i).number);
         }
         else
         {
-            DEBUG_PRINT ("\t value.idx = %lu", token->value.idx);
+            DEBUG_PRINT ("\t value.idx = %lu", TokenValue (tokens, i).idx);
         }
 
         DEBUG_PRINT ("%s", "\n");
 
-        DEBUG_PRINT ("\t line = %lu\n", token->line);
-        DEBUG_PRINT ("\t position = %lu\n", token->line);
+        ON_DEBUG (
+            size_t line   = 0;
+            size_t column = 0;
+            TokenGetLineAndColumn (tokens, i, &line, &column);
+        );
+
+        DEBUG_PRINT ("\t offset = %u\n", tokens->offsets[TokenSlot (tokens, i)]);
+        DEBUG_PRINT ("\t line = %lu\n", line);
+        DEBUG_PRINT ("\t position = %lu\n", column);
     }
 }
 
@@ -332,19 +1376,22 @@ void NamesTableDump (namesTable_t *namesTable)
 }
 
 // FIXME: copy-paste. New function - print value based on type
-int PrintToken (FILE *file, program_t *program, token_t *token)
+int PrintToken (FILE *file, program_t *program, size_t tokenIdx)
 {
     assert (file);
-    assert (token);
+    assert (program);
+    assert (tokenIdx < program->tokens.size);
+
+    value_t value = TokenValue (&program->tokens, tokenIdx);
 
-    switch (token->type)
+    switch (TokenType (&program->tokens, tokenIdx))
     {
         case TYPE_UKNOWN:           fprintf (file, "UKNOWN");                                   break;
-        case TYPE_CONST_NUM:        fprintf (file, VALUE_NUMBER_FSTRING, token->value.number);  break;
+        case TYPE_CONST_NUM:        fprintf (file, VALUE_NUMBER_FSTRING, value.number);         break;
 
         case TYPE_KEYWORD:          
         {
-            const keyword_t *keyword = FindKeywordByIdx ((keywordIdxes_t) token->value.idx);
+            const keyword_t *keyword = FindKeywordByIdx ((keywordIdxes_t) value.idx);
             
             if (keyword == NULL)
                 fprintf (file, "NULL keyword");
@@ -355,7 +1402,7 @@ int PrintToken (FILE *file, program_t *program, token_t *token)
         case TYPE_NAME:         
         case TYPE_VARIABLE:         
         {
-            const name_t *var = NamesTableFindByIdx (&program->namesTable, (size_t) token->value.idx);
+            const name_t *var = NamesTableFindByIdx (&program->namesTable, value.idx);
 
             if (var == NULL)
                 fprintf (file, "NULL variable");
@@ -364,6 +1411,7 @@ int PrintToken (FILE *file, program_t *program, token_t *token)
             break;
         }
 
+        case TYPE_BLOCK:
         default:
             fprintf (file, "error");
 
@@ -13,14 +13,58 @@
 #include "tree.h"
 #include "tree_ast.h"
 
-static int TreeCountNodes       (node_t *node, size_t size, size_t *nodesCount);
+static int TreeCountNodes       (tree_t *tree, size_t *nodesCount);
 
-// maybe: pass varInfo here for ERROR_LOG
-node_t *NodeCtor (tree_t *tree)
+// node, whose children are walked from the last one to the first
+struct nodeWalkFrame_t
+{
+    node_t *node        = NULL;
+    size_t childrenLeft = 0;
+};
+
+// source node and its copy, children of the copy are made from the last one to the first
+struct nodeCopyFrame_t
+{
+    node_t *source      = NULL;
+    node_t *dest        = NULL;
+    size_t childrenLeft = 0;
+};
+
+static node_t *NodeCopyAlone    (node_t *source, tree_t *tree);
+static node_t *NodeAlloc        (tree_t *tree);
+static void NodeRelease         (tree_t *tree, node_t *node);
+
+static bool NodeCanBeShared     (type_t type, const node_t *leftChild, const node_t *rightChild);
+static node_t *NodeCtorShared   (tree_t *tree, type_t type, treeDataType value,
+                                 node_t *leftChild, node_t *rightChild);
+static node_t *NodeShare        (node_t *node);
+static bool NodeIsSharedIn      (tree_t *tree, const node_t *node);
+static node_t *NodeDropRef      (tree_t *tree, node_t *node);
+
+static size_t NodeHash          (type_t type, treeDataType value,
+                                 const node_t *leftChild, const node_t *rightChild);
+static node_t **NodeTableFind   (nodeTable_t *table, type_t type, treeDataType value,
+                                 const node_t *leftChild, const node_t *rightChild);
+static int NodeTableInsert      (nodeTable_t *table, node_t *node);
+static int NodeTableGrow        (nodeTable_t *table);
+static void NodeTableRemove     (nodeTable_t *table, node_t *node);
+
+// shared node is marked with it, while TreeCountNodes () is going, so it's counted once
+const uint32_t kNodeCounted = 1u << 31;
+
+// deleted node is taken first, else the new one is bumped from slab.
+// Memory isn't zeroed, caller fills all fields
+node_t *NodeAlloc (tree_t *tree)
 {
     assert (tree);
 
-    node_t *node = (node_t *) calloc (1, sizeof(node_t));
+    node_t *node = tree->freeNodes;
+
+    if (node != NULL)
+        tree->freeNodes = node->left;
+    else
+        node = (node_t *) ArenaAlloc (&tree->nodes, sizeof (node_t), alignof (node_t));
+
     if (node == NULL)
     {
         ERROR_LOG ("Error allocating memory for new node - %s", strerror (errno));
@@ -32,7 +76,33 @@ node_t *NodeCtor (tree_t *tree)
     tree->size += 1;
     DEBUG_LOG ("tree->size = %lu", tree->size);
 
+    tree->allocsCount += 1;
+
+    return node;
+}
+
+void NodeRelease (tree_t *tree, node_t *node)
+{
+    assert (tree);
+    assert (node);
+
+    node->left      = tree->freeNodes;
+    tree->freeNodes = node;
+
+    tree->size -= 1;
+}
+
+// maybe: pass varInfo here for ERROR_LOG
+node_t *NodeCtor (tree_t *tree)
+{
+    assert (tree);
+
+    node_t *node = NodeAlloc (tree);
+    if (node == NULL)
+        return NULL;
+
     node->type          = TYPE_UKNOWN;
+    node->refs          = 0;
     node->value.number  = 0;
     node->left          = NULL;
     node->right         = NULL;
@@ -68,17 +138,13 @@ node_t *NodeCtorAndFill (tree_t *tree,
 
     DEBUG_PRINT ("%s", "\n========== NODE CTOR START ==========\n");
 
-    node_t *node = (node_t *) calloc (1, sizeof(node_t));
-    if (node == NULL)
-    {
-        ERROR_LOG ("Error allocating memory for new node - %s", strerror (errno));
+    if (tree->isShared && NodeCanBeShared (type, leftChild, rightChild))
+        return NodeCtorShared (tree, type, value, leftChild, rightChild);
 
+    node_t *node = NodeAlloc (tree);
+    if (node == NULL)
         return NULL;
-    }
-
-    tree->size += 1;
 
-    DEBUG_LOG ("tree->size = %lu", tree->size);
     DEBUG_LOG ("node [%p]", node);
     DEBUG_LOG ("\t type = %d", type);
 
@@ -95,6 +161,7 @@ node_t *NodeCtorAndFill (tree_t *tree,
     DEBUG_LOG ("\t right = [%p]", node->right);    
 
     node->type          = type;
+    node->refs          = 0;
     node->value         = value;
     node->left          = leftChild;
     node->right         = rightChild;
@@ -104,6 +171,377 @@ node_t *NodeCtorAndFill (tree_t *tree,
     return node;
 }
 
+// Keyword without children is filled after it's made (function, print, ...), and it's
+// changed in place then, so it's never shared. Shared node has only shared children
+bool NodeCanBeShared (type_t type, const node_t *leftChild, const node_t *rightChild)
+{
+    switch (type)
+    {
+        case TYPE_CONST_NUM:
+        case TYPE_VARIABLE:
+        case TYPE_NAME:
+            break;
+
+        case TYPE_KEYWORD:
+            if (leftChild == NULL && rightChild == NULL)
+                return false;
+            break;
+
+        case TYPE_UKNOWN:
+        case TYPE_BLOCK:
+        default:
+            return false;
+    }
+
+    return (leftChild  == NULL || leftChild->refs  > 0) &&
+           (rightChild == NULL || rightChild->refs > 0);
+}
+
+// Caller's references to children are given to the node. If the same node is already
+// in the table, it has its own ones, so caller's are dropped.
+// New node stays not shared, if table can't grow
+node_t *NodeCtorShared (tree_t *tree, type_t type, treeDataType value,
+                        node_t *leftChild, node_t *rightChild)
+{
+    assert (tree);
+
+    nodeTable_t *table = &tree->shared;
+
+    if (table->capacity > 0)
+    {
+        node_t *node = *NodeTableFind (table, type, value, leftChild, rightChild);
+
+        if (node != NULL)
+        {
+            assert (node->refs < kNodeCounted - 1);
+            node->refs++;
+
+            if (leftChild != NULL)
+                leftChild->refs--;
+            if (rightChild != NULL)
+                rightChild->refs--;
+
+            return node;
+        }
+    }
+
+    node_t *node = NodeAlloc (tree);
+    if (node == NULL)
+        return NULL;
+
+    node->type  = type;
+    node->refs  = 0;
+    node->value = value;
+    node->left  = leftChild;
+    node->right = rightChild;
+
+    if (NodeTableInsert (table, node) == TREE_OK)
+        node->refs = 1;
+
+    return node;
+}
+
+// One more reference to node. Not shared node has only one owner, so it's just given away
+node_t *NodeShare (node_t *node)
+{
+    if (node != NULL && node->refs > 0)
+    {
+        assert (node->refs < kNodeCounted - 1);
+        node->refs++;
+    }
+
+    return node;
+}
+
+// node can be shared in another tree, it's looked for in the table of this one
+bool NodeIsSharedIn (tree_t *tree, const node_t *node)
+{
+    assert (tree);
+    assert (node);
+
+    if (node->refs == 0 || tree->shared.capacity == 0)
+        return false;
+
+    return *NodeTableFind (&tree->shared, node->type, node->value, node->left, node->right) == node;
+}
+
+// Caller's reference to node is dropped. Node is returned, if caller was the last owner:
+// it's out of the table then and can be changed and freed
+node_t *NodeDropRef (tree_t *tree, node_t *node)
+{
+    assert (tree);
+
+    if (node == NULL || node->refs == 0)
+        return node;
+
+    if (node->refs > 1)
+    {
+        node->refs--;
+
+        return NULL;
+    }
+
+    NodeTableRemove (&tree->shared, node);
+    node->refs = 0;
+
+    return node;
+}
+
+// Caller, that owns node, gets its own references to children of it. Not shared node
+// gives away the ones it has, its children are set again by NodeRebuild ()
+void NodeUnpack (node_t *node, node_t **leftChild, node_t **rightChild)
+{
+    assert (node);
+    assert (leftChild);
+    assert (rightChild);
+
+    *leftChild  = node->left;
+    *rightChild = node->right;
+
+    if (node->refs == 0)
+        return;
+
+    NodeShare (*leftChild);
+    NodeShare (*rightChild);
+}
+
+// Node gets children, that caller owns (after NodeUnpack ()). Not shared node is changed
+// in place. Shared one is made again through the table, caller's reference to it is dropped
+node_t *NodeRebuild (tree_t *tree, node_t *node, node_t *leftChild, node_t *rightChild)
+{
+    assert (tree);
+    assert (node);
+
+    if (node->refs == 0)
+    {
+        node->left  = leftChild;
+        node->right = rightChild;
+
+        return node;
+    }
+
+    if (leftChild == node->left && rightChild == node->right)
+    {
+        // node keeps its own references to them
+        if (leftChild != NULL)
+            leftChild->refs--;
+        if (rightChild != NULL)
+            rightChild->refs--;
+
+        return node;
+    }
+
+    node_t *rebuilt = NodeCtorAndFill (tree, node->type, node->value, leftChild, rightChild);
+    if (rebuilt == NULL)
+        return NULL;
+
+    TreeDelete (tree, &node);
+
+    return rebuilt;
+}
+
+// Node, whose children are taken by NodeUnpack (), is deleted without them
+void NodeDeleteUnpacked (tree_t *tree, node_t **node)
+{
+    assert (tree);
+    assert (node);
+    assert (*node);
+
+    // shared one only loses caller's reference, its children keep their ones
+    if ((*node)->refs == 0)
+    {
+        (*node)->left  = NULL;
+        (*node)->right = NULL;
+    }
+
+    TreeDelete (tree, node);
+}
+
+// only number is set for numbers, other bytes of value can be anything
+static uint64_t NodeValueKey (type_t type, treeDataType value)
+{
+    return (type == TYPE_CONST_NUM) ? (uint32_t) value.number : value.idx;
+}
+
+size_t NodeHash (type_t type, treeDataType value,
+                 const node_t *leftChild, const node_t *rightChild)
+{
+    uint64_t hash = ((uint64_t) type + 1)                   * 0x9E3779B97F4A7C15ull;
+    hash = (hash ^ NodeValueKey (type, value))              * 0xBF58476D1CE4E5B9ull;
+    hash = (hash ^ (uintptr_t) leftChild)                   * 0x94D049BB133111EBull;
+    hash = (hash ^ (uintptr_t) rightChild)                  * 0x9E3779B97F4A7C15ull;
+
+    return hash ^ (hash >> 32);
+}
+
+// bucket of node with this key, or empty bucket, where it should be
+node_t **NodeTableFind (nodeTable_t *table, type_t type, treeDataType value,
+                        const node_t *leftChild, const node_t *rightChild)
+{
+    assert (table);
+    assert (table->capacity > 0);
+
+    size_t mask     = table->capacity - 1;
+    uint64_t key    = NodeValueKey (type, value);
+
+    for (size_t i = NodeHash (type, value, leftChild, rightChild) & mask; ; i = (i + 1) & mask)
+    {
+        node_t *node = table->buckets[i];
+
+        if (node == NULL || (node->type  == type       && NodeValueKey (type, node->value) == key &&
+                             node->left  == leftChild  && node->right == rightChild))
+            return &table->buckets[i];
+    }
+}
+
+int NodeTableInsert (nodeTable_t *table, node_t *node)
+{
+    assert (table);
+    assert (node);
+
+    if ((table->size + 1) * 2 > table->capacity)
+        TREE_DO_AND_RETURN (NodeTableGrow (table));
+
+    node_t **bucket = NodeTableFind (table, node->type, node->value, node->left, node->right);
+    assert (*bucket == NULL);
+
+    *bucket = node;
+    table->size++;
+
+    return TREE_OK;
+}
+
+int NodeTableGrow (nodeTable_t *table)
+{
+    assert (table);
+
+    size_t capacity = (table->capacity == 0) ? kNodeTableMinCapacity : table->capacity * 2;
+
+    node_t **buckets = (node_t **) calloc (capacity, sizeof (node_t *));
+    if (buckets == NULL)
+    {
+        ERROR_LOG ("Error allocating memory for %lu shared nodes - %s", capacity, strerror (errno));
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_ALLOCATING_MEMORY;
+    }
+
+    node_t **oldBuckets = table->buckets;
+    size_t oldCapacity  = table->capacity;
+
+    table->buckets  = buckets;
+    table->capacity = capacity;
+
+    for (size_t i = 0; i < oldCapacity; i++)
+    {
+        node_t *node = oldBuckets[i];
+
+        if (node != NULL)
+            *NodeTableFind (table, node->type, node->value, node->left, node->right) = node;
+    }
+
+    free (oldBuckets);
+
+    return TREE_OK;
+}
+
+// Backward shift: nodes after the hole are moved to it, if their home bucket isn't
+// between the hole and them. So searches stop at empty bucket without tombstones
+void NodeTableRemove (nodeTable_t *table, node_t *node)
+{
+    assert (table);
+    assert (node);
+    assert (table->capacity > 0);
+
+    size_t mask = table->capacity - 1;
+    size_t hole = NodeHash (node->type, node->value, node->left, node->right) & mask;
+
+    while (table->buckets[hole] != node)
+    {
+        assert (table->buckets[hole] != NULL);
+
+        hole = (hole + 1) & mask;
+    }
+
+    for (size_t i = (hole + 1) & mask; table->buckets[i] != NULL; i = (i + 1) & mask)
+    {
+        node_t *moved = table->buckets[i];
+        size_t home   = NodeHash (moved->type, moved->value, moved->left, moved->right) & mask;
+
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            table->buckets[hole] = moved;
+            hole = i;
+        }
+    }
+
+    table->buckets[hole] = NULL;
+    table->size--;
+}
+
+// statements can be NULL, then array is filled with NULLs
+nodeBlock_t *BlockCtor (tree_t *tree, node_t **statements, size_t size)
+{
+    assert (tree);
+
+    nodeBlock_t *block = (nodeBlock_t *) ArenaAlloc (&tree->nodes, 
+                                                     sizeof (nodeBlock_t) + size * sizeof (node_t *),
+                                                     alignof (nodeBlock_t));
+    if (block == NULL)
+    {
+        ERROR_LOG ("Error allocating memory for block of %lu statements - %s", size, strerror (errno));
+
+        return NULL;
+    }
+
+    block->size       = size;
+    block->statements = (node_t **) (block + 1);
+
+    if (statements != NULL && size > 0)
+        memcpy (block->statements, statements, size * sizeof (node_t *));
+    else if (size > 0)
+        memset (block->statements, 0, size * sizeof (node_t *));
+
+    return block;
+}
+
+// array of block stays in tree->nodes until TreeDtor ()
+node_t *NodeCtorBlock (tree_t *tree, node_t **statements, size_t size)
+{
+    assert (tree);
+
+    nodeBlock_t *block = BlockCtor (tree, statements, size);
+    if (block == NULL)
+        return NULL;
+
+    return NodeCtorAndFill (tree, TYPE_BLOCK, {.block = block}, NULL, NULL);
+}
+
+// Statements of block or left and right child of any other node (they can be NULL)
+size_t NodeChildrenCount (const node_t *node)
+{
+    assert (node);
+
+    if (node->type != TYPE_BLOCK)
+        return 2;
+
+    if (node->value.block == NULL)
+        return 0;
+
+    return node->value.block->size;
+}
+
+node_t **NodeChild (node_t *node, size_t childIdx)
+{
+    assert (node);
+    assert (childIdx < NodeChildrenCount (node));
+
+    if (node->type == TYPE_BLOCK)
+        return &node->value.block->statements[childIdx];
+
+    return (childIdx == 0) ? &node->left : &node->right;
+}
+
 int TreeCtor (tree_t *tree, treeLog_t *log
               ON_DEBUG (, varInfo_t varInfo))
 {
@@ -112,6 +550,15 @@ int TreeCtor (tree_t *tree, treeLog_t *log
 
     tree->root = NULL;
     tree->size = 0;
+    tree->allocsCount = 0;
+
+    tree->depthBudget = kTreeDefaultDepthBudget;
+
+    ArenaCtor (&tree->nodes, kTreeSlabNodes * sizeof (node_t));
+    tree->freeNodes = NULL;
+
+    tree->isShared  = false;
+    tree->shared    = {};
 
     ON_DEBUG (
         tree->varInfo = varInfo;
@@ -122,35 +569,60 @@ int TreeCtor (tree_t *tree, treeLog_t *log
     return TREE_OK;
 }
 
+// Nodes aren't visited: slabs are freed all together, with nodes lost by failed parse too.
+// Tree can be filled again after it, in the same mode
 void TreeDtor (tree_t *tree)
 {
     assert (tree);
 
-    TreeDelete (tree, &tree->root);
+    ArenaDtor (&tree->nodes);
+
+    free (tree->shared.buckets);
+    tree->shared = {};
+
+    tree->root          = NULL;
+    tree->size          = 0;
+    tree->allocsCount   = 0;
+    tree->freeNodes     = NULL;
 }
 
-// TODO: 
+// Left child is rotated up, until node has none. Then node goes to free list and we go right.
+// Statements of block are taken out of it one by one as its left child.
+// No stack is needed, so deleting never fails, however deep the tree is.
+// Shared node only loses a reference, it's deleted with the last one
 void TreeDelete (tree_t *tree, node_t **node)
 {
     assert (tree);
     assert (node);
     assert (*node);
-    
-    if ((*node)->left != NULL)
-    {
-        TreeDelete (tree, &(*node)->left);
-    }
-    if ((*node)->right != NULL)
+
+    node_t *cur = NodeDropRef (tree, *node);
+
+    while (cur != NULL)
     {
-        TreeDelete (tree, &(*node)->right);
+        node_t *left = NodeDropRef (tree, cur->left);
+
+        nodeBlock_t *block = (cur->type == TYPE_BLOCK) ? cur->value.block : NULL;
+
+        while (left == NULL && block != NULL && block->size > 0)
+            left = NodeDropRef (tree, block->statements[--block->size]);
+
+        if (left != NULL)
+        {
+            cur->left   = left->right;
+            left->right = cur;
+            cur         = left;
+
+            continue;
+        }
+
+        node_t *right = NodeDropRef (tree, cur->right);
+
+        NodeRelease (tree, cur);
+
+        cur = right;
     }
 
-    tree->size -= 1;
-    
-    // DEBUG_VAR ("deleted [%p]", node);
-    // DEBUG_VAR ("tree->size = %lu", tree->size);
-    
-    free (*node);
     *node = NULL;
 }
 
@@ -162,7 +634,7 @@ int TreeVerify (tree_t *tree)
     if (tree->root == NULL) return TREE_ERROR_NULL_ROOT;
 
     size_t nodesCount = 0;
-    error |= TreeCountNodes (tree->root, tree->size, &nodesCount);
+    error |= TreeCountNodes (tree, &nodesCount);
 
     if (nodesCount < tree->size) error |= TREE_ERROR_NOT_ENOUGH_NODES;
     if (nodesCount > tree->size) error |= TREE_ERROR_TO_MUCH_NODES;
@@ -173,21 +645,64 @@ int TreeVerify (tree_t *tree)
     return error;
 }
 
-int TreeCountNodes (node_t *node, size_t size, size_t *nodesCount)
+// Children are walked from the last one, and frame is popped before the first one,
+// so for left-deep CONNECT chains stack holds only one statement and the rest of the chain.
+// Stops after tree->size nodes, so cycles end too. Shared nodes are counted once
+int TreeCountNodes (tree_t *tree, size_t *nodesCount)
 {
-    int status = TREE_OK;
-    
+    assert (tree);
+    assert (nodesCount);
+
+    dynamicArray_t <nodeWalkFrame_t> stack = {};
+
     *nodesCount += 1;
 
-    if (*nodesCount > size)
-        return status|
-               TREE_ERROR_TO_MUCH_NODES;
+    if (tree->root->refs > 0)
+        tree->root->refs |= kNodeCounted;
+
+    int status = TreeStackPush (tree, &stack, {.node         = tree->root, 
+                                               .childrenLeft = NodeChildrenCount (tree->root)});
+
+    while (status == TREE_OK && stack.size > 0)
+    {
+        nodeWalkFrame_t *frame = &stack.data[stack.size - 1];
+
+        if (frame->childrenLeft == 0)
+        {
+            stack.size--;
+            continue;
+        }
+
+        node_t *child = *NodeChild (frame->node, --frame->childrenLeft);
+
+        if (frame->childrenLeft == 0)
+            stack.size--;
 
-    if (node->left != NULL)
-        status |= TreeCountNodes (node->left, size, nodesCount);
+        if (child == NULL || (child->refs & kNodeCounted) != 0)
+            continue;
 
-    if (node->right != NULL)
-        status |= TreeCountNodes (node->right, size, nodesCount);
+        if (child->refs > 0)
+            child->refs |= kNodeCounted;
+
+        *nodesCount += 1;
+
+        if (*nodesCount > tree->size)
+        {
+            status = TREE_ERROR_TO_MUCH_NODES;
+            break;
+        }
+
+        status = TreeStackPush (tree, &stack, {.node         = child, 
+                                               .childrenLeft = NodeChildrenCount (child)});
+    }
+
+    DynamicArrayDtor (&stack);
+
+    for (size_t i = 0; i < tree->shared.capacity; i++)
+    {
+        if (tree->shared.buckets[i] != NULL)
+            tree->shared.buckets[i]->refs &= ~kNodeCounted;
+    }
 
     return status;
 }
@@ -206,31 +721,90 @@ void TreeCopy (tree_t *source, tree_t *dest)
     DEBUG_PRINT ("%s", "========== END OF COPYING TREE ==========\n\n");
 }
 
+// Returns NULL on error, nothing is left in tree then.
+// Node shared in this tree isn't copied, it gets one more reference
 node_t *NodeCopy (node_t *source, tree_t *tree)
 {
     assert (source);
     assert (tree);
 
-    node_t *dest = NodeCtorAndFill (tree, source->type, source->value, NULL, NULL);
-    
+    if (NodeIsSharedIn (tree, source))
+        return NodeShare (source);
+
+    node_t *root = NodeCopyAlone (source, tree);
+    if (root == NULL)
+        return NULL;
+
     DEBUG_VAR ("%p", source);
-    DEBUG_VAR ("%p", dest);
+    DEBUG_VAR ("%p", root);
+
+    dynamicArray_t <nodeCopyFrame_t> stack = {};
 
-    if (source->left != NULL)
+    int status = TreeStackPush (tree, &stack, {.source       = source, 
+                                               .dest         = root, 
+                                               .childrenLeft = NodeChildrenCount (source)});
+
+    while (status == TREE_OK && stack.size > 0)
     {
-        dest->left = NodeCopy (source->left, tree);
-        if (dest->left == NULL)
-            return NULL;
+        nodeCopyFrame_t *frame = &stack.data[stack.size - 1];
+
+        if (frame->childrenLeft == 0)
+        {
+            stack.size--;
+            continue;
+        }
+
+        size_t childIdx = --frame->childrenLeft;
+
+        node_t *sourceChild = *NodeChild (frame->source, childIdx);
+        node_t **destChild  =  NodeChild (frame->dest,   childIdx);
+
+        if (frame->childrenLeft == 0)
+            stack.size--;
+
+        if (sourceChild == NULL)
+            continue;
+
+        if (NodeIsSharedIn (tree, sourceChild))
+        {
+            *destChild = NodeShare (sourceChild);
+            continue;
+        }
+
+        *destChild = NodeCopyAlone (sourceChild, tree);
+        if (*destChild == NULL)
+        {
+            status = TREE_ERROR_CREATING_NODE;
+            break;
+        }
+
+        status = TreeStackPush (tree, &stack, {.source       = sourceChild, 
+                                               .dest         = *destChild,
+                                               .childrenLeft = NodeChildrenCount (sourceChild)});
     }
-        
-    if (source->right != NULL)
+
+    DynamicArrayDtor (&stack);
+
+    if (status != TREE_OK)
     {
-        dest->right = NodeCopy (source->right, tree);
-        if (dest->right == NULL)
-            return NULL;
+        TreeDelete (tree, &root);
+
+        return NULL;
     }
 
-    return dest;
+    return root;
+}
+
+// children of the copy are NULL, block gets array of the same size
+node_t *NodeCopyAlone (node_t *source, tree_t *tree)
+{
+    assert (source);
+    assert (tree);
+
+    if (source->type == TYPE_BLOCK)
+        return NodeCtorBlock (tree, NULL, NodeChildrenCount (source));
+
+    return NodeCtorAndFill (tree, source->type, source->value, NULL, NULL);
 }
 
 bool IsLeaf (node_t *node)
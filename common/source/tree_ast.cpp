@@ -5,6 +5,7 @@
 #include <errno.h>
 
 #include "tree_ast.h"
+#include "keyword_trie.h"
 
 #include "tree.h"
 #include "tokenizator.h"
@@ -16,9 +17,28 @@
 
 static node_t *NodeSimplifyCalc         (tree_t *tree, node_t *node, bool *modified);
 static node_t *NodeSimplifyTrivial      (tree_t *tree, node_t *node, bool *modified);
+static node_t *NodeSimplifyIf           (tree_t *tree, node_t *node, bool *modified);
+static void BlockDropDeadStatements     (tree_t *tree, node_t *node, size_t *rewrites);
+static bool NodeHasSideEffects          (tree_t *tree, node_t *node);
 
 int NodeSaveToFile (FILE *file, program_t *program, node_t *node);
 
+const size_t kAstSaveMaxTabs = 64;
+
+// node, that is written, and its child to write next
+struct nodeSaveFrame_t
+{
+    node_t *node        = NULL;
+    size_t nextChild    = 0;
+};
+
+static int NodeSaveBegin    (FILE *file, program_t *program, node_t *node, 
+                             dynamicArray_t <nodeSaveFrame_t> *stack);
+
+static size_t NamesTableHash        (const char *name, size_t len);
+static void NamesTableInsertBucket  (namesTable_t *namesTable, size_t idx);
+static int CheckForRehashNamesTable (namesTable_t *namesTable);
+
 void PrintTabsToFile (FILE *file, size_t n);
 
 int ProgramCtor (program_t *program)
@@ -29,20 +49,17 @@ int ProgramCtor (program_t *program)
     TREE_DO_AND_RETURN (NamesTableCtor (&program->namesTable));
     TREE_DO_AND_RETURN (TokensArrayCtor (&program->tokens));
 
-    const size_t kDefaultStackCapacity = 16;
+    TREE_DO_AND_RETURN (SymbolTableCtor (&program->variables));
+    TREE_DO_AND_RETURN (SymbolTableCtor (&program->functions));
 
-    int status = STACK_CREATE (program->variables, kDefaultStackCapacity);
-    if (status != STACK_OK)
-        return TREE_ERROR_STACK |
-               status;
-
-    status = STACK_CREATE (program->functions, kDefaultStackCapacity);
-    if (status != STACK_OK)
-        return TREE_ERROR_STACK |
+    int status = DynamicArrayCtor (&program->functionSpans, 0);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
                status;
 
+    program->source = {};
 
-    program->buffer   = NULL;
+    ArenaCtor (&program->names, kArenaDefaultBlockSize);
 
     TREE_DO_AND_RETURN (TREE_CTOR (&program->ast, &program->log));
 
@@ -57,14 +74,15 @@ void ProgramDtor (program_t *program)
     NamesTableDtor (&program->namesTable);
     TokensArrayDtor (&program->tokens);
 
-    StackDtor (&program->variables);
-    StackDtor (&program->functions);
+    SymbolTableDtor (&program->variables);
+    SymbolTableDtor (&program->functions);
+
+    TreeDtor (&program->ast);
 
-    if (program->ast.root != NULL)
-        TreeDtor (&program->ast);
+    DynamicArrayDtor (&program->functionSpans);
 
-    free (program->buffer);
-    program->buffer = NULL;
+    SourceBufferClose (&program->source);
+    ArenaDtor (&program->names);
 }
 
 int NamesTableCtor (namesTable_t *namesTable)
@@ -73,14 +91,18 @@ int NamesTableCtor (namesTable_t *namesTable)
 
     const size_t kNamesTableInitCapacity = 16;
 
-    namesTable->size     = 0;
-    namesTable->capacity = kNamesTableInitCapacity;
+    int status = DynamicArrayCtor (namesTable, kNamesTableInitCapacity);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
 
-    namesTable->data = (name_t *) calloc (namesTable->capacity, sizeof (name_t));
+    namesTable->bucketsCapacity = 2 * kNamesTableInitCapacity;
 
-    if (namesTable->data == NULL)
+    namesTable->buckets = (size_t *) calloc (namesTable->bucketsCapacity, sizeof (size_t));
+
+    if (namesTable->buckets == NULL)
     {
-        ERROR_LOG ("Error allocating memory for namesTable->data - %s",
+        ERROR_LOG ("Error allocating memory for namesTable->buckets - %s",
                     strerror (errno));
 
         return TREE_ERROR_COMMON |
@@ -94,11 +116,12 @@ void NamesTableDtor (namesTable_t *namesTable)
 {
     assert (namesTable);
 
-    free (namesTable->data);
-    namesTable->data = NULL;
+    DynamicArrayDtor (namesTable);
+
+    free (namesTable->buckets);
+    namesTable->buckets = NULL;
 
-    namesTable->size     = 0;
-    namesTable->capacity = 0;
+    namesTable->bucketsCapacity = 0;
 }
 
 // FIXME: maybe tree_prefix_save.cpp ?
@@ -127,52 +150,88 @@ int TreeAstSaveToFile (program_t *program, const char *fileName)
     return status;
 }
 
+// tabs are written by blocks: after any thread was created (parallel lexer)
+// every stdio call takes file lock, and deep trees have a lot of tabs
 void PrintTabsToFile (FILE *file, size_t n)
 {
     assert (file);
 
-    while (n--)
-        fprintf (file, "\t");
+    static const char kTabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t"
+                                "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+    const size_t kTabsLen = sizeof (kTabs) - 1;
+
+    while (n > 0)
+    {
+        size_t blockLen = (n < kTabsLen) ? n : kTabsLen;
+
+        fwrite (kTabs, sizeof (char), blockLen, file);
+
+        n -= blockLen;
+    }
 }
 
+// Format is "( node\n left\n right\n)" with a tab per level, block is "( {}\n statement\n ...\n)".
+// Loader skips any whitespace, so indentation stops growing at kAstSaveMaxTabs:
+// else long CONNECT chains of old files give O(n^2) tabs
 int NodeSaveToFile (FILE *file, program_t *program, node_t *node)
 {
     assert (file);
     assert (program);
     assert (node);
 
-    static size_t tabsCounter = 0;
-    
-    tabsCounter++;
+    dynamicArray_t <nodeSaveFrame_t> stack = {};
 
-    fprintf (file, "%s", "( ");
+    int status = NodeSaveBegin (file, program, node, &stack);
 
-    TREE_DO_AND_RETURN (PrintNode (file, program, node, false));
+    while (status == TREE_OK && stack.size > 0)
+    {
+        size_t depth = stack.size;
+        size_t tabs  = (depth < kAstSaveMaxTabs) ? depth : kAstSaveMaxTabs;
 
-    fprintf (file, "%s", "\n");
-    PrintTabsToFile (file, tabsCounter);
+        nodeSaveFrame_t *frame = &stack.data[depth - 1];
 
-    if (node->left != NULL)
-        NodeSaveToFile (file, program, node->left);
-    else
-        fprintf (file, "%s", "nil");
+        if (frame->nextChild == NodeChildrenCount (frame->node))
+        {
+            fprintf (file, "%s", "\n");
+            PrintTabsToFile (file, (depth - 1 < kAstSaveMaxTabs) ? depth - 1 : kAstSaveMaxTabs);
 
-    fprintf (file, "%s", "\n");
-    PrintTabsToFile (file, tabsCounter);
+            fprintf (file, "%s", ")");
 
-    if (node->right != NULL)
-        NodeSaveToFile (file, program, node->right);
-    else
-        fprintf (file, "%s", "nil");
+            stack.size--;
 
-    fprintf (file, "%s", "\n");
+            continue;
+        }
 
-    tabsCounter--;
-    PrintTabsToFile (file, tabsCounter);
+        node_t *child = *NodeChild (frame->node, frame->nextChild++);
 
-    fprintf (file, "%s", ")");
+        fprintf (file, "%s", "\n");
+        PrintTabsToFile (file, tabs);
 
-    return TREE_OK;
+        if (child != NULL)
+            status = NodeSaveBegin (file, program, child, &stack);
+        else
+            fprintf (file, "%s", "nil");
+    }
+
+    DynamicArrayDtor (&stack);
+
+    return status;
+}
+
+// writes node itself, its children are written, when it's on the top of the stack
+int NodeSaveBegin (FILE *file, program_t *program, node_t *node, 
+                   dynamicArray_t <nodeSaveFrame_t> *stack)
+{
+    assert (file);
+    assert (program);
+    assert (node);
+    assert (stack);
+
+    fprintf (file, "%s", "( ");
+
+    TREE_DO_AND_RETURN (PrintNode (file, program, node, false));
+
+    return TreeStackPush (&program->ast, stack, {.node = node, .nextChild = 0});
 }
 
 int PrintNode (FILE *file, program_t *program, node_t *node, bool exitQuotes)
@@ -213,6 +272,11 @@ int PrintNode (FILE *file, program_t *program, node_t *node, bool exitQuotes)
             break;
         }
 
+        case TYPE_BLOCK:
+            // '{' and '}' are special in labels of graphviz records
+            fprintf (file, "%s", exitQuotes ? "\\{\\}" : kBlockStandardName);
+            break;
+
         default:
             fprintf (file, "error");
 
@@ -231,44 +295,29 @@ const char *GetTypeName (type_t type)
         case TYPE_KEYWORD:          return "keyword";
         case TYPE_VARIABLE:         return "variable";
         case TYPE_NAME:             return "name";
+        case TYPE_BLOCK:            return "block";
 
         default:                    return "ERROR";
     }
 }
 
-void TryToFindOperator (char *str, int len, type_t *type, treeDataType *value)
+// FNV-1a
+size_t NamesTableHash (const char *name, size_t len)
 {
-    assert (str);
-
-    for (size_t i = 0; i < kNumberOfKeywords; i++)
-    {
-        if (strncmp (str, kKeywords[i].name, (size_t) len) == 0)
-        {
-            *type = TYPE_KEYWORD;
-            value->idx = kKeywords[i].idx;
+    assert (name);
 
-            DEBUG_LOG ("FOUND \"%s\"", kKeywords[i].name);
-        }
-    }
-}
+    size_t hash = 14695981039346656037UL;
 
-void TryToFindNode (char *str, int len, type_t *type, treeDataType *value)
-{
-    assert (str);
-
-    for (size_t i = 0; i < kNumberOfKeywords; i++)
+    for (size_t i = 0; i < len; i++)
     {
-        if (strncmp (str, kKeywords[i].standardName, (size_t) len) == 0)
-        {
-            *type = TYPE_KEYWORD;
-            value->idx = kKeywords[i].idx;
-
-            DEBUG_LOG ("FOUND \"%s\"", kKeywords[i].name);
-        }
+        hash ^= (unsigned char) name[i];
+        hash *= 1099511628211UL;
     }
+
+    return hash;
 }
 
-const name_t *NamesTableFindByStr (namesTable_t *namesTable, char *name, size_t nameLen)
+const name_t *NamesTableFindByStr (namesTable_t *namesTable, const char *name, size_t nameLen)
 {
     assert (namesTable);
     assert (name);
@@ -276,85 +325,164 @@ const name_t *NamesTableFindByStr (namesTable_t *namesTable, char *name, size_t
     DEBUG_LOG ("nameStr = \"%.*s\"", (int) nameLen, name);
     DEBUG_VAR ("%lu", nameLen);
 
-    for (size_t i = 0; i < namesTable->size; i++)
+    size_t hash = NamesTableHash (name, nameLen);
+    size_t mask = namesTable->bucketsCapacity - 1;
+
+    for (size_t i = hash & mask; namesTable->buckets[i] != 0; i = (i + 1) & mask)
     {
-        DEBUG_VAR ("%lu", i);
-        DEBUG_PTR (namesTable->data[i].name);
-        DEBUG_LOG ("namesTable[i].name = \"%.*s\"", 
-                   (int)namesTable->data[i].len,
-                   namesTable->data[i].name);
-        
-        if (strncmp (namesTable->data[i].name, name, nameLen) == 0)
-            return &namesTable->data[i];
+        const name_t *cur = &namesTable->data[namesTable->buckets[i] - 1];
+
+        if (cur->hash == hash && cur->len == nameLen &&
+            memcmp (cur->name, name, nameLen) == 0)
+            return cur;
     }
 
     return NULL;
 }
 
-// FIXME: rename to namesTable
 const name_t *NamesTableFindByIdx (namesTable_t *namesTable, size_t idx)
 {
     assert (namesTable);
 
+    if (idx >= namesTable->size)
+        return NULL;
+
+    assert (namesTable->data[idx].idx == idx);
+
+    return &namesTable->data[idx];
+}
+
+// O(size), so it is called only in debug mode and only after whole table is filled
+int NamesTableVerify (namesTable_t *namesTable)
+{
+    if (namesTable == NULL)
+        return TREE_ERROR_NULL_STRUCT;
+
+    if (namesTable->data == NULL || namesTable->buckets == NULL)
+        return TREE_ERROR_NULL_DATA;
+
+    if (namesTable->size > namesTable->capacity ||
+        2 * namesTable->size > namesTable->bucketsCapacity)
+        return TREE_ERROR_NAMES_TABLE;
+
     for (size_t i = 0; i < namesTable->size; i++)
     {
-        if (namesTable->data[i].idx == idx)
-            return &namesTable->data[i];
+        const name_t *name = &namesTable->data[i];
+
+        if (name->idx != i)
+        {
+            ERROR_LOG ("Ids in names table are not dense: data[%lu].idx = %lu", i, name->idx);
+
+            return TREE_ERROR_NAMES_TABLE;
+        }
+
+        if (NamesTableFindByStr (namesTable, name->name, name->len) != name)
+        {
+            ERROR_LOG ("Name \"%.*s\" [%lu] can't be found by string", 
+                       (int) name->len, name->name, i);
+
+            return TREE_ERROR_NAMES_TABLE;
+        }
     }
 
-    return NULL;
+    size_t usedBuckets = 0;
+
+    for (size_t i = 0; i < namesTable->bucketsCapacity; i++)
+    {
+        if (namesTable->buckets[i] == 0)
+            continue;
+
+        if (namesTable->buckets[i] > namesTable->size)
+            return TREE_ERROR_NAMES_TABLE;
+
+        usedBuckets++;
+    }
+
+    if (usedBuckets != namesTable->size)
+        return TREE_ERROR_NAMES_TABLE;
+
+    return TREE_OK;
 }
 
 const keyword_t *FindKeywordByIdx (keywordIdxes_t idx)
 {
-    for (size_t i = 0; i < kNumberOfKeywords; i++)
-    {
-        if (kKeywords[i].idx == idx)
-            return &kKeywords[i];
-    }
+    if ((size_t) idx >= kNumberOfKeywords)
+        return NULL;
 
-    return NULL;
+    return &kKeywords[idx];
+}
+
+// Save files have keywords by their standard names, which are unique
+const keyword_t *FindKeywordByStandardName (const char *standardName, size_t len)
+{
+    assert (standardName);
+
+    static constexpr keywordTrie_t kStandardNamesTrie = KeywordTrieBuild (KEYWORD_TRIE_STANDARD_NAME);
+
+    int keyword = KeywordTrieFind (&kStandardNamesTrie, standardName, len);
+    if (keyword == kKeywordTrieNoNode)
+        return NULL;
+
+    DEBUG_LOG ("FOUND \"%s\"", kKeywords[keyword].name);
+
+    return &kKeywords[keyword];
 }
 
 const keyword_t *FindBuiltinFunctionByIdx (keywordIdxes_t idx)
 {
-    for (size_t i = 0; i < kNumberOfKeywords; i++)
-    {
-        if (kKeywords[i].idx == idx && kKeywords[i].isFunction)
-            return &kKeywords[i];
-    }
+    const keyword_t *keyword = FindKeywordByIdx (idx);
 
-    return NULL;
+    if (keyword == NULL || !keyword->isFunction)
+        return NULL;
+
+    return keyword;
 }
 
-// FIXME: copy paste
-int CheckForReallocNamesTable (namesTable_t *namesTable)
+void NamesTableInsertBucket (namesTable_t *namesTable, size_t idx)
 {
     assert (namesTable);
+    assert (idx < namesTable->size);
+
+    size_t mask = namesTable->bucketsCapacity - 1;
+    size_t i    = namesTable->data[idx].hash & mask;
 
-    if (namesTable->size < namesTable->capacity)
+    while (namesTable->buckets[i] != 0)
+        i = (i + 1) & mask;
+
+    namesTable->buckets[i] = idx + 1;
+}
+
+// keeps load factor of buckets not greater than 1/2
+int CheckForRehashNamesTable (namesTable_t *namesTable)
+{
+    assert (namesTable);
+
+    if (2 * (namesTable->size + 1) <= namesTable->bucketsCapacity)
         return TREE_OK;
 
-    if (namesTable->capacity == 0)
-        namesTable->capacity = 1;
+    size_t *newBuckets = (size_t *) calloc (2 * namesTable->bucketsCapacity, sizeof (size_t));
 
-    name_t *newData = (name_t *) realloc (namesTable->data, 
-                                          namesTable->capacity * sizeof (name_t));
-    
-    if (newData == NULL)
+    if (newBuckets == NULL)
     {
-        ERROR_LOG ("Error reallocating memory - %s", strerror (errno));
+        ERROR_LOG ("Error allocating memory for new buckets - %s", strerror (errno));
 
         return TREE_ERROR_COMMON |
                COMMON_ERROR_ALLOCATING_MEMORY;
     }
 
-    namesTable->data = newData;
+    free (namesTable->buckets);
+
+    namesTable->buckets          = newBuckets;
+    namesTable->bucketsCapacity *= 2;
+
+    for (size_t i = 0; i < namesTable->size; i++)
+        NamesTableInsertBucket (namesTable, i);
 
     return TREE_OK;
 }
 
-int NamesTableFindOrAdd (namesTable_t *namesTable, char *nameStr, size_t len, 
+// name isn't copied, nameStr should live as long as namesTable (usually it's in program->source)
+int NamesTableFindOrAdd (namesTable_t *namesTable, const char *nameStr, size_t len, 
                          size_t *idx)
 {
     assert (namesTable);
@@ -372,27 +500,46 @@ int NamesTableFindOrAdd (namesTable_t *namesTable, char *nameStr, size_t len,
         return TREE_OK;
     }
     
-    TREE_DO_AND_RETURN (CheckForReallocNamesTable (namesTable));
+    TREE_DO_AND_RETURN (CheckForRehashNamesTable (namesTable));
 
-    *idx = size_t (namesTable->size);
+    *idx = namesTable->size;
 
-    namesTable->data[*idx].name = nameStr;
-    namesTable->data[*idx].len = len;
-    namesTable->data[*idx].idx = *idx;
+    int status = DynamicArrayPush (namesTable, name_t {.name = nameStr,
+                                                       .len  = len,
+                                                       .hash = NamesTableHash (nameStr, len),
+                                                       .idx  = *idx});
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
 
-    DEBUG_LOG ("%.*s", (int)namesTable->data[*idx].len, namesTable->data[*idx].name);
+    NamesTableInsertBucket (namesTable, *idx);
 
-    namesTable->size++;
-    
+    DEBUG_LOG ("new name \"%.*s\", idx = %lu", (int) len, nameStr, *idx);
     DEBUG_VAR ("%lu", namesTable->size);
-    DEBUG_LOG ("element name is '%.*s'", 
-               (int)namesTable->data[namesTable->size].len, nameStr);
-
-    NamesTableDump (namesTable);
 
     return TREE_OK;
 }
 
+// names are copied, so they don't point into source anymore
+int NamesTableCopyNames (namesTable_t *namesTable, arena_t *arena)
+{
+    assert (namesTable);
+    assert (arena);
+
+    for (size_t i = 0; i < namesTable->size; i++)
+    {
+        name_t *name = &namesTable->data[i];
+
+        const char *nameCopy = ArenaStrDup (arena, name->name, name->len);
+        if (nameCopy == NULL)
+            return TREE_ERROR_COMMON |
+                   COMMON_ERROR_ALLOCATING_MEMORY;
+
+        name->name = nameCopy;
+    }
+
+    return TREE_OK;
+}
 
 // // =============  CALCULATION   =============
 
@@ -485,85 +632,221 @@ int NamesTableFindOrAdd (namesTable_t *namesTable, char *nameStr, size_t len,
 #define NUM_(num)                                                               \
         NodeCtorAndFill (tree, TYPE_CONST_NUM, {.number = num}, NULL, NULL)
 
-void TreeSimplify (program_t *program, tree_t *tree)
+// Node, whose children are simplified, with the children it gave by NodeUnpack ()
+struct nodeSimplifyFrame_t
+{
+    node_t *node        = NULL;
+    node_t *left        = NULL;
+    node_t *right       = NULL;
+    size_t nextChild    = 0;
+};
+
+static int NodeSimplifyPush     (tree_t *tree, dynamicArray_t <nodeSimplifyFrame_t> *stack,
+                                 node_t *node);
+static node_t *NodeSimplifyDone (tree_t *tree, nodeSimplifyFrame_t *frame, simplifyLevel_t level,
+                                 size_t *rewrites, int *status);
+
+// One bottom-up pass: node is simplified, when its children are done, and rules are
+// tried at it until none of them changes it. Parent is visited after it anyway,
+// so nothing is walked again and changes deep in the tree don't cost a new pass
+int TreeSimplify (program_t *program, tree_t *tree, simplifyLevel_t level)
 {
     assert (program);
     assert (tree);
 
-    bool modifiedFirst = true;
-    bool modifiedSecond = true;
-    while (modifiedFirst || modifiedSecond)
+    if (tree->root == NULL || level == SIMPLIFY_NONE)
+        return TREE_OK;
+
+    dynamicArray_t <nodeSimplifyFrame_t> stack = {};
+
+    size_t rewrites = 0;
+
+    int status = NodeSimplifyPush (tree, &stack, tree->root);
+
+    // frames, that are pushed, are finished even after error: they own their children
+    while (stack.size > 0)
     {
-        modifiedFirst  = false;
-        modifiedSecond = false;
+        nodeSimplifyFrame_t *frame = &stack.data[stack.size - 1];
+
+        if (frame->nextChild < NodeChildrenCount (frame->node) && status == TREE_OK)
+        {
+            size_t childIdx = frame->nextChild++;
+
+            node_t *child = (frame->node->type == TYPE_BLOCK) ? frame->node->value.block->statements[childIdx] :
+                            (childIdx == 0)                   ? frame->left : frame->right;
+
+            // leaves aren't changed by any rule
+            if (child != NULL && (child->left != NULL || child->right != NULL || child->type == TYPE_BLOCK))
+                status = NodeSimplifyPush (tree, &stack, child);
+
+            continue;
+        }
+
+        nodeSimplifyFrame_t done = *frame;
+        stack.size--;
+
+        node_t *node = NodeSimplifyDone (tree, &done, level, &rewrites, &status);
+
+        if (stack.size == 0)
+        {
+            tree->root = node;
+            break;
+        }
 
-        tree->root = NodeSimplifyCalc (tree, tree->root, &modifiedFirst);
-        TREE_DUMP (program, tree, "%s", "After NodeSimplifyCalc()");
+        nodeSimplifyFrame_t *parent = &stack.data[stack.size - 1];
+        size_t childIdx = parent->nextChild - 1;
 
-        tree->root = NodeSimplifyTrivial (tree, tree->root, &modifiedSecond);
-        TREE_DUMP (program, tree, "%s", "After NodeSimplifyTrivial()");
+        if (parent->node->type == TYPE_BLOCK)
+            parent->node->value.block->statements[childIdx] = node;
+        else if (childIdx == 0)
+            parent->left  = node;
+        else
+            parent->right = node;
     }
+
+    DynamicArrayDtor (&stack);
+
+    DEBUG_LOG ("%lu rewrites", rewrites);
+    TREE_DUMP (program, tree, "%s", "After TreeSimplify()");
+
+    return status;
+}
+
+int NodeSimplifyPush (tree_t *tree, dynamicArray_t <nodeSimplifyFrame_t> *stack, node_t *node)
+{
+    assert (tree);
+    assert (stack);
+    assert (node);
+
+    nodeSimplifyFrame_t frame = {.node = node};
+
+    // block isn't shared, its statements are changed in place
+    if (node->type != TYPE_BLOCK)
+        NodeUnpack (node, &frame.left, &frame.right);
+
+    int status = TreeStackPush (tree, stack, frame);
+
+    // node keeps children, it gave
+    if (status != TREE_OK && node->type != TYPE_BLOCK)
+        NodeRebuild (tree, node, frame.left, frame.right);
+
+    return status;
 }
 
+// Node gets its children back and rules are applied to it. After error node stays
+// as it is, and the tree is still whole
+node_t *NodeSimplifyDone (tree_t *tree, nodeSimplifyFrame_t *frame, simplifyLevel_t level,
+                          size_t *rewrites, int *status)
+{
+    assert (tree);
+    assert (frame);
+    assert (rewrites);
+    assert (status);
+
+    node_t *node = frame->node;
+
+    if (node->type == TYPE_BLOCK)
+    {
+        if (level >= SIMPLIFY_STATEMENTS && *status == TREE_OK)
+            BlockDropDeadStatements (tree, node, rewrites);
+
+        return node;
+    }
+
+    node_t *rebuilt = NodeRebuild (tree, node, frame->left, frame->right);
+    if (rebuilt == NULL)
+    {
+        // only shared node can't be made again, and it has its own references
+        if (frame->left != NULL)
+            TreeDelete (tree, &frame->left);
+        if (frame->right != NULL)
+            TreeDelete (tree, &frame->right);
+
+        *status = TREE_ERROR_CREATING_NODE;
+
+        return node;
+    }
+
+    node = rebuilt;
+
+    if (*status != TREE_OK)
+        return node;
+
+    bool modified = true;
+
+    while (modified)
+    {
+        modified = false;
+
+        node = NodeSimplifyCalc    (tree, node, &modified);
+        node = NodeSimplifyTrivial (tree, node, &modified);
+
+        if (level >= SIMPLIFY_STATEMENTS)
+            node = NodeSimplifyIf  (tree, node, &modified);
+
+        *rewrites += modified;
+    }
+
+    return node;
+}
+
+static double CalcDivide (double numerator, double denominator);
+
+// Numbers are integers, so operation is folded only if its exact result is integer too:
+// 4 / 3 stays as it is, whatever division target does. Overflow and division by zero
+// are left for runtime as well
 node_t *NodeSimplifyCalc (tree_t *tree, node_t *node, bool *modified)
 {
     assert (tree);
     assert (node);
     assert (modified);
 
-    if (node->left != NULL)
-        node->left = NodeSimplifyCalc (tree, node->left, modified);
+    if (node->type != TYPE_KEYWORD || node->right == NULL || node->right->type != TYPE_CONST_NUM)
+        return node;
 
-    if (node->right != NULL)
-        node->right = NodeSimplifyCalc (tree, node->right, modified);
-    
-    if (node->right == NULL) 
+    if (node->left != NULL && node->left->type != TYPE_CONST_NUM)
         return node;
 
-    valueNumber_t leftVal  = NAN;
-    valueNumber_t rightVal = NAN;
+    double leftVal  = NAN;
+    double rightVal = node->right->value.number;
 
     if (node->left != NULL)
         leftVal = node->left->value.number;
-    if (node->right != NULL)
-        rightVal = node->right->value.number;
 
-    node_t *newNode = NULL;
+    double result = NAN;
 
-    if (node->right->type == TYPE_CONST_NUM && 
-        (node->left == NULL || node->left->type  == TYPE_CONST_NUM))
+    switch (node->value.idx)
     {
-        switch (node->value.idx)
-        {
-            case KEY_ADD:    newNode = NUM_ (leftVal + rightVal);                             break;
-            case KEY_SUB:    newNode = NUM_ (leftVal - rightVal);                             break;
-            case KEY_MUL:    newNode = NUM_ (leftVal * rightVal);                             break;
-            case KEY_DIV:    newNode = NUM_ (leftVal / rightVal);                             break;
-            case KEY_POW:    newNode = NUM_ (valueNumber_t(pow (leftVal, rightVal)));         break;
-            case KEY_LOG:    newNode = NUM_ (valueNumber_t(logWithBase (leftVal, rightVal))); break;
-            case KEY_LN:     newNode = NUM_ (valueNumber_t(log (rightVal)));                  break;
-            case KEY_SIN:    newNode = NUM_ (valueNumber_t(sin (rightVal)));                  break;
-            case KEY_COS:    newNode = NUM_ (valueNumber_t(cos (rightVal)));                  break;
-            case KEY_TG:     newNode = NUM_ (valueNumber_t(tan (rightVal)));                  break;
-            case KEY_CTG:    newNode = NUM_ (valueNumber_t(1 / tan (rightVal)));              break;
-            case KEY_ARCSIN: newNode = NUM_ (valueNumber_t(asin (rightVal)));                 break;
-            case KEY_ARCCOS: newNode = NUM_ (valueNumber_t(acos (rightVal)));                 break;
-            case KEY_ARCTG:  newNode = NUM_ (valueNumber_t(atan (rightVal)));                 break;
-            case KEY_ARCCTG: newNode = NUM_ (valueNumber_t(1 / atan (rightVal)));             break;
-            case KEY_SH:     newNode = NUM_ (valueNumber_t(sinh (rightVal)));                 break;
-            case KEY_CH:     newNode = NUM_ (valueNumber_t(cosh (rightVal)));                 break;
-            case KEY_TH:     newNode = NUM_ (valueNumber_t(tanh (rightVal)));                 break;
-            case KEY_CTH:    newNode = NUM_ (valueNumber_t(1 / tanh (rightVal)));             break;
-            
-            case KEY_UKNOWN: 
-                ERROR_LOG ("%s", "Uknown math operation in node"); 
-                return NULL;
-            
-            default:
-                assert (0 && "Bro, add another case for NodeSimplifyCalc()");
-        }
+        case KEY_ADD:    result = leftVal + rightVal;                           break;
+        case KEY_SUB:    result = leftVal - rightVal;                           break;
+        case KEY_MUL:    result = leftVal * rightVal;                           break;
+        case KEY_DIV:    result = CalcDivide (leftVal, rightVal);               break;
+        case KEY_POW:    result = pow (leftVal, rightVal);                      break;
+        case KEY_LOG:    result = CalcDivide (log (rightVal), log (leftVal));   break;
+        case KEY_LN:     result = log (rightVal);                               break;
+        case KEY_SIN:    result = sin (rightVal);                               break;
+        case KEY_COS:    result = cos (rightVal);                               break;
+        case KEY_TG:     result = tan (rightVal);                               break;
+        case KEY_CTG:    result = CalcDivide (1, tan (rightVal));               break;
+        case KEY_ARCSIN: result = asin (rightVal);                              break;
+        case KEY_ARCCOS: result = acos (rightVal);                              break;
+        case KEY_ARCTG:  result = atan (rightVal);                              break;
+        case KEY_ARCCTG: result = CalcDivide (1, atan (rightVal));              break;
+        case KEY_SH:     result = sinh (rightVal);                              break;
+        case KEY_CH:     result = cosh (rightVal);                              break;
+        case KEY_TH:     result = tanh (rightVal);                              break;
+        case KEY_CTH:    result = CalcDivide (1, tanh (rightVal));              break;
+
+        // statements aren't calculated
+        default:
+            return node;
     }
-    
+
+    // NaN isn't in range either
+    if (!(kValueNumberMin <= result && result <= kValueNumberMax) || !IsEqual (result, round (result)))
+        return node;
+
+    node_t *newNode = NUM_ ((valueNumber_t) round (result));
     if (newNode == NULL)
         return node;
 
@@ -574,95 +857,304 @@ node_t *NodeSimplifyCalc (tree_t *tree, node_t *node, bool *modified)
     return newNode;
 }
 
-#define MUL_(left, right)                                                        \
-        NodeCtorAndFill (tree, TYPE_KEYWORD, {.idx = KEY_MUL},             \
-                         left, right)
+// NaN, if there is no finite result
+double CalcDivide (double numerator, double denominator)
+{
+    if (!isfinite (numerator) || !isfinite (denominator) || IsEqual (denominator, 0))
+        return NAN;
+
+    return numerator / denominator;
+}
+
+// What is left of node, when rule matches it
+enum simplifyResult_t
+{
+    SIMPLIFY_TO_LEFT,
+    SIMPLIFY_TO_RIGHT,
+    SIMPLIFY_TO_NUMBER,             // rule's resultNumber
+    SIMPLIFY_TO_MINUS_RIGHT,        // -1 * right
+};
+
+// Operation matches, when its child (0 - left, 1 - right) is number
+struct simplifyRule_t
+{
+    keywordIdxes_t operation    = KEY_UKNOWN;
+    size_t child                = 0;
+    valueNumber_t number        = 0;
+
+    simplifyResult_t result     = SIMPLIFY_TO_LEFT;
+    valueNumber_t resultNumber  = 0;
+};
+
+// first matching rule is applied
+static const simplifyRule_t kSimplifyRules[] =
+{
+    {KEY_ADD, 0, 0, SIMPLIFY_TO_RIGHT},             // 0 + x
+    {KEY_ADD, 1, 0, SIMPLIFY_TO_LEFT},              // x + 0
 
-#define cL NodeCopy (node->left,    tree)
-#define cR NodeCopy (node->right,   tree)
+    {KEY_SUB, 0, 0, SIMPLIFY_TO_MINUS_RIGHT},       // 0 - x
+    {KEY_SUB, 1, 0, SIMPLIFY_TO_LEFT},              // x - 0
 
-#define L left
-#define R right
+    {KEY_MUL, 0, 1, SIMPLIFY_TO_RIGHT},             // 1 * x
+    {KEY_MUL, 1, 1, SIMPLIFY_TO_LEFT},              // x * 1
+    {KEY_MUL, 0, 0, SIMPLIFY_TO_LEFT},              // 0 * x
+    {KEY_MUL, 1, 0, SIMPLIFY_TO_RIGHT},             // x * 0
 
-#define IS_VALUE_(childNode, numberValue)                        \
-        (node->childNode->type == TYPE_CONST_NUM &&              \
-        IsEqual (node->childNode->value.number, numberValue))   
+    {KEY_DIV, 1, 1, SIMPLIFY_TO_LEFT},              // x / 1, 0 / x isn't 0, if x is 0 at runtime
 
+    {KEY_POW, 1, 1, SIMPLIFY_TO_LEFT},              // x ^ 1
+    {KEY_POW, 1, 0, SIMPLIFY_TO_NUMBER, 1},         // x ^ 0
+    {KEY_POW, 0, 1, SIMPLIFY_TO_LEFT},              // 1 ^ x
+};
+
+static const simplifyRule_t *SimplifyRuleFind (tree_t *tree, node_t *node);
+static node_t *SimplifyRuleApply             (tree_t *tree, const simplifyRule_t *rule,
+                                              node_t *left, node_t *right);
+
+// Node is taken apart and the child, that is left, is linked to parent as it is,
+// so only node and the other child are freed
 node_t *NodeSimplifyTrivial (tree_t *tree, node_t *node, bool *modified)
 {
     assert (tree);
     assert (node);
     assert (modified);
 
-    if (node->left != NULL)
-        node->left = NodeSimplifyTrivial (tree, node->left, modified);
-
-    if (node->right != NULL)
-        node->right = NodeSimplifyTrivial (tree, node->right, modified);
-    
-    if (node->right == NULL) 
+    const simplifyRule_t *rule = SimplifyRuleFind (tree, node);
+    if (rule == NULL)
         return node;
 
+    node_t *left  = NULL;
+    node_t *right = NULL;
+
+    NodeUnpack (node, &left, &right);
+
+    node_t *newNode = SimplifyRuleApply (tree, rule, left, right);
+    if (newNode == NULL)
+        return NodeRebuild (tree, node, left, right);
+
+    NodeDeleteUnpacked (tree, &node);
+
+    *modified = true;
+
+    return newNode;
+}
+
+const simplifyRule_t *SimplifyRuleFind (tree_t *tree, node_t *node)
+{
+    assert (tree);
+    assert (node);
+
+    if (node->type != TYPE_KEYWORD || node->left == NULL || node->right == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < sizeof (kSimplifyRules) / sizeof (kSimplifyRules[0]); i++)
+    {
+        const simplifyRule_t *rule = &kSimplifyRules[i];
+
+        if (rule->operation != node->value.idx)
+            continue;
+
+        node_t *child = *NodeChild (node, rule->child);
+
+        if (child->type != TYPE_CONST_NUM || !IsEqual (child->value.number, rule->number))
+            continue;
+
+        bool isOtherDropped = (rule->result == SIMPLIFY_TO_NUMBER) ||
+                              (rule->result == SIMPLIFY_TO_LEFT  && rule->child == 0) ||
+                              (rule->result == SIMPLIFY_TO_RIGHT && rule->child == 1);
+
+        // x * 0 keeps x, if it reads input or calls function
+        if (isOtherDropped && NodeHasSideEffects (tree, *NodeChild (node, 1 - rule->child)))
+            continue;
+
+        return rule;
+    }
+
+    return NULL;
+}
+
+// Children, that aren't in the result, are deleted. After error nothing is changed
+node_t *SimplifyRuleApply (tree_t *tree, const simplifyRule_t *rule,
+                           node_t *left, node_t *right)
+{
+    assert (tree);
+    assert (rule);
+    assert (left);
+    assert (right);
+
     node_t *newNode = NULL;
 
-    switch (node->value.idx)
+    switch (rule->result)
     {
-        case KEY_ADD:
-            if (IS_VALUE_ (L, 0))
-                newNode = cR;
-            else if (IS_VALUE_ (R, 0))
-                newNode = cL;
-            break;
+        case SIMPLIFY_TO_LEFT:
+            TreeDelete (tree, &right);
 
-        case KEY_SUB:
-            if (IS_VALUE_ (L, 0))
-                newNode = MUL_ (NUM_(-1), cR);
-            else if (IS_VALUE_ (R, 0))
-                newNode = cL;
-            break;
+            return left;
 
-        case KEY_MUL:
-            if (IS_VALUE_ (L, 1))
-                newNode = cR;
-            else if (IS_VALUE_ (R, 1))
-                newNode = cL;
-            else if (IS_VALUE_ (L, 0) || IS_VALUE_ (R, 0))
-                newNode = NUM_ (0);
-            break;
-        
-        case KEY_DIV:
-            if (IS_VALUE_ (R, 1)) // (...) / 1
-                newNode = cL;
-            else if (IS_VALUE_ (L, 0)) // 0 / (...) 
-                newNode = NUM_ (0);
-            break;
+        case SIMPLIFY_TO_RIGHT:
+            TreeDelete (tree, &left);
 
-        case KEY_POW:
-            if (IS_VALUE_ (R, 1)) // ^1
-                newNode = cL;
-            else if (IS_VALUE_ (R, 0) || IS_VALUE_ (L, 1)) // (...)^0 || 1^(...)
-                newNode = NUM_ (1);
-            break;
+            return right;
+
+        case SIMPLIFY_TO_NUMBER:
+            newNode = NUM_ (rule->resultNumber);
+            if (newNode == NULL)
+                return NULL;
+
+            TreeDelete (tree, &left);
+            TreeDelete (tree, &right);
+
+            return newNode;
 
-        default: break;
+        case SIMPLIFY_TO_MINUS_RIGHT:
+        {
+            node_t *minusOne = NUM_ (-1);
+            if (minusOne == NULL)
+                return NULL;
+
+            newNode = NodeCtorAndFill (tree, TYPE_KEYWORD, {.idx = KEY_MUL}, minusOne, right);
+            if (newNode == NULL)
+            {
+                TreeDelete (tree, &minusOne);
+
+                return NULL;
+            }
+
+            TreeDelete (tree, &left);
+
+            return newNode;
+        }
+
+        default:
+            assert (0 && "Bro, add another case for SimplifyRuleApply()");
     }
 
-    if (newNode == NULL) 
+    return NULL;
+}
+
+// If with constant condition is replaced by its operation or by empty block,
+// the one with empty operation is dropped too, if its condition can be dropped
+node_t *NodeSimplifyIf (tree_t *tree, node_t *node, bool *modified)
+{
+    assert (tree);
+    assert (node);
+    assert (modified);
+
+    if (node->type != TYPE_KEYWORD || node->value.idx != KEY_IF)
         return node;
 
-    TreeDelete (tree, &node);
+    node_t *condition = node->left;
+    node_t *operation = node->right;
+
+    assert (condition);
+    assert (operation);
+
+    bool isEmpty = (operation->type == TYPE_BLOCK && operation->value.block->size == 0);
+
+    bool isTaken = false;
+
+    if (condition->type == TYPE_CONST_NUM)
+        isTaken = (condition->value.number != 0);
+    else if (!isEmpty || NodeHasSideEffects (tree, condition))
+        return node;
+
+    node_t *newNode = NULL;
+
+    if (!isTaken && !isEmpty)
+    {
+        newNode = NodeCtorBlock (tree, NULL, 0);
+        if (newNode == NULL)
+            return node;
+    }
+
+    NodeUnpack (node, &condition, &operation);
+    NodeDeleteUnpacked (tree, &node);
+
+    TreeDelete (tree, &condition);
+
+    if (newNode == NULL)
+        newNode = operation;
+    else
+        TreeDelete (tree, &operation);
 
     *modified = true;
 
     return newNode;
 }
 
-#undef MUL_
-#undef cL
-#undef cR
-#undef L
-#undef R
-#undef IS_VALUE_
+// Empty blocks and statements after return are never run. Blocks are simplified
+// before the ones, they are in, so block returns, if its last statement does
+void BlockDropDeadStatements (tree_t *tree, node_t *node, size_t *rewrites)
+{
+    assert (tree);
+    assert (node);
+    assert (node->type == TYPE_BLOCK);
+    assert (rewrites);
+
+    nodeBlock_t *block = node->value.block;
+
+    size_t size = 0;
+    bool isReturned = false;
+
+    for (size_t i = 0; i < block->size; i++)
+    {
+        node_t *statement = block->statements[i];
+
+        if (isReturned || (statement->type == TYPE_BLOCK && statement->value.block->size == 0))
+        {
+            TreeDelete (tree, &statement);
+            (*rewrites)++;
+
+            continue;
+        }
+
+        block->statements[size++] = statement;
+
+        while (statement->type == TYPE_BLOCK && statement->value.block->size > 0)
+            statement = statement->value.block->statements[statement->value.block->size - 1];
+
+        isReturned = (statement->type == TYPE_KEYWORD && statement->value.idx == KEY_RETURN);
+    }
+
+    block->size = size;
+}
+
+// Only arithmetic (KEY_ADD ... KEY_CTH go in a row) of numbers and variables can be dropped.
+// Input, calls and anything else are side effects, too deep expression is too
+bool NodeHasSideEffects (tree_t *tree, node_t *node)
+{
+    assert (tree);
+    assert (node);
+
+    dynamicArray_t <node_t *> stack = {};
+
+    bool hasSideEffects = false;
+
+    int status = TreeStackPush (tree, &stack, node);
+
+    while (status == TREE_OK && stack.size > 0)
+    {
+        node_t *cur = stack.data[--stack.size];
+
+        bool isPure = (cur->type == TYPE_CONST_NUM || cur->type == TYPE_VARIABLE || 
+                       cur->type == TYPE_NAME) ||
+                      (cur->type == TYPE_KEYWORD && KEY_ADD <= cur->value.idx && cur->value.idx <= KEY_CTH);
+        if (!isPure)
+        {
+            hasSideEffects = true;
+            break;
+        }
+
+        if (cur->left != NULL)
+            status = TreeStackPush (tree, &stack, cur->left);
+        if (cur->right != NULL && status == TREE_OK)
+            status = TreeStackPush (tree, &stack, cur->right);
+    }
+
+    DynamicArrayDtor (&stack);
+
+    return hasSideEffects || status != TREE_OK;
+}
 
 #undef NUM_
 
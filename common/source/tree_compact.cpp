@@ -0,0 +1,537 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "tree_compact.h"
+
+#include "tree.h"
+#include "tree_ast.h"
+
+// pointer node and its index in compact tree, children are linked to it in order
+struct compactFromFrame_t
+{
+    node_t *node            = NULL;
+    compactIdx_t idx        = kCompactNil;
+    size_t nextChild        = 0;
+};
+
+// node, that is written, and its child to write next
+struct compactSaveFrame_t
+{
+    compactIdx_t node       = kCompactNil;
+    size_t nextChild        = 0;
+};
+
+static int CompactNodeAppendFrom    (compactTree_t *compact, const node_t *node, compactIdx_t *idx);
+static treeDataType CompactNodeValue (const compactNode_t *node);
+static int CompactNodeSaveBegin     (FILE *file, program_t *program, compactTree_t *compact,
+                                     compactIdx_t node, dynamicArray_t <compactSaveFrame_t> *stack);
+
+void PrintTabsToFile (FILE *file, size_t n);
+
+const size_t kCompactSaveMaxTabs = 64;
+
+int CompactTreeCtor (compactTree_t *compact, size_t capacityHint)
+{
+    assert (compact);
+
+    compact->root = kCompactNil;
+
+    int status = DynamicArrayCtor (&compact->nodes, capacityHint + 1);
+    if (status == COMMON_ERROR_OK)
+        status = DynamicArrayCtor (&compact->statements, 0);
+
+    // nil
+    if (status == COMMON_ERROR_OK)
+        status = DynamicArrayResize (&compact->nodes, 1);
+
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    return TREE_OK;
+}
+
+void CompactTreeDtor (compactTree_t *compact)
+{
+    assert (compact);
+
+    DynamicArrayDtor (&compact->nodes);
+    DynamicArrayDtor (&compact->statements);
+
+    compact->root = kCompactNil;
+}
+
+// Statements of block or left and right child of any other node (they can be nil)
+size_t CompactNodeChildrenCount (const compactTree_t *compact, compactIdx_t node)
+{
+    assert (compact);
+    assert (node != kCompactNil && node < compact->nodes.size);
+
+    const compactNode_t *compactNode = &compact->nodes.data[node];
+
+    if (compactNode->kind != TYPE_BLOCK)
+        return 2;
+
+    return compactNode->value;
+}
+
+// pointer is valid until the next node or block is added
+compactIdx_t *CompactNodeChild (compactTree_t *compact, compactIdx_t node, size_t childIdx)
+{
+    assert (compact);
+    assert (childIdx < CompactNodeChildrenCount (compact, node));
+
+    compactNode_t *compactNode = &compact->nodes.data[node];
+
+    if (compactNode->kind == TYPE_BLOCK)
+        return &compact->statements.data[compactNode->left + childIdx];
+
+    return (childIdx == 0) ? &compactNode->left : &compactNode->right;
+}
+
+// Preorder walk, node gets its index when it's met. Frame is popped before the last
+// child, so stack doesn't grow on right-deep chains
+int CompactTreeFromTree (compactTree_t *compact, tree_t *tree)
+{
+    assert (compact);
+    assert (tree);
+
+    if (compact->root != kCompactNil)
+    {
+        ERROR_LOG ("%s", "TREE_ERROR_LOAD_INTO_NOT_EMPTY");
+
+        return TREE_ERROR_LOAD_INTO_NOT_EMPTY;
+    }
+
+    if (tree->root == NULL)
+        return TREE_OK;
+
+    if (tree->size >= kCompactMaxNodes)
+    {
+        ERROR_LOG ("Tree of %lu nodes doesn't fit in 32-bit indexes", tree->size);
+
+        return TREE_ERROR_TO_MUCH_NODES;
+    }
+
+    int status = DynamicArrayReserve (&compact->nodes, tree->size + 1);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    TREE_DO_AND_RETURN (CompactNodeAppendFrom (compact, tree->root, &compact->root));
+
+    dynamicArray_t <compactFromFrame_t> stack = {};
+
+    status = TreeStackPush (tree, &stack, {.node = tree->root, .idx = compact->root, .nextChild = 0});
+
+    while (status == TREE_OK && stack.size > 0)
+    {
+        compactFromFrame_t *frame = &stack.data[stack.size - 1];
+
+        size_t childrenCount = NodeChildrenCount (frame->node);
+
+        if (frame->nextChild >= childrenCount)
+        {
+            stack.size--;
+            continue;
+        }
+
+        size_t childIdx     = frame->nextChild++;
+        compactIdx_t parent = frame->idx;
+
+        node_t *child = *NodeChild (frame->node, childIdx);
+
+        if (frame->nextChild == childrenCount)
+            stack.size--;
+
+        if (child == NULL)
+            continue;
+
+        compactIdx_t idx = kCompactNil;
+
+        status = CompactNodeAppendFrom (compact, child, &idx);
+        if (status != TREE_OK)
+            break;
+
+        *CompactNodeChild (compact, parent, childIdx) = idx;
+
+        if (NodeChildrenCount (child) > 0)
+            status = TreeStackPush (tree, &stack, {.node = child, .idx = idx, .nextChild = 0});
+    }
+
+    DynamicArrayDtor (&stack);
+
+    return status;
+}
+
+// Children are nil and block has no statements: whoever appends the node links them
+int CompactNodeAppend (compactTree_t *compact, type_t type, treeDataType value, compactIdx_t *idx)
+{
+    assert (compact);
+    assert (idx);
+
+    if (compact->nodes.size > kCompactMaxNodes)
+    {
+        ERROR_LOG ("%s", "Compact tree is out of 32-bit indexes");
+
+        return TREE_ERROR_TO_MUCH_NODES;
+    }
+
+    compactNode_t compactNode = {.kind = (uint8_t) type};
+
+    switch (type)
+    {
+        case TYPE_CONST_NUM:
+            compactNode.value = (uint32_t) value.number;
+            break;
+
+        case TYPE_KEYWORD:
+        case TYPE_VARIABLE:
+        case TYPE_NAME:
+            if (value.idx > UINT32_MAX)
+            {
+                ERROR_LOG ("Idx %lu doesn't fit in compact node", value.idx);
+
+                return TREE_ERROR_INVALID_NODE;
+            }
+
+            compactNode.value = (uint32_t) value.idx;
+            break;
+
+        case TYPE_BLOCK:
+        case TYPE_UKNOWN:
+        default:
+            break;
+    }
+
+    int status = DynamicArrayPush (&compact->nodes, compactNode);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    *idx = (compactIdx_t) (compact->nodes.size - 1);
+
+    return TREE_OK;
+}
+
+// node of pointer tree, block gets place for its statements
+int CompactNodeAppendFrom (compactTree_t *compact, const node_t *node, compactIdx_t *idx)
+{
+    assert (compact);
+    assert (node);
+    assert (idx);
+
+    TREE_DO_AND_RETURN (CompactNodeAppend (compact, node->type, node->value, idx));
+
+    if (node->type != TYPE_BLOCK)
+        return TREE_OK;
+
+    size_t size  = NodeChildrenCount (node);
+    size_t first = compact->statements.size;
+
+    if (first + size > UINT32_MAX)
+    {
+        ERROR_LOG ("%s", "Statements of blocks are out of 32-bit indexes");
+
+        return TREE_ERROR_TO_MUCH_NODES;
+    }
+
+    int status = DynamicArrayResize (&compact->statements, first + size);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    compact->nodes.data[*idx].value = (uint32_t) size;
+    compact->nodes.data[*idx].left  = (compactIdx_t) first;
+
+    return TREE_OK;
+}
+
+treeDataType CompactNodeValue (const compactNode_t *node)
+{
+    assert (node);
+
+    if (node->kind == TYPE_CONST_NUM)
+        return {.number = (valueNumber_t) node->value};
+
+    return {.idx = node->value};
+}
+
+// Every child is after its parent in the array, so nodes are made from the end: node is
+// made with its children, that are made already. So DAG mode shares them as usual
+int CompactTreeToTree (compactTree_t *compact, tree_t *tree)
+{
+    assert (compact);
+    assert (tree);
+
+    if (tree->root != NULL)
+    {
+        ERROR_LOG ("%s", "TREE_ERROR_LOAD_INTO_NOT_EMPTY");
+
+        return TREE_ERROR_LOAD_INTO_NOT_EMPTY;
+    }
+
+    if (compact->root == kCompactNil)
+        return TREE_OK;
+
+    TREE_DO_AND_RETURN (CompactTreeVerify (compact));
+
+    size_t nodesCount = compact->nodes.size;
+
+    // made[0] is nil, statements of blocks are after the nodes
+    node_t **made = (node_t **) calloc (nodesCount + compact->statements.size, sizeof (node_t *));
+    if (made == NULL)
+    {
+        ERROR_LOG ("Error allocating memory for %lu nodes - %s", nodesCount, strerror (errno));
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_ALLOCATING_MEMORY;
+    }
+
+    node_t **statements = made + nodesCount;
+
+    for (size_t i = nodesCount - 1; i >= 1; i--)
+    {
+        const compactNode_t *compactNode = &compact->nodes.data[i];
+
+        if (compactNode->kind == TYPE_BLOCK)
+        {
+            const compactIdx_t *blockStatements = compact->statements.data + compactNode->left;
+
+            for (size_t child = 0; child < compactNode->value; child++)
+                statements[compactNode->left + child] = made[blockStatements[child]];
+
+            made[i] = NodeCtorBlock (tree, statements + compactNode->left, compactNode->value);
+        }
+        else
+        {
+            made[i] = NodeCtorAndFill (tree, (type_t) compactNode->kind, CompactNodeValue (compactNode),
+                                       made[compactNode->left], made[compactNode->right]);
+        }
+
+        if (made[i] != NULL)
+            continue;
+
+        // subtrees, that are made, hang from nodes, that aren't
+        for (size_t parent = 1; parent <= i; parent++)
+        {
+            size_t childrenCount = CompactNodeChildrenCount (compact, (compactIdx_t) parent);
+
+            for (size_t child = 0; child < childrenCount; child++)
+            {
+                compactIdx_t childIdx = *CompactNodeChild (compact, (compactIdx_t) parent, child);
+
+                if (made[childIdx] != NULL)
+                    TreeDelete (tree, &made[childIdx]);
+            }
+        }
+
+        free (made);
+
+        return TREE_ERROR_CREATING_NODE;
+    }
+
+    tree->root = made[compact->root];
+
+    free (made);
+
+    return TREE_OK;
+}
+
+// One pass through the array, without walking the tree: every child is after its parent
+// and every node except root has exactly one parent. Then it's a tree and root is nodes[1]
+int CompactTreeVerify (compactTree_t *compact)
+{
+    if (compact == NULL) return TREE_ERROR_NULL_STRUCT;
+    if (compact->nodes.size == 0 || compact->nodes.data == NULL) return TREE_ERROR_NULL_DATA;
+
+    size_t nodesCount = compact->nodes.size;
+
+    if (compact->root == kCompactNil)
+        return (nodesCount == 1) ? TREE_OK : TREE_ERROR_NULL_ROOT;
+
+    if (compact->root != 1)
+    {
+        ERROR_LOG ("Root of compact tree is nodes[%u], not nodes[1]", compact->root);
+
+        return TREE_ERROR_INVALID_NODE;
+    }
+
+    // parents of every node, saturated at 2
+    uint8_t *parents = (uint8_t *) calloc (nodesCount, sizeof (uint8_t));
+    if (parents == NULL)
+    {
+        ERROR_LOG ("Error allocating memory for %lu nodes - %s", nodesCount, strerror (errno));
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_ALLOCATING_MEMORY;
+    }
+
+    int error = TREE_OK;
+
+    for (size_t i = 1; i < nodesCount && error == TREE_OK; i++)
+    {
+        const compactNode_t *node = &compact->nodes.data[i];
+
+        size_t childrenCount = 2;
+
+        switch ((type_t) node->kind)
+        {
+            case TYPE_CONST_NUM:
+            case TYPE_KEYWORD:
+            case TYPE_VARIABLE:
+            case TYPE_NAME:
+                break;
+
+            case TYPE_BLOCK:
+                childrenCount = node->value;
+
+                if ((size_t) node->left + childrenCount > compact->statements.size)
+                {
+                    ERROR_LOG ("Statements of block nodes[%lu] are out of array", i);
+
+                    error = TREE_ERROR_INVALID_NODE;
+                }
+                break;
+
+            case TYPE_UKNOWN:
+            default:
+                ERROR_LOG ("Uknown kind %u of nodes[%lu]", node->kind, i);
+
+                error = TREE_ERROR_INVALID_NODE;
+                break;
+        }
+
+        for (size_t child = 0; child < childrenCount && error == TREE_OK; child++)
+        {
+            compactIdx_t childIdx = *CompactNodeChild (compact, (compactIdx_t) i, child);
+
+            if (childIdx == kCompactNil)
+                continue;
+
+            if (childIdx <= i || childIdx >= nodesCount)
+            {
+                ERROR_LOG ("Child %u of nodes[%lu] isn't after it in the array", childIdx, i);
+
+                error = TREE_ERROR_INVALID_NODE;
+            }
+            else if (parents[childIdx]++ != 0)
+            {
+                ERROR_LOG ("nodes[%u] has more than one parent", childIdx);
+
+                error = TREE_ERROR_TO_MUCH_NODES;
+            }
+        }
+    }
+
+    for (size_t i = 2; i < nodesCount && error == TREE_OK; i++)
+    {
+        if (parents[i] == 0)
+        {
+            ERROR_LOG ("nodes[%lu] isn't in the tree", i);
+
+            error = TREE_ERROR_NOT_ENOUGH_NODES;
+        }
+    }
+
+    free (parents);
+
+    return error;
+}
+
+int CompactTreeSaveToFile (program_t *program, compactTree_t *compact, const char *fileName)
+{
+    assert (program);
+    assert (compact);
+    assert (fileName);
+
+    DEBUG_STR (fileName);
+
+    FILE *outputFile = fopen (fileName, "w");
+    if (outputFile == NULL)
+    {
+        ERROR_LOG ("Error opening file \"%s\"", fileName);
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_OPENING_FILE;
+    }
+
+    int status = CompactNodeSaveToFile (outputFile, program, compact, compact->root);
+
+    fclose (outputFile);
+
+    return status;
+}
+
+// Same format as NodeSaveToFile (), so files are loaded by TreeLoadPrefixFromFile ()
+int CompactNodeSaveToFile (FILE *file, program_t *program, compactTree_t *compact,
+                           compactIdx_t node)
+{
+    assert (file);
+    assert (program);
+    assert (compact);
+    assert (node != kCompactNil);
+
+    dynamicArray_t <compactSaveFrame_t> stack = {};
+
+    int status = CompactNodeSaveBegin (file, program, compact, node, &stack);
+
+    while (status == TREE_OK && stack.size > 0)
+    {
+        size_t depth = stack.size;
+        size_t tabs  = (depth < kCompactSaveMaxTabs) ? depth : kCompactSaveMaxTabs;
+
+        compactSaveFrame_t *frame = &stack.data[depth - 1];
+
+        if (frame->nextChild == CompactNodeChildrenCount (compact, frame->node))
+        {
+            fprintf (file, "%s", "\n");
+            PrintTabsToFile (file, (depth - 1 < kCompactSaveMaxTabs) ? depth - 1 : kCompactSaveMaxTabs);
+
+            fprintf (file, "%s", ")");
+
+            stack.size--;
+
+            continue;
+        }
+
+        compactIdx_t child = *CompactNodeChild (compact, frame->node, frame->nextChild++);
+
+        fprintf (file, "%s", "\n");
+        PrintTabsToFile (file, tabs);
+
+        if (child != kCompactNil)
+            status = CompactNodeSaveBegin (file, program, compact, child, &stack);
+        else
+            fprintf (file, "%s", "nil");
+    }
+
+    DynamicArrayDtor (&stack);
+
+    return status;
+}
+
+// writes node itself, its children are written, when it's on the top of the stack
+int CompactNodeSaveBegin (FILE *file, program_t *program, compactTree_t *compact,
+                          compactIdx_t node, dynamicArray_t <compactSaveFrame_t> *stack)
+{
+    assert (file);
+    assert (program);
+    assert (compact);
+    assert (stack);
+
+    const compactNode_t *compactNode = &compact->nodes.data[node];
+
+    // PrintNode () looks only at type and value, block is printed by type
+    node_t printed = {.type  = (type_t) compactNode->kind,
+                      .value = CompactNodeValue (compactNode)};
+
+    fprintf (file, "%s", "( ");
+
+    TREE_DO_AND_RETURN (PrintNode (file, program, &printed, false));
+
+    return TreeStackPush (&program->ast, stack, {.node = node, .nextChild = 0});
+}
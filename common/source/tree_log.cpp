@@ -261,6 +261,7 @@ void TreePrefixPass (program_t *program, node_t *node, FILE *graphFile)
                                     break;
         case TYPE_NAME:
         case TYPE_VARIABLE:         fprintf (graphFile, "\"%s\";", kViolet);    break;
+        case TYPE_BLOCK:            fprintf (graphFile, "\"%s\";", kGreen);     break;
         default:                    fprintf (graphFile, "\"%s\";", kRed);       break;
     }
 
@@ -281,6 +282,20 @@ void TreePrefixPass (program_t *program, node_t *node, FILE *graphFile)
     // DEBUG_LOG ("\t node->left: %p", node->left);
     // DEBUG_LOG ("\t node->right: %p", node->right);
 
+    if (node->type == TYPE_BLOCK)
+    {
+        for (size_t i = 0; i < NodeChildrenCount (node); i++)
+        {
+            node_t *statement = *NodeChild (node, i);
+
+            fprintf (graphFile, "\tnode%p->node%p[label=\"%lu\"]\n", node, statement, i);
+
+            TreePrefixPass (program, statement, graphFile);
+        }
+
+        return;
+    }
+
     if (node->left != NULL)
     {
         DEBUG_LOG ("\t %p->%p\n", node, node->left);
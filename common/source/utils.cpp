@@ -2,14 +2,20 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <string.h>
 #include <errno.h>
 
 #include "utils.h"
 
 #include "debug.h"
+#include "dynamic_array.h"
+#include "simd_scan.h"
 
-ssize_t GetFileSize (const char *fileName);
+static int SourceBufferMap  (sourceBuffer_t *source, int fd, size_t fileSize);
+static int SourceBufferRead (sourceBuffer_t *source, int fd);
 
 int SafeMkdir (const char *fileName)
 {
@@ -44,79 +50,286 @@ void ClearBuffer()
     }
 }
 
-ssize_t GetFileSize (const char *fileName)
+int SourceBufferOpen (sourceBuffer_t *source, const char *fileName)
 {
-    struct stat fileStat;
+    assert (source);
+    assert (fileName);
 
-    int status = stat (fileName, &fileStat);
-    if (status != 0)
+    source->data      = NULL;
+    source->size      = 0;
+    source->mappedLen = 0;
+
+    bool isStdin = strcmp (fileName, "-") == 0;
+
+    int fd = isStdin ? STDIN_FILENO : open (fileName, O_RDONLY);
+    if (fd == -1)
     {
-        perror ("Error getting file size");
+        ERROR_LOG ("Error opening input file \"%s\" - %s", fileName, strerror (errno));
 
-        return -1;
+        return COMMON_ERROR_OPENING_FILE;
     }
-    
-    return fileStat.st_size;
+
+    struct stat fileStat = {};
+    if (fstat (fd, &fileStat) != 0)
+    {
+        ERROR_LOG ("Error getting size of \"%s\" - %s", fileName, strerror (errno));
+
+        if (!isStdin)
+            close (fd);
+
+        return COMMON_ERROR_READING_FILE;
+    }
+
+    int status = COMMON_ERROR_READING_FILE;
+
+    // mmap () can't map empty file
+    if (S_ISREG (fileStat.st_mode) && fileStat.st_size > 0)
+        status = SourceBufferMap (source, fd, (size_t) fileStat.st_size);
+
+    if (status != COMMON_ERROR_OK)
+        status = SourceBufferRead (source, fd);
+
+    if (!isStdin)
+        close (fd);
+
+    if (status != COMMON_ERROR_OK)
+        ERROR_LOG ("Error reading \"%s\"", fileName);
+
+    return status;
 }
-// creat content buffer fileSize + 1
-// content[fileSize] = '\0'
-char *ReadFile (const char *inputFileName, size_t *bufferLen)
+
+// Anonymous zero pages are reserved for file + 1 byte, then the file is mapped over them.
+// So there is always '\0' after the file, even if its size is a multiple of page size
+int SourceBufferMap (sourceBuffer_t *source, int fd, size_t fileSize)
 {
-    assert (inputFileName);
-    assert (bufferLen);
-    
-    FILE *inputFile = fopen (inputFileName, "r");
-    if (inputFile == NULL)
+    assert (source);
+
+    size_t pageSize  = (size_t) sysconf (_SC_PAGESIZE);
+    size_t mappedLen = (fileSize + 1 + pageSize - 1) / pageSize * pageSize;
+
+    void *area = mmap (NULL, mappedLen, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED)
     {
-        ERROR_LOG ("Error opening input file \"%s\"", inputFileName);
-        
-        return NULL;
+        DEBUG_LOG ("mmap () of %lu bytes failed - %s", mappedLen, strerror (errno));
+
+        return COMMON_ERROR_ALLOCATING_MEMORY;
     }
 
-    ssize_t fileSize = GetFileSize (inputFileName);
-    if (fileSize == -1)
-        return NULL;
-        
-    *bufferLen = (size_t) fileSize + 1;
+    void *file = mmap (area, fileSize, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (file == MAP_FAILED)
+    {
+        DEBUG_LOG ("mmap () of file failed - %s", strerror (errno));
+
+        munmap (area, mappedLen);
+
+        return COMMON_ERROR_READING_FILE;
+    }
+
+    madvise (file, fileSize, MADV_SEQUENTIAL);
+
+    source->data      = (char *) file;
+    source->size      = fileSize;
+    source->mappedLen = mappedLen;
 
-    char *content = (char *) calloc (*bufferLen, sizeof(char));
+    return COMMON_ERROR_OK;
+}
+
+// for pipes and other files without known size
+int SourceBufferRead (sourceBuffer_t *source, int fd)
+{
+    assert (source);
 
-    if (content == NULL)
+    const size_t kReadChunkSize = 64 * 1024;
+
+    dynamicArray_t <char> content = {};
+
+    while (true)
     {
-        perror ("Failed to allocate memory for text");
+        int status = DynamicArrayReserve (&content, DynamicArrayGrowCapacity (content.capacity,
+                                                                              content.size + kReadChunkSize));
+        if (status != COMMON_ERROR_OK)
+        {
+            DynamicArrayDtor (&content);
 
-        fclose (inputFile);
+            return status;
+        }
+
+        ssize_t bytesRead = read (fd, content.data + content.size, content.capacity - content.size);
+        if (bytesRead == -1 && errno == EINTR)
+            continue;
+
+        if (bytesRead == -1)
+        {
+            ERROR_LOG ("Error reading input - %s", strerror (errno));
+
+            DynamicArrayDtor (&content);
+
+            return COMMON_ERROR_READING_FILE;
+        }
 
-        return NULL;
+        if (bytesRead == 0)
+            break;
+
+        content.size += (size_t) bytesRead;
     }
 
-    size_t bytesRead = fread (content, sizeof(char), (size_t)fileSize, inputFile);
-    fclose (inputFile);
+    int status = DynamicArrayPush (&content, '\0');
+    if (status != COMMON_ERROR_OK)
+    {
+        DynamicArrayDtor (&content);
+
+        return status;
+    }
+
+    source->data      = content.data;
+    source->size      = content.size - 1;
+    source->mappedLen = 0;
+
+    return COMMON_ERROR_OK;
+}
+
+void SourceBufferClose (sourceBuffer_t *source)
+{
+    assert (source);
+
+    if (source->mappedLen != 0)
+        munmap (source->data, source->mappedLen);
+    else
+        free (source->data);
+
+    source->data      = NULL;
+    source->size      = 0;
+    source->mappedLen = 0;
+}
 
-    if ((ssize_t)bytesRead != fileSize)
+// Bytes [begin, end) are replaced by text. Mapped file is copied into allocated memory,
+// the tail after end is moved, so it costs O(size) of memmove
+int SourceBufferEdit (sourceBuffer_t *source, size_t begin, size_t end, 
+                      const char *text, size_t textLen)
+{
+    assert (source);
+    assert (source->data);
+    assert (begin <= end && end <= source->size);
+    assert (text != NULL || textLen == 0);
+
+    size_t newSize = source->size - (end - begin) + textLen;
+    char *data     = source->data;
+
+    if (source->mappedLen != 0)
     {
-        ERROR_LOG ("fread() status code(how many bytes read) is: %lu", bytesRead);
-        ERROR_LOG ("fileSize is: %ld", fileSize);
+        data = (char *) malloc (newSize + 1);
+        if (data == NULL)
+        {
+            ERROR_LOG ("Error allocating memory for %lu bytes source - %s", newSize, strerror (errno));
+
+            return COMMON_ERROR_ALLOCATING_MEMORY;
+        }
+
+        memcpy (data, source->data, begin);
+        memcpy (data + begin + textLen, source->data + end, source->size - end + 1);
 
-        free (content);
+        munmap (source->data, source->mappedLen);
+        source->mappedLen = 0;
+    }
+    else
+    {
+        if (newSize > source->size)
+        {
+            data = (char *) realloc (data, newSize + 1);
+            if (data == NULL)
+            {
+                ERROR_LOG ("Error reallocating memory for %lu bytes source - %s", 
+                           newSize, strerror (errno));
+
+                return COMMON_ERROR_REALLOCATING_MEMORY;
+            }
+        }
 
-        return NULL;
+        memmove (data + begin + textLen, data + end, source->size - end + 1);
     }
 
-    return content;
+    if (textLen > 0)
+        memcpy (data + begin, text, textLen);
+
+    source->data = data;
+    source->size = newSize;
+
+    return COMMON_ERROR_OK;
 }
 
-char *SkipSpaces (char *buffer)
+static size_t ScanDigits (const char *str, uint64_t *value, bool *isOverflow);
+
+// digits are accumulated until overflow, the rest of them are only skipped
+size_t ScanDigits (const char *str, uint64_t *value, bool *isOverflow)
 {
-    assert (buffer);
+    assert (str);
+    assert (value);
+    assert (isOverflow);
+
+    const unsigned kBase = 10;
 
-    while (isspace (*buffer))
+    size_t len = 0;
+    uint64_t result = 0;
+
+    for (unsigned digit = (unsigned) (str[0] - '0'); digit < kBase; digit = (unsigned) (str[len] - '0'))
     {
-        // DEBUG_LOG ("%d - '%c'", *buffer, *buffer);
-        buffer++;
+        if (__builtin_mul_overflow (result, kBase, &result) ||
+            __builtin_add_overflow (result, digit, &result))
+        {
+            *isOverflow = true;
+            result = UINT64_MAX;
+        }
+
+        len++;
     }
 
-    return buffer;
+    *value = result;
+
+    return len;
+}
+
+size_t ScanNumber (const char *str, numberLiteral_t *literal)
+{
+    assert (str);
+    assert (literal);
+
+    *literal = {};
+
+    size_t len = ScanDigits (str, &literal->integer, &literal->isOverflow);
+    if (len == 0)
+        return 0;
+
+    // "1." and "1.e" are integer 1 followed by something else
+    if (str[len] == '.' && str[len + 1] >= '0' && str[len + 1] <= '9')
+    {
+        literal->fractionDigits = ScanDigits (str + len + 1, &literal->fraction, &literal->isOverflow);
+
+        len += 1 + literal->fractionDigits;
+    }
+
+    return len;
+}
+
+size_t Utf8Length (const char *str, size_t len)
+{
+    assert (str);
+
+    size_t charsCount = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if ((str[i] & 0xC0) != 0x80)
+            charsCount++;
+    }
+
+    return charsCount;
+}
+
+char *SkipSpaces (char *buffer)
+{
+    assert (buffer);
+
+    return buffer + ScanSpaces (buffer);
 }
 
 char *SkipSpacesAndCount (char *buffer, size_t *line, size_t *position)
@@ -125,21 +338,22 @@ char *SkipSpacesAndCount (char *buffer, size_t *line, size_t *position)
     assert (line);
     assert (position);
 
-    while (isspace (*buffer))
-    {
-        DEBUG_CHR (*buffer);
+    size_t spacesLen = ScanSpaces (buffer);
+    size_t newLines  = ScanCountNewLines (buffer, spacesLen);
 
-        if (*buffer == '\n')
-        {
-            (*line)++;
-            *position = 0;
-        }
+    if (newLines == 0)
+    {
+        *position += spacesLen;
 
-        (*position)++;
-        buffer++;
+        return buffer + spacesLen;
     }
 
-    return buffer;
+    const char *lastNewLine = (const char *) memrchr (buffer, '\n', spacesLen);
+
+    *line     += newLines;
+    *position  = size_t (buffer + spacesLen - lastNewLine);
+
+    return buffer + spacesLen;
 }
 
 int SafeReadLine (char **str, size_t *len)
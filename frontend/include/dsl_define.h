@@ -20,6 +20,8 @@
 #define CONNECT_(left, right)                                                           \
         NodeCtorAndFill (&program->ast, TYPE_KEYWORD, {.idx = KEY_CONNECT},             \
                          left, right)
+#define BLOCK_(statements, size)                                                        \
+        NodeCtorBlock (&program->ast, statements, size)
 #define COMMA_(left, right)                                                             \
         NodeCtorAndFill (&program->ast, TYPE_KEYWORD, {.idx = KEY_COMMA},               \
                          left, right)
@@ -7,6 +7,7 @@
 
 #undef NUM_
 #undef CONNECT_
+#undef BLOCK_
 #undef IF_
 #undef ASSIGN_
 #undef ADD_
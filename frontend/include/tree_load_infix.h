@@ -6,5 +6,6 @@
 #include "tokenizator.h"
 
 int TreeLoadInfixFromTokens (program_t *program);
+int TreeLoadInfixAfterEdit  (program_t *program, const tokensEdit_t *tokensEdit);
 
 #endif // K_TREE_LOAD_INFIX
\ No newline at end of file
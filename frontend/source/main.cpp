@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "tree.h"
@@ -7,52 +8,99 @@
 #include "tokenizator.h"
 #include "tree_load_infix.h"
 
-#define MAIN_DO_AND_CLEAR(action, clearAction)                          \
-        do                                                              \
-        {                                                               \
-            int statusMacro = action;                                   \
-            DEBUG_VAR("%d", statusMacro);                               \
-                                                                        \
-            if (statusMacro != TREE_OK)                                 \
-            {                                                           \
-                clearAction;                                            \
-                                                                        \
-                DEBUG_VAR("%d", statusMacro);                           \
-                ERROR_PRINT ("%s", "Error occured in \"" #action "\""); \
-                return 1;                                               \
-            }                                                           \
-        } while (0)
-
-#define MAIN_DO_AND_RETURN(action)                                      \
-        do                                                              \
-        {                                                               \
-            int statusMacro = action;                                   \
-            DEBUG_VAR("%d", statusMacro);                               \
-                                                                        \
-            if (statusMacro != TREE_OK)                                 \
-            {                                                           \
-                ERROR_PRINT ("%s", "Error occured in \"" #action "\""); \
-                return 1;                                               \
-            }                                                           \
-        } while (0)
-
-
 int main(int argc, char **argv)
 {
-    if (argc != 2)
+    // -j<N>  - number of lexer threads, by default all CPUs are used for big sources
+    // -s[N]  - source is read by blocks of N bytes and lexed while parsing,
+    //          so lexer memory doesn't depend on source size
+    // -d<N>  - depth budget of tree traversals (nested blocks, statements in function)
+    // -c     - identical subtrees are kept once (hash-consing), repetitive programs take less memory
+    // -O[N]  - ast is simplified before it's saved: -O1 folds constants and drops x * 1, x + 0, ...,
+    //          -O2 drops dead code too. -O0 by default, -O is -O1
+    size_t lexerThreads     = 0;
+    size_t streamBlockSize  = 0;
+    size_t depthBudget      = kTreeDefaultDepthBudget;
+    bool isShared           = false;
+    simplifyLevel_t level   = SIMPLIFY_NONE;
+
+    int argIdx = 1;
+
+    for (; argIdx < argc - 1 && argv[argIdx][0] == '-'; argIdx++)
     {
-        ERROR_PRINT ("Launch program like this: %s source_file.rap", argv[0]);
+        const char *option = argv[argIdx];
+
+        if (strncmp (option, "-j", sizeof ("-j") - 1) == 0)
+        {
+            lexerThreads = strtoul (option + sizeof ("-j") - 1, NULL, 10);
+        }
+        else if (strncmp (option, "-s", sizeof ("-s") - 1) == 0)
+        {
+            streamBlockSize = kTokensStreamBlockSize;
+
+            if (option[sizeof ("-s") - 1] != '\0')
+                streamBlockSize = strtoul (option + sizeof ("-s") - 1, NULL, 10);
+
+            if (streamBlockSize == 0)
+                break;
+        }
+        else if (strncmp (option, "-d", sizeof ("-d") - 1) == 0)
+        {
+            depthBudget = strtoul (option + sizeof ("-d") - 1, NULL, 10);
+
+            if (depthBudget == 0)
+                break;
+        }
+        else if (strcmp (option, "-c") == 0)
+        {
+            isShared = true;
+        }
+        else if (strncmp (option, "-O", sizeof ("-O") - 1) == 0)
+        {
+            size_t number = SIMPLIFY_EXPRESSIONS;
+
+            if (option[sizeof ("-O") - 1] != '\0')
+                number = strtoul (option + sizeof ("-O") - 1, NULL, 10);
+
+            if (number > SIMPLIFY_STATEMENTS)
+                break;
+
+            level = (simplifyLevel_t) number;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argIdx != argc - 1)
+    {
+        ERROR_PRINT ("Launch program like this: %s [-j<threads>] [-s[<block size>]] [-d<depth>] [-c] [-O<level>] "
+                     "source_file.rap", 
+                     argv[0]);
 
         return 1;
     }
 
+    const char *sourceFileName = argv[argIdx];
+
     program_t program = {};
 
     MAIN_DO_AND_RETURN (ProgramCtor (&program));
 
+    program.ast.depthBudget = depthBudget;
+    program.ast.isShared    = isShared;
+
     
-    MAIN_DO_AND_CLEAR (GetTokens (argv[1], &program),
-                       ProgramDtor (&program));
+    if (streamBlockSize != 0)
+    {
+        MAIN_DO_AND_CLEAR (TokenStreamOpen (sourceFileName, &program, streamBlockSize),
+                           ProgramDtor (&program));
+    }
+    else
+    {
+        MAIN_DO_AND_CLEAR (GetTokens (sourceFileName, &program, lexerThreads),
+                           ProgramDtor (&program));
+    }
 
     DumpTokens     (&program);
     NamesTableDump (&program.namesTable);
@@ -60,6 +108,9 @@ int main(int argc, char **argv)
     MAIN_DO_AND_CLEAR (TreeLoadInfixFromTokens (&program),
                        ProgramDtor (&program));
 
+    MAIN_DO_AND_CLEAR (TreeSimplify (&program, &program.ast, level),
+                       ProgramDtor (&program));
+
     MAIN_DO_AND_CLEAR (TreeAstSaveToFile (&program, ktreeSaveFileName),
                        ProgramDtor (&program));
 
@@ -69,9 +69,8 @@ Print               ::= "зачитать" '(' Expression ')' "тррря"
 Return              ::= "лучше_я_сдохну_чем_стану" Expression
 DeclarateOrAssign   ::= "мс " Variable  {"представься" | "стал"} Expression "тррря"
 
-Expression          ::= Term        {['фит', 'дисс']        Term}* 
-Term                ::= Power       {['антихайп', 'хайп']  Power}*
-Power               ::= PrimaryExp  {'^'  PrimaryExp}* 
+Expression          ::= PrimaryExp  {BinaryOperator PrimaryExp}*
+BinaryOperator      ::= ['фит', 'дисс' | 'хайп', 'антихайп' | '^']  // precedence grows, '^' is right associative
 PrimaryExp          ::=  {'('  Expression ')' | Number | BuiltinFunction | FunctionCall | Variable } // FIXME
 
 FunctionCall        ::= "зачитать" FuncName '(' ')'
@@ -85,13 +84,25 @@ Name                ::= ['a'-'z', 'A'-'Z', '_']['a'-'z', 'A'-'Z', '0'-'9', '_']*
 
 */
 
+// lexical error in stream mode is found by parser, it's already reported
+#define RETURN_IF_STREAM_FAILED                                         \
+        if (tokens->stream != NULL && tokens->stream->status != TREE_OK)\
+            return TREE_ERROR_SYNTAX_IN_SAVE_FILE
+
 #define SYNTAX_ERROR                                                    \
         do                                                              \
         {                                                               \
+            RETURN_IF_STREAM_FAILED;                                    \
+                                                                        \
+            size_t errorLine   = 0;                                     \
+            size_t errorColumn = 0;                                     \
+            TokenGetLineAndColumn (tokens, *curToken,                   \
+                                   &errorLine, &errorColumn);           \
+                                                                        \
             ERROR_LOG ("%s:%lu:%lu Syntax Error with token [%lu]",      \
                        program->tokens.fileName,                        \
-                       tokens->data[*curToken].line,                    \
-                       tokens->data[*curToken].position,                \
+                       errorLine,                                       \
+                       errorColumn,                                     \
                        *curToken);                                      \
                                                                         \
             return TREE_ERROR_SYNTAX_IN_SAVE_FILE;                      \
@@ -101,10 +112,16 @@ Name                ::= ['a'-'z', 'A'-'Z', '_']['a'-'z', 'A'-'Z', '0'-'9', '_']*
 #define SYNTAX_ERROR_MESSAGE(format, ...)                                               \
         do                                                                              \
         {                                                                               \
+            RETURN_IF_STREAM_FAILED;                                                    \
+                                                                                        \
+            size_t errorLine   = 0;                                                     \
+            size_t errorColumn = 0;                                                     \
+            TokenGetLineAndColumn (tokens, *curToken, &errorLine, &errorColumn);        \
+                                                                                        \
             ERROR_PRINT ("%s:%lu:%lu Syntax Error with token [%lu] :\n" format "\n",    \
                          program->tokens.fileName,                                      \
-                         tokens->data[*curToken].line,                                  \
-                         tokens->data[*curToken].position,                              \
+                         errorLine,                                                     \
+                         errorColumn,                                                   \
                          *curToken,                                                     \
                          __VA_ARGS__);                                                  \
                                                                                         \
@@ -112,21 +129,55 @@ Name                ::= ['a'-'z', 'A'-'Z', '_']['a'-'z', 'A'-'Z', '0'-'9', '_']*
         }                                                                               \
         while (0)
 
+const int kMinPrecedence = 1; // of any binary operator in kKeywords[]
+
+// "биф" with its condition or "пошумим" with its first operation in stack of statements
+struct operationFrame_t
+{
+    keywordIdxes_t keyword  = KEY_OPEN_BRACKET;
+    node_t *node            = NULL;
+    size_t firstStatement   = 0;
+};
+
+// binary operator with its left operand, '(' or builtin function with its first argument,
+// if there are two of them
+struct expressionFrame_t
+{
+    keywordIdxes_t keyword  = KEY_OPEN_PARENS;
+    node_t *node            = NULL;
+};
+
+typedef dynamicArray_t <node_t *> statements_t;
+
 static int GetGramma            (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
+static int GetTopLevelFunctions (program_t *program, tokensArray_t *tokens, 
+                                 size_t *curToken, statements_t *functions);
+static int GetTopLevelFunction  (program_t *program, tokensArray_t *tokens, 
+                                 size_t *curToken, node_t **node, bool isFirst);
 static int GetMain              (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
 static int GetFunction          (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
-static int GetFunctionCommon      (program_t *program, tokensArray_t *tokens,
+static int GetFunctionCommon    (program_t *program, tokensArray_t *tokens,
                                  size_t *curToken, node_t **node);
+static int GetFunctionBody      (program_t *program, tokensArray_t *tokens,
+                                 size_t *curToken, statements_t *statements);
 static int GetFunctionCall      (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
 static int AddFunctionName      (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
 static int GetOperation         (program_t *program, tokensArray_t *tokens, 
+                                 size_t *curToken, node_t **node, statements_t *statements);
+static int GetNestedOperations  (program_t *program, tokensArray_t *tokens, size_t *curToken, 
+                                 node_t **node, statements_t *statements,
+                                 dynamicArray_t <operationFrame_t> *stack);
+static int PushStatement        (statements_t *statements, node_t *statement);
+static int PopBlock             (program_t *program, statements_t *statements, 
+                                 size_t firstStatement, node_t **node);
+static int GetSimpleOperation   (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
-static int GetIf                (program_t *program, tokensArray_t *tokens, 
+static int GetIfCondition       (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
 // static int GetAssign            (program_t *program, tokensArray_t *tokens, 
 //                                  size_t *curToken, node_t **node);
@@ -138,10 +189,9 @@ static int GetReturn            (program_t *program, tokensArray_t *tokens,
                                  size_t *curToken, node_t **node);
 static int GetExpression        (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
-static int GetTerm              (program_t *program, tokensArray_t *tokens, 
-                                 size_t *curToken, node_t **node);
-static int GetPower             (program_t *program, tokensArray_t *tokens, 
-                                 size_t *curToken, node_t **node);
+static int GetNestedExpression  (program_t *program, tokensArray_t *tokens, size_t *curToken, 
+                                 node_t **node, dynamicArray_t <expressionFrame_t> *stack);
+static int OperatorPrecedence   (tokensArray_t *tokens, size_t tokenIdx);
 static int GetPrimaryExpression (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
 static int GetVariable          (program_t *program, tokensArray_t *tokens, 
@@ -151,11 +201,17 @@ static int SetVariable          (program_t *program, tokensArray_t *tokens,
                                  size_t *curToken, node_t **node, 
                                  bool reportErrors);
 static int GetBuiltinFunction   (program_t *program, tokensArray_t *tokens, 
-                                 size_t *curToken, node_t **node);
+                                 size_t *curToken, const keyword_t **func);
 // static int GetVariableName      (char **curPos);
 static int GetNumber            (program_t *program, tokensArray_t *tokens, 
                                  size_t *curToken, node_t **node);
 
+static int    AddFunctionSpan       (program_t *program, size_t firstToken, size_t endToken, 
+                                     node_t *function);
+static size_t FunctionSpanFind      (program_t *program, size_t tokenIdx);
+static size_t FunctionNameIdx       (node_t *function);
+static int    TreeLoadInfixAgain    (program_t *program);
+
 int TreeLoadInfixFromTokens (program_t *program)
 {
     assert (program);
@@ -169,9 +225,15 @@ int TreeLoadInfixFromTokens (program_t *program)
         return TREE_ERROR_LOAD_INTO_NOT_EMPTY;
     }
 
+    program->functionSpans.size = 0;
+
     size_t curToken = 0;
     int status = GetGramma (program, &program->tokens, &curToken, &program->ast.root);
 
+    tokensArray_t *tokens = &program->tokens;
+
+    RETURN_IF_STREAM_FAILED;
+
     if (status != TREE_OK)
     {
         ERROR_LOG ("%s", "Error in GetGramma()");
@@ -186,6 +248,158 @@ int TreeLoadInfixFromTokens (program_t *program)
     return TREE_OK;
 }
 
+// Only the top-level function, that has all edited tokens, is parsed again, as if the
+// program were parsed up to it: functions before it are declared, the ones after aren't.
+// If function's name or end changes, names of other functions can be (un)declared,
+// so the whole program is parsed again. After syntax error ast is cleared, and the
+// next edit parses the whole program too
+int TreeLoadInfixAfterEdit (program_t *program, const tokensEdit_t *tokensEdit)
+{
+    assert (program);
+    assert (tokensEdit);
+    assert (program->tokens.stream == NULL);
+
+    dynamicArray_t <functionSpan_t> *spans = &program->functionSpans;
+
+    // tokens were lexed again after lexical error, spans are of older ones
+    if (program->ast.root == NULL || spans->size == 0 ||
+        spans->data[spans->size - 1].endToken - tokensEdit->oldEnd + tokensEdit->newEnd != 
+        program->tokens.size)
+        return TreeLoadInfixAgain (program);
+
+    // only offsets of tokens are changed
+    if (tokensEdit->first == tokensEdit->oldEnd && tokensEdit->first == tokensEdit->newEnd)
+        return TREE_OK;
+
+    size_t spanIdx = FunctionSpanFind (program, tokensEdit->first);
+    if (spanIdx == spans->size || tokensEdit->oldEnd > spans->data[spanIdx].endToken)
+        return TreeLoadInfixAgain (program);
+
+    functionSpan_t *span = &spans->data[spanIdx];
+
+    DEBUG_LOG ("Function %lu [%lu, %lu) is parsed again", spanIdx, span->firstToken, span->endToken);
+
+    // the same as it was, when function was parsed
+    TREE_DO_AND_RETURN (SymbolTableTruncate (&program->functions, spanIdx));
+
+    tokensArray_t *tokens = &program->tokens;
+
+    size_t curToken  = span->firstToken;
+    node_t *function = NULL;
+
+    int status = GetTopLevelFunction (program, tokens, &curToken, &function, spanIdx == 0);
+    if (status != TREE_OK)
+    {
+        TreeDtor (&program->ast);
+
+        return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
+    }
+
+    size_t endToken = span->endToken - tokensEdit->oldEnd + tokensEdit->newEnd;
+
+    if (curToken != endToken || FunctionNameIdx (function) != span->nameIdx)
+    {
+        TreeDelete (&program->ast, &function);
+
+        return TreeLoadInfixAgain (program);
+    }
+
+    TreeDelete (&program->ast, span->node);
+
+    *span->node    = function;
+    span->endToken = endToken;
+
+    for (size_t i = spanIdx + 1; i < spans->size; i++)
+    {
+        functionSpan_t *next = &spans->data[i];
+
+        next->firstToken = next->firstToken - tokensEdit->oldEnd + tokensEdit->newEnd;
+        next->endToken   = next->endToken   - tokensEdit->oldEnd + tokensEdit->newEnd;
+
+        TREE_DO_AND_RETURN (SymbolTableDeclare (&program->functions, next->nameIdx));
+    }
+
+    TREE_DUMP (program, &program->ast, "%s", "After edit");
+
+    return TREE_OK;
+}
+
+int TreeLoadInfixAgain (program_t *program)
+{
+    assert (program);
+
+    // nodes lost by failed parse are released too
+    TreeDtor (&program->ast);
+
+    SymbolTableDtor (&program->variables);
+    SymbolTableDtor (&program->functions);
+
+    TREE_DO_AND_RETURN (SymbolTableCtor (&program->variables));
+    TREE_DO_AND_RETURN (SymbolTableCtor (&program->functions));
+
+    return TreeLoadInfixFromTokens (program);
+}
+
+// node of span is set, when block with all functions is made
+int AddFunctionSpan (program_t *program, size_t firstToken, size_t endToken, node_t *function)
+{
+    assert (program);
+    assert (function);
+
+    int status = DynamicArrayPush (&program->functionSpans, 
+                                   functionSpan_t {.firstToken = firstToken,
+                                                   .endToken   = endToken,
+                                                   .node       = NULL,
+                                                   .nameIdx    = FunctionNameIdx (function)});
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    return TREE_OK;
+}
+
+// index of the function with token tokenIdx, functionSpans.size if there is no such
+size_t FunctionSpanFind (program_t *program, size_t tokenIdx)
+{
+    assert (program);
+
+    const functionSpan_t *spans = program->functionSpans.data;
+
+    size_t left  = 0;
+    size_t right = program->functionSpans.size;
+
+    while (left < right)
+    {
+        size_t middle = left + (right - left) / 2;
+
+        if (spans[middle].endToken <= tokenIdx)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+
+    if (left < program->functionSpans.size && spans[left].firstToken <= tokenIdx)
+        return left;
+
+    return program->functionSpans.size;
+}
+
+// function name is on the left of MAIN and on the left of COMMA on the left of FUNC
+size_t FunctionNameIdx (node_t *function)
+{
+    assert (function);
+    assert (function->left);
+
+    node_t *name = function->left;
+
+    if (function->value.idx == KEY_FUNC)
+        name = name->left;
+
+    assert (name);
+
+    return name->value.idx;
+}
+
 #include "dsl_define.h"
 
 int GetGramma (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
@@ -194,55 +408,88 @@ int GetGramma (program_t *program, tokensArray_t *tokens, size_t *curToken, node
     assert (tokens);
     assert (node);
 
-    int status = GetFunction (program, tokens, curToken, node);
+    statements_t functions = {};
+
+    int status = GetTopLevelFunctions (program, tokens, curToken, &functions);
+
+    if (status == TREE_OK)
+        status = PopBlock (program, &functions, 0, node);
+
+    DynamicArrayDtor (&functions);
+
     if (status != TREE_OK)
-        SYNTAX_ERROR_MESSAGE ("%s", "Бро, почему у тебя пустая программа? Где рэпчик?");
+        return status;
+
+    NODE_DUMP (program, *node, "Created new node (block of functions). curToken = %lu", *curToken);
 
-    *node = CONNECT_ (*node, NULL);
-    NODE_DUMP (program, *node, "Created new node (connection). curToken = %lu", *curToken);
+    for (size_t i = 0; i < program->functionSpans.size; i++)
+        program->functionSpans.data[i].node = NodeChild (*node, i);
+
+    return TREE_OK;
+}
+
+int GetTopLevelFunctions (program_t *program, tokensArray_t *tokens, size_t *curToken, 
+                          statements_t *functions)
+{
+    assert (program);
+    assert (tokens);
+    assert (functions);
 
-    while (*curToken < tokens->size)
+    do
     {
-        node_t *nodeNext = NULL;
+        node_t *function = NULL;
 
-        status = GetMain (program, tokens, curToken, &nodeNext);
-        
-        if (status != TREE_OK)
-            status = GetFunction (program, tokens, curToken, &nodeNext);
+        size_t firstToken = *curToken;
+
+        int status = GetTopLevelFunction (program, tokens, curToken, &function, functions->size == 0);
+        if (status != TREE_OK && functions->size == 0)
+            SYNTAX_ERROR_MESSAGE ("%s", "Бро, почему у тебя пустая программа? Где рэпчик?");
 
         if (status != TREE_OK)
             SYNTAX_ERROR_MESSAGE ("%s", "Ресторатор недоволен");
 
-        // (*node)->right = CONNECT_ (nodeNext, NULL);
-        // *node = (*node)->right;
-        
-        *node = CONNECT_ (*node, nodeNext);
-        NODE_DUMP (program, (*node), "Created new node (connection). curToken = %lu", *curToken);
-        // NODE_DUMP (program, (*node), "%s", "main node");
+        NODE_DUMP (program, function, "Created new function. curToken = %lu", *curToken);
 
-        DEBUG_PTR ((*node)->right);
-        DEBUG_PTR (*node);
+        TREE_DO_AND_RETURN (PushStatement (functions, function));
+        TREE_DO_AND_RETURN (AddFunctionSpan (program, firstToken, *curToken, function));
     }
-
-    if (*curToken != tokens->size)
-        SYNTAX_ERROR_MESSAGE ("%s", "Что-то не сходится у меня...");
+    while (TokensHave (tokens, *curToken));
 
     return TREE_OK;
 }
 
-#define IS_NEXT_TOKEN_KEYWORD(keyword)                       \
-        (*curToken + 1 <= tokens->size &&                    \
-         tokens->data[*curToken + 1].type == TYPE_KEYWORD && \
-         tokens->data[*curToken + 1].value.idx == keyword)
+// program begins with a function, main can be only after it
+int GetTopLevelFunction (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node, 
+                         bool isFirst)
+{
+    assert (program);
+    assert (tokens);
+    assert (curToken);
+    assert (node);
+
+    if (isFirst)
+        return GetFunction (program, tokens, curToken, node);
+
+    int status = GetMain (program, tokens, curToken, node);
+    if (status != TREE_OK)
+        status = GetFunction (program, tokens, curToken, node);
+
+    return status;
+}
+
+#define IS_NEXT_TOKEN_KEYWORD(keyword)                                  \
+        (TokensHave (tokens, *curToken + 1) &&                          \
+         TokenType  (tokens, *curToken + 1) == TYPE_KEYWORD &&          \
+         TokenValue (tokens, *curToken + 1).idx == keyword)
 
-#define IS_TOKEN_KEYWORD(keyword)                        \
-        (*curToken <= tokens->size &&                    \
-         tokens->data[*curToken].type == TYPE_KEYWORD && \
-         tokens->data[*curToken].value.idx == keyword)
+#define IS_TOKEN_KEYWORD(keyword)                                       \
+        (TokensHave (tokens, *curToken) &&                              \
+         TokenType  (tokens, *curToken) == TYPE_KEYWORD &&              \
+         TokenValue (tokens, *curToken).idx == keyword)
 
-#define IS_TOKEN_TYPE(tokenType)                    \
-        (*curToken <= tokens->size &&               \
-         tokens->data[*curToken].type == tokenType)
+#define IS_TOKEN_TYPE(tokenType)                                        \
+        (TokensHave (tokens, *curToken) &&                              \
+         TokenType  (tokens, *curToken) == tokenType)
 
 
 int GetMain (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
@@ -312,38 +559,61 @@ int GetFunctionCommon (program_t *program, tokensArray_t *tokens, size_t *curTok
         SYNTAX_ERROR_MESSAGE ("%s", "А что зал такой тухлый? Где \"шум\" aka '{'?");
 
     (*curToken)++;
-    
-    while (!IS_TOKEN_KEYWORD (KEY_RETURN))
-    {
-        node_t *nodeNext = NULL;
 
-        int status = GetOperation (program, tokens, curToken, &nodeNext);
-        if (status != TREE_OK)
-            SYNTAX_ERROR_MESSAGE ("%s", "Бро, что-то слабый раунд, разберись с телом функции");
+    TREE_DO_AND_RETURN (SymbolTablePushScope (&program->variables));
 
-        (*node)->right = CONNECT_ ((*node)->right, nodeNext);
-        NODE_DUMP (program, (*node), "Created new node (connection). curToken = %lu", *curToken);
-    }
+    statements_t statements = {};
 
-    DumpTokens (program);
+    int status = GetFunctionBody (program, tokens, curToken, &statements);
 
-    if (!IS_TOKEN_KEYWORD (KEY_RETURN))
-        SYNTAX_ERROR_MESSAGE ("%s", "А кто раунд завершать будет (где return)?");
+    if (status == TREE_OK)
+        status = PopBlock (program, &statements, 0, &(*node)->right);
 
-    (*node)->right = CONNECT_ ((*node)->right, NULL);
-    NODE_DUMP (program, (*node), "Created new node(connection) before adding return. curToken = %lu", *curToken);
+    DynamicArrayDtor (&statements);
 
-    node_t *body = (*node)->right; 
-    TREE_DO_AND_RETURN (GetReturn (program, tokens, curToken, &(body->right)));
+    if (status != TREE_OK)
+        return status;
+
+    NODE_DUMP (program, (*node), "Created new node (body). curToken = %lu", *curToken);
 
     if (!IS_TOKEN_KEYWORD (KEY_CLOSE_BRACKET))
         SYNTAX_ERROR_MESSAGE ("%s", "А что зал такой тухлый? Где \"воу\" aka '}' ?");
 
     (*curToken)++;
 
+    TREE_DO_AND_RETURN (SymbolTablePopScope (&program->variables));
+
     return TREE_OK;
 }
 
+// operations of function and its return go to statements
+int GetFunctionBody (program_t *program, tokensArray_t *tokens, size_t *curToken, 
+                     statements_t *statements)
+{
+    assert (program);
+    assert (tokens);
+    assert (curToken);
+    assert (statements);
+
+    while (!IS_TOKEN_KEYWORD (KEY_RETURN))
+    {
+        node_t *operation = NULL;
+
+        int status = GetOperation (program, tokens, curToken, &operation, statements);
+        if (status != TREE_OK)
+            SYNTAX_ERROR_MESSAGE ("%s", "Бро, что-то слабый раунд, разберись с телом функции");
+
+        TREE_DO_AND_RETURN (PushStatement (statements, operation));
+    }
+
+    DumpTokens (program);
+
+    node_t *returnNode = NULL;
+    TREE_DO_AND_RETURN (GetReturn (program, tokens, curToken, &returnNode));
+
+    return PushStatement (statements, returnNode);
+}
+
 int GetFunctionCall (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
 {
     assert (program);
@@ -359,13 +629,16 @@ int GetFunctionCall (program_t *program, tokensArray_t *tokens, size_t *curToken
     if (!IS_TOKEN_TYPE (TYPE_NAME))
         SYNTAX_ERROR;
 
-    const name_t *funcName = NamesTableFindByIdx (&program->namesTable, tokens->data[*curToken].value.idx);
+    const name_t *funcName = NamesTableFindByIdx (&program->namesTable, TokenValue (tokens, *curToken).idx);
     if (funcName == NULL)
-        SYNTAX_ERROR_MESSAGE ("%s", "Чувак, ты пытаешься зачитать ещё ненаписанный раунд...");
-    // FIXME: добавить в NamesTable параметры func или var
-    // Ошибка в том, что можно вызвать перменную
-    // А ещё можно вызвать функцию ниже, в отличии от решения с поиском по стеку
-    // короче думайте
+    {
+        ERROR_LOG ("%s", "Uknown function name, error somewhere in tokenizator");
+        SYNTAX_ERROR;
+    }
+
+    if (!SymbolTableIsDeclared (&program->functions, funcName->idx))
+        SYNTAX_ERROR_MESSAGE ("Чувак, ты пытаешься зачитать ещё ненаписанный раунд \"%.*s\"...",
+                              (int) funcName->len, funcName->name);
 
     *node = CALL_ (NAME_ (funcName->idx), NULL);
 
@@ -388,46 +661,156 @@ int GetFunctionCall (program_t *program, tokensArray_t *tokens, size_t *curToken
     return TREE_OK;
 }
 
-int GetOperation (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
+// Blocks and ifs, that are opened, are kept on explicit stack: a long chain of nested
+// "пошумим" or "биф" is limited only by program->ast.depthBudget. Operations of opened
+// blocks are pushed to statements above the ones of enclosing function, and are taken
+// from there, when block is closed
+int GetOperation (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node,
+                  statements_t *statements)
 {
     assert (program);
     assert (tokens);
     assert (curToken);
     assert (node);
+    assert (statements);
 
-    if (IS_TOKEN_KEYWORD (KEY_IF))
-    {
-        DEBUG_STR ("IF!!!!!!!!!");
+    dynamicArray_t <operationFrame_t> stack = {};
 
-        int status = GetIf (program, tokens, curToken, node);
-        if (status != TREE_OK)
-            SYNTAX_ERROR;
+    size_t oldSize = statements->size;
 
-        return TREE_OK;
-    }
+    int status = GetNestedOperations (program, tokens, curToken, node, statements, &stack);
+
+    // after error statements of blocks, that are not closed, are lost as the rest of ast
+    statements->size = oldSize;
+
+    DynamicArrayDtor (&stack);
 
-    if (IS_TOKEN_KEYWORD (KEY_OPEN_BRACKET))
+    return status;
+}
+
+int GetNestedOperations (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node,
+                         statements_t *statements, dynamicArray_t <operationFrame_t> *stack)
+{
+    assert (program);
+    assert (tokens);
+    assert (curToken);
+    assert (node);
+    assert (statements);
+    assert (stack);
+
+    while (true)
     {
-        (*curToken)++;
+        if (IS_TOKEN_KEYWORD (KEY_IF))
+        {
+            node_t *condition = NULL;
+
+            int status = GetIfCondition (program, tokens, curToken, &condition);
+            if (status != TREE_OK)
+                SYNTAX_ERROR;
+
+            TREE_DO_AND_RETURN (TreeStackPush (&program->ast, stack, {.keyword = KEY_IF, 
+                                                                      .node    = condition}));
+            continue;
+        }
 
-        int status = GetOperation (program, tokens, curToken, node);
+        if (IS_TOKEN_KEYWORD (KEY_OPEN_BRACKET))
+        {
+            (*curToken)++;
+
+            TREE_DO_AND_RETURN (SymbolTablePushScope (&program->variables));
+            TREE_DO_AND_RETURN (TreeStackPush (&program->ast, stack, {.keyword        = KEY_OPEN_BRACKET, 
+                                                                      .node           = NULL,
+                                                                      .firstStatement = statements->size}));
+            continue;
+        }
+
+        node_t *operation = NULL;
+
+        int status = GetSimpleOperation (program, tokens, curToken, &operation);
         if (status != TREE_OK)
             SYNTAX_ERROR;
 
-        while (!IS_TOKEN_KEYWORD (KEY_CLOSE_BRACKET))
+        // ifs and blocks, that end with this operation, are closed
+        while (stack->size > 0)
         {
-            node_t *nodeArg = NULL;
-            status = GetOperation (program, tokens, curToken, &nodeArg);
-            if (status != TREE_OK)
-                SYNTAX_ERROR;
+            operationFrame_t *frame = &stack->data[stack->size - 1];
+
+            if (frame->keyword == KEY_IF)
+            {
+                operation = IF_ (frame->node, operation);
+
+                NODE_DUMP (program, operation, "Created new node (if). curToken = %lu", *curToken);
+
+                stack->size--;
+
+                continue;
+            }
 
-            *node = CONNECT_ (*node, nodeArg);
+            TREE_DO_AND_RETURN (PushStatement (statements, operation));
+
+            if (!IS_TOKEN_KEYWORD (KEY_CLOSE_BRACKET))
+                break;
+
+            (*curToken)++;
+
+            TREE_DO_AND_RETURN (SymbolTablePopScope (&program->variables));
+
+            // block of one operation is the operation itself
+            if (statements->size - frame->firstStatement == 1)
+                operation = statements->data[--statements->size];
+            else
+                TREE_DO_AND_RETURN (PopBlock (program, statements, frame->firstStatement, &operation));
+
+            NODE_DUMP (program, operation, "Created new node (block). curToken = %lu", *curToken);
+
+            stack->size--;
         }
 
-        (*curToken)++;
+        if (stack->size == 0)
+        {
+            *node = operation;
 
-        return TREE_OK;
+            return TREE_OK;
+        }
     }
+}
+
+int PushStatement (statements_t *statements, node_t *statement)
+{
+    assert (statements);
+    assert (statement);
+
+    int status = DynamicArrayPush (statements, statement);
+    if (status != COMMON_ERROR_OK)
+        return TREE_ERROR_COMMON |
+               status;
+
+    return TREE_OK;
+}
+
+// statements from firstStatement to the top are moved to new block node
+int PopBlock (program_t *program, statements_t *statements, size_t firstStatement, node_t **node)
+{
+    assert (program);
+    assert (statements);
+    assert (node);
+    assert (firstStatement <= statements->size);
+
+    *node = BLOCK_ (statements->data + firstStatement, statements->size - firstStatement);
+    if (*node == NULL)
+        return TREE_ERROR_CREATING_NODE;
+
+    statements->size = firstStatement;
+
+    return TREE_OK;
+}
+
+int GetSimpleOperation (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
+{
+    assert (program);
+    assert (tokens);
+    assert (curToken);
+    assert (node);
 
     int status = GetDeclarateOrAssign (program, tokens, curToken, node);
     if (status == TREE_OK)
@@ -455,7 +838,8 @@ int GetOperation (program_t *program, tokensArray_t *tokens, size_t *curToken, n
     return TREE_OK;
 }
 
-int GetIf (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
+// "биф" '(' Expression ')', operation after it is parsed by GetNestedOperations ()
+int GetIfCondition (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
 {
     assert (program);
     assert (tokens);
@@ -472,8 +856,7 @@ int GetIf (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t *
     
     (*curToken)++;
 
-    node_t *nodeL = NULL;
-    int status = GetExpression (program, tokens, curToken, &nodeL);
+    int status = GetExpression (program, tokens, curToken, node);
     if (status != TREE_OK)
         SYNTAX_ERROR;
 
@@ -481,20 +864,10 @@ int GetIf (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t *
         SYNTAX_ERROR;
 
     (*curToken)++;
-    
-    node_t *nodeR = NULL;
-    status = GetOperation (program, tokens, curToken, &nodeR);
-    if (status != TREE_OK)
-        SYNTAX_ERROR;
-
-    *node = IF_ (nodeL, nodeR);
-
-    NODE_DUMP (program, *node, "Created new node (if). curToken = %lu", *curToken);
 
     return TREE_OK;
 }
 
-
 // int GetAssign (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
 // {
 //     assert (program);
@@ -558,7 +931,7 @@ int GetDeclarateOrAssign (program_t *program, tokensArray_t *tokens, size_t *cur
         return TREE_ERROR_INVALID_TOKEN;
     }
 
-    size_t idx = tokens->data[*curToken].value.idx;
+    size_t idx = TokenValue (tokens, *curToken).idx;
     
     (*curToken)++;
 
@@ -620,8 +993,6 @@ int GetPrint (program_t *program, tokensArray_t *tokens, size_t *curToken, node_
 
     (*curToken)++;
 
-    *node = CONNECT_ (*node, NULL);
-
     return TREE_OK;
 }
 
@@ -644,11 +1015,13 @@ int GetReturn (program_t *program, tokensArray_t *tokens, size_t *curToken, node
     if (status != TREE_OK)
         SYNTAX_ERROR_MESSAGE ("%s", "Ошибка в выражении у return'a");
 
-    (*node) = (CONNECT_ (*node, NULL));
-
     return TREE_OK;
 }
 
+// Expression is parsed without recursion: operators, that wait for their right operand,
+// '(' and builtin functions, that wait for their ')', are kept on explicit stack. Long
+// chains of right associative operators and deep parentheses are limited only by
+// program->ast.depthBudget. Precedence and associativity are taken from kKeywords[]
 int GetExpression (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
 {
     assert (program);
@@ -656,105 +1029,135 @@ int GetExpression (program_t *program, tokensArray_t *tokens, size_t *curToken,
     assert (curToken);
     assert (node);
 
-    int status = GetTerm (program, tokens, curToken, node);
-    if (status != TREE_OK)
-        SYNTAX_ERROR;
-
-    while (IS_TOKEN_KEYWORD(KEY_ADD) ||
-           IS_TOKEN_KEYWORD(KEY_SUB))
-    {
-        size_t operation = tokens->data[*curToken].value.idx;
+    dynamicArray_t <expressionFrame_t> stack = {};
 
-        (*curToken)++;
-        
-        node_t *node2 = NULL;
-        status = GetTerm (program, tokens, curToken, &node2);
-        if (status != TREE_OK)
-            SYNTAX_ERROR;
+    int status = GetNestedExpression (program, tokens, curToken, node, &stack);
 
-        switch (operation)
-        {
-            case KEY_ADD: *node = ADD_ (*node, node2); break;
-            case KEY_SUB: *node = SUB_ (*node, node2); break;
+    DynamicArrayDtor (&stack);
 
-            default: SYNTAX_ERROR;
-        }
-    }
+    if (status != TREE_OK)
+        return status;
 
     NODE_DUMP (program, *node, "Created new node (ast). curToken = %lu", *curToken);
 
-    // (*curToken)++; // FIXME: I just removed this at 23:15 15 dec
-
     return TREE_OK;
 }
 
-int GetTerm (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
+int GetNestedExpression (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node,
+                         dynamicArray_t <expressionFrame_t> *stack)
 {
     assert (program);
     assert (tokens);
     assert (curToken);
     assert (node);
+    assert (stack);
 
-    int status = GetPower (program, tokens, curToken, node);
-    if (status != TREE_OK)
-        SYNTAX_ERROR;
-
-    while (IS_TOKEN_KEYWORD(KEY_MUL) ||
-           IS_TOKEN_KEYWORD(KEY_DIV))
+    while (true)
     {
-        size_t operation = tokens->data[*curToken].value.idx;
-        
-        (*curToken)++;
-        
-        node_t *node2 = NULL;
-        status = GetPower (program, tokens, curToken, &node2);
-        if (status != TREE_OK)
+        if (IS_TOKEN_KEYWORD (KEY_OPEN_PARENS))
+        {
+            (*curToken)++;
+
+            TREE_DO_AND_RETURN (TreeStackPush (&program->ast, stack, {.keyword = KEY_OPEN_PARENS}));
+            continue;
+        }
+
+        const keyword_t *func = NULL;
+
+        int status = GetBuiltinFunction (program, tokens, curToken, &func);
+        if (status == TREE_OK && func->numberOfArgs > 0)
+        {
+            TREE_DO_AND_RETURN (TreeStackPush (&program->ast, stack, {.keyword = func->idx}));
+            continue;
+        }
+
+        node_t *operand = NULL;
+
+        if (status == TREE_OK)
+            operand = NodeCtorAndFill (&program->ast, TYPE_KEYWORD, {.idx = (size_t) func->idx}, NULL, NULL);
+        else if (GetPrimaryExpression (program, tokens, curToken, &operand) != TREE_OK)
             SYNTAX_ERROR;
 
-        switch (operation)
+        // operand is right one of operators, that bind tighter than the next one, and
+        // is argument of '(' or function, that is closed after it
+        while (true)
         {
-            case KEY_MUL: *node = MUL_ (*node, node2); break;
-            case KEY_DIV: *node = DIV_ (*node, node2); break;
+            int precedence = OperatorPrecedence (tokens, *curToken);
 
-            default: SYNTAX_ERROR;
-        }
-    }
+            while (stack->size > 0)
+            {
+                expressionFrame_t *frame = &stack->data[stack->size - 1];
 
-    DEBUG_LOG ("node [%p]",  (*node));
-    DEBUG_LOG ("\tnode->left [%p]",  (*node)->left);
-    DEBUG_LOG ("\tnode->right [%p]", (*node)->right);
+                int framePrecedence = kKeywords[frame->keyword].precedence;
 
-    NODE_DUMP (program, *node, "Created new node (term). curToken = %lu", *curToken);
+                if (framePrecedence < precedence || framePrecedence == 0 ||
+                    (framePrecedence == precedence && kKeywords[frame->keyword].isRightAssoc))
+                    break;
 
-    return TREE_OK;
-}
+                operand = NodeCtorAndFill (&program->ast, TYPE_KEYWORD, {.idx = (size_t) frame->keyword}, 
+                                           frame->node, operand);
 
-int GetPower (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
-{
-    assert (program);
-    assert (tokens);
-    assert (curToken);
-    assert (node);
+                stack->size--;
+            }
 
-    int status = GetPrimaryExpression (program, tokens, curToken, node);
-    if (status != TREE_OK)
-        SYNTAX_ERROR;
+            if (precedence >= kMinPrecedence)
+            {
+                keywordIdxes_t operation = (keywordIdxes_t) TokenValue (tokens, *curToken).idx;
 
-    while (IS_TOKEN_KEYWORD (KEY_POW))
-    {
-        (*curToken)++;
-        
-        node_t *node2 = NULL;
-        status = GetPrimaryExpression (program, tokens, curToken, &node2);
-        if (status != TREE_OK)
-            SYNTAX_ERROR;
+                (*curToken)++;
+
+                TREE_DO_AND_RETURN (TreeStackPush (&program->ast, stack, {.keyword = operation,
+                                                                          .node    = operand}));
+                break;
+            }
+
+            if (stack->size == 0)
+            {
+                *node = operand;
+
+                return TREE_OK;
+            }
+
+            expressionFrame_t *frame = &stack->data[stack->size - 1];
+
+            // first of two arguments of function
+            if (frame->keyword != KEY_OPEN_PARENS && frame->node == NULL &&
+                kKeywords[frame->keyword].numberOfArgs == 2)
+            {
+                if (!IS_TOKEN_KEYWORD (KEY_COMMA))
+                    SYNTAX_ERROR;
+
+                (*curToken)++;
+
+                frame->node = operand;
+                break;
+            }
+
+            if (!IS_TOKEN_KEYWORD (KEY_CLOSE_PARENS))
+                SYNTAX_ERROR;
 
-        *node = POW_ (*node, node2);
+            (*curToken)++;
+
+            if (frame->keyword != KEY_OPEN_PARENS)
+                operand = NodeCtorAndFill (&program->ast, TYPE_KEYWORD, {.idx = (size_t) frame->keyword}, 
+                                           frame->node, operand);
+
+            stack->size--;
+        }
     }
+}
 
-    return TREE_OK;
+int OperatorPrecedence (tokensArray_t *tokens, size_t tokenIdx)
+{
+    assert (tokens);
+
+    if (!TokensHave (tokens, tokenIdx) || TokenType (tokens, tokenIdx) != TYPE_KEYWORD)
+        return 0;
+
+    return kKeywords[TokenValue (tokens, tokenIdx).idx].precedence;
 }
 
+// operand without operators and parentheses: number, function call or variable
 int GetPrimaryExpression (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
 {
     assert (program);
@@ -762,30 +1165,10 @@ int GetPrimaryExpression (program_t *program, tokensArray_t *tokens, size_t *cur
     assert (curToken);
     assert (node);
 
-    if (IS_TOKEN_KEYWORD (KEY_OPEN_PARENS))
-    {
-        (*curToken)++;
-        
-        int status = GetExpression (program, tokens, curToken, node);
-        if (status != TREE_OK)
-            SYNTAX_ERROR;
-
-        if (!IS_TOKEN_KEYWORD (KEY_CLOSE_PARENS))
-            SYNTAX_ERROR;
-
-        (*curToken)++;
-
-        return status;
-    }
-
     int status = GetNumber (program, tokens, curToken, node);
     if (status == TREE_OK)
         return status;
 
-    status = GetBuiltinFunction (program, tokens, curToken, node);
-    if (status == TREE_OK)
-        return status;
-
     status = GetFunctionCall (program, tokens, curToken, node);
     if (status == TREE_OK)
         return status;
@@ -804,10 +1187,10 @@ int GetNumber (program_t *program, tokensArray_t *tokens, size_t *curToken, node
     assert (curToken);
     assert (node);
 
-    if (tokens->data[*curToken].type != TYPE_CONST_NUM)
+    if (!IS_TOKEN_TYPE (TYPE_CONST_NUM))
         return TREE_ERROR_INVALID_TOKEN;
 
-    valueNumber_t val = tokens->data[*curToken].value.number;
+    valueNumber_t val = TokenValue (tokens, *curToken).number;
     DEBUG_VAR (VALUE_NUMBER_FSTRING, val);
 
     *node = NUM_ (val);
@@ -819,27 +1202,29 @@ int GetNumber (program_t *program, tokensArray_t *tokens, size_t *curToken, node
     return TREE_OK;
 }
 
-
-int GetBuiltinFunction (program_t *program, tokensArray_t *tokens, size_t *curToken, node_t **node)
+// name of builtin function and its '(', function without arguments is taken with its ')'.
+// Arguments are parsed by GetNestedExpression ()
+int GetBuiltinFunction (program_t *program, tokensArray_t *tokens, size_t *curToken, 
+                        const keyword_t **func)
 {
     assert (program);
     assert (tokens);
     assert (curToken);
-    assert (node);
+    assert (func);
 
-    if (tokens->data[*curToken].type != TYPE_KEYWORD)
+    if (!IS_TOKEN_TYPE (TYPE_KEYWORD))
         return TREE_ERROR_INVALID_TOKEN;
 
-    const keyword_t *func = FindBuiltinFunctionByIdx ((keywordIdxes_t) tokens->data[*curToken].value.idx);
+    *func = FindBuiltinFunctionByIdx ((keywordIdxes_t) TokenValue (tokens, *curToken).idx);
 
-    if (func == NULL)
+    if (*func == NULL)
     {
-        DEBUG_LOG ("No builtin function found by idx %lu. Return", tokens->data[*curToken].value.idx);
+        DEBUG_LOG ("No builtin function found by idx %lu. Return", TokenValue (tokens, *curToken).idx);
 
         return TREE_ERROR_INVALID_TOKEN;
     }
     
-    if (func->numberOfArgs > 2)
+    if ((*func)->numberOfArgs > 2)
     {
         ERROR_LOG ("%s", "Where are builitn functions with only 0, 1 or 2 args now...\n"
                          "Maybe you forgot to rewrite this part of code?");
@@ -847,8 +1232,6 @@ int GetBuiltinFunction (program_t *program, tokensArray_t *tokens, size_t *curTo
         return TREE_ERROR_INVALID_TOKEN;
     }
 
-    *node = NodeCtorAndFill (&program->ast, TYPE_KEYWORD, {.idx = (size_t) func->idx}, NULL, NULL);
-
     (*curToken)++;
 
     if (!IS_TOKEN_KEYWORD (KEY_OPEN_PARENS))
@@ -856,50 +1239,14 @@ int GetBuiltinFunction (program_t *program, tokensArray_t *tokens, size_t *curTo
     
     (*curToken)++;
 
-    if (func->numberOfArgs == 0)
+    if ((*func)->numberOfArgs == 0)
     {
         if (!IS_TOKEN_KEYWORD (KEY_CLOSE_PARENS))
             SYNTAX_ERROR;
 
         (*curToken)++;
-
-        return TREE_OK;
     }
 
-    node_t *firstArg = {};
-    int status = GetExpression (program, tokens, curToken, &firstArg);
-    if (status != TREE_OK)
-        SYNTAX_ERROR;
-
-    if (func->numberOfArgs == 1)
-    {
-        if (!IS_TOKEN_KEYWORD (KEY_CLOSE_PARENS))
-            SYNTAX_ERROR;
-        
-        (*curToken)++;
-        (*node)->right = firstArg;
-
-        return TREE_OK;
-    }
-    
-    if (!IS_TOKEN_KEYWORD (KEY_COMMA))
-        SYNTAX_ERROR;
-    
-    (*curToken)++;
-
-    node_t *secondArg = {};
-    status = GetExpression (program, tokens, curToken, &secondArg);
-    if (status != TREE_OK)
-        SYNTAX_ERROR;
-
-    if (!IS_TOKEN_KEYWORD (KEY_CLOSE_PARENS))
-        SYNTAX_ERROR;
-
-    (*curToken)++;
-
-    (*node)->left  = firstArg;
-    (*node)->right = secondArg;
-
     return TREE_OK;
 }
 
@@ -922,18 +1269,18 @@ int GetVariable (program_t *program, tokensArray_t *tokens, size_t *curToken, no
         return TREE_ERROR_INVALID_TOKEN;
     }
 
-    const token_t *token = &tokens->data[*curToken];
+    value_t value = TokenValue (tokens, *curToken);
 
-    const name_t *var = NamesTableFindByIdx (&program->namesTable, token->value.idx);
+    const name_t *var = NamesTableFindByIdx (&program->namesTable, value.idx);
     if (var == NULL)
     {
         SYNTAX_ERROR_MESSAGE ("%s", "Uknown variable");
     }
 
-    if (StackFind (&program->variables, token->value.idx) != STACK_OK)
+    if (!SymbolTableIsDeclared (&program->variables, value.idx))
         SYNTAX_ERROR_MESSAGE ("Variable \"%.*s\" used, but not declarated before", (int) var->len, var->name);
 
-    *node = NodeCtorAndFill (&program->ast, token->type, token->value, NULL, NULL);
+    *node = NodeCtorAndFill (&program->ast, TYPE_NAME, value, NULL, NULL);
 
     NODE_DUMP (program, *node, "Created new node (variable). curToken = %lu", *curToken);
 
@@ -961,31 +1308,24 @@ int SetVariable (program_t *program, tokensArray_t *tokens, size_t *curToken, no
         return TREE_ERROR_INVALID_TOKEN;
     }
 
-    const token_t *token = &tokens->data[*curToken];
+    value_t value = TokenValue (tokens, *curToken);
 
-    const name_t *var = NamesTableFindByIdx (&program->namesTable, token->value.idx);
+    const name_t *var = NamesTableFindByIdx (&program->namesTable, value.idx);
     if (var == NULL)
     {
         ERROR_LOG ("%s", "Uknown variable name, error somewhere in tokenizator");
         SYNTAX_ERROR;
     }
 
-    if (StackFind (&program->variables, token->value.idx) == STACK_OK)
+    if (SymbolTableIsDeclared (&program->variables, value.idx))
     {
         ERROR_LOG ("Redeclaration of the variable \"%.*s\"", (int) var->len, var->name);
         SYNTAX_ERROR;
     }
 
-    int status = StackPush (&program->variables, token->value.idx);
-    if (status != STACK_OK)
-    {
-        StackPrintError (status);
-        
-        return TREE_ERROR_STACK |
-               status;
-    }
+    TREE_DO_AND_RETURN (SymbolTableDeclare (&program->variables, value.idx));
 
-    *node = NodeCtorAndFill (&program->ast, token->type, token->value, NULL, NULL);
+    *node = NodeCtorAndFill (&program->ast, TYPE_NAME, value, NULL, NULL);
 
     NODE_DUMP (program, *node, "Created new node (variable). curToken = %lu", *curToken);
 
@@ -1010,31 +1350,24 @@ int AddFunctionName (program_t *program, tokensArray_t *tokens, size_t *curToken
         return TREE_ERROR_INVALID_TOKEN;
     }
 
-    const token_t *token = &tokens->data[*curToken];
+    size_t nameIdx = TokenValue (tokens, *curToken).idx;
 
-    const name_t *var = NamesTableFindByIdx (&program->namesTable, token->value.idx);
+    const name_t *var = NamesTableFindByIdx (&program->namesTable, nameIdx);
     if (var == NULL)
     {
         ERROR_LOG ("%s", "Uknown function name, error somewhere in tokenizator");
         SYNTAX_ERROR;
     }
     
-    if (StackFind (&program->functions, token->value.idx) == STACK_OK)
+    if (SymbolTableIsDeclared (&program->functions, nameIdx))
     {
         ERROR_LOG ("Redeclaration of the function \"%.*s\"", (int) var->len, var->name);
         SYNTAX_ERROR;
     }
 
-    int status = StackPush (&program->variables, token->value.idx);
-    if (status != STACK_OK)
-    {
-        StackPrintError (status);
-        
-        return TREE_ERROR_STACK |
-               status;
-    }
+    TREE_DO_AND_RETURN (SymbolTableDeclare (&program->functions, nameIdx));
 
-    *node = NAME_ (token->value.idx);
+    *node = NAME_ (nameIdx);
 
     NODE_DUMP (program, *node, "Created new node (variable). curToken = %lu", *curToken);
 
@@ -1046,6 +1379,8 @@ int AddFunctionName (program_t *program, tokensArray_t *tokens, size_t *curToken
 #include "dsl_undef.h"
 
 #undef SYNTAX_ERROR
+#undef SYNTAX_ERROR_MESSAGE
+#undef RETURN_IF_STREAM_FAILED
 
 #undef IS_NEXT_TOKEN_KEYWORD
 #undef IS_TOKEN_KEYWORD
@@ -0,0 +1,24 @@
+#!/bin/bash
+# builds optimized frontend and backend and runs every check in tests/
+
+cd "$(dirname "$0")" || exit 1
+
+(cd frontend && make release) || exit 1
+(cd backend && make release) || exit 1
+(cd frontend && make simplify_allocs) || exit 1
+(cd frontend && make compact_roundtrip) || exit 1
+(cd frontend && make edit_incremental) || exit 1
+
+failed=0
+
+for check in tests/lexer_parallel.sh tests/lexer_stream.sh tests/deep_programs.sh tests/bin/simplify_allocs \
+             tests/compact_roundtrip.sh tests/edit_incremental.sh; do
+    "$check" || failed=$((failed + 1))
+done
+
+if [ "$failed" -ne 0 ]; then
+    echo "$failed checks failed"
+    exit 1
+fi
+
+echo "all checks passed"
@@ -0,0 +1,63 @@
+/*
+    Common part of microbenchmarks in tests/: time of the best of kBenchRuns runs,
+    inputs made by seeded random numbers, so that every run of benchmark is the same,
+    and a sink for results, so that benchmarked code isn't thrown away by compiler
+*/
+
+#ifndef K_BENCH_H
+#define K_BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+const int kBenchRuns = 5;
+
+typedef void (*benchTask_t) (void *arg);
+
+inline double BenchNow ()
+{
+    timespec now = {};
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+// seconds of the fastest run of task (arg)
+inline double BenchBest (benchTask_t task, void *arg)
+{
+    double best = -1;
+
+    for (int run = 0; run < kBenchRuns; run++)
+    {
+        double start = BenchNow ();
+
+        task (arg);
+
+        double seconds = BenchNow () - start;
+
+        if (best < 0 || seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
+
+// xorshift
+inline uint64_t BenchRandom (uint64_t *seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+
+    return *seed;
+}
+
+inline void BenchKeep (uint64_t value)
+{
+    static volatile uint64_t sink = 0;
+
+    sink = sink + value;
+}
+
+#endif // K_BENCH_H
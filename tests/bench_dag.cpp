@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tree.h"
+#include "tree_ast.h"
+#include "tokenizator.h"
+#include "tree_load_infix.h"
+#include "bench.h"
+
+// Plain tree, where simplifier copies subtrees and deletes old ones, against DAG mode
+// (hash-consed nodes with reference counts) on one source: parsing, NodeCopy () and
+// TreeDelete () of the whole ast, TreeSimplify () -O1 and nodes, that are kept.
+// Then node allocation: from slabs with free list, as tree does, against malloc () per node,
+// for 2^10..max nodes at once (none, if max is 0)
+const size_t kMinNodes          = 1 << 10;
+const size_t kDefaultMaxNodes   = 1 << 22;
+const size_t kAllocOperations   = 1 << 23;
+
+struct dagBench_t
+{
+    const char *fileName    = NULL;
+    bool isShared           = false;
+
+    // the best of runs
+    double parse            = -1;
+    double copy             = -1;
+    double simplify         = -1;
+
+    size_t nodes            = 0;
+    size_t nodesBytes       = 0;    // of slabs
+    size_t nodesSimplified  = 0;
+    size_t allocsSimplify   = 0;    // nodes taken by TreeSimplify ()
+
+    int error               = TREE_OK;
+};
+
+struct allocBench_t
+{
+    size_t count            = 0;
+    size_t rounds           = 0;    // count nodes are taken and released in every round
+    program_t program       = {};   // its ast is used
+
+    int error               = TREE_OK;
+};
+
+static void DagBenchRun     (dagBench_t *bench);
+static void BenchBestOf     (double *best, double start);
+
+static void AllocSlabs      (void *benchPtr);
+static void AllocMalloc     (void *benchPtr);
+
+int main (int argc, char **argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf (stderr, "Launch program like this: %s source_file.rap [max_nodes]\n", argv[0]);
+
+        return 1;
+    }
+
+    printf ("mode    parse, s   copy and delete, s   simplify -O1, s   "
+            "nodes, k   nodes, MB   nodes after -O1, k   allocs by -O1, k\n");
+
+    for (int isShared = 0; isShared <= 1; isShared++)
+    {
+        dagBench_t bench = {.fileName = argv[1], .isShared = (bool) isShared};
+
+        for (int run = 0; run < kBenchRuns && bench.error == TREE_OK; run++)
+            DagBenchRun (&bench);
+
+        if (bench.error != TREE_OK)
+        {
+            fprintf (stderr, "Loading \"%s\" failed with %d\n", argv[1], bench.error);
+
+            return 1;
+        }
+
+        printf ("%-5s   %8.3f   %18.6f   %15.3f   %8lu   %9.1f   %18lu   %16lu\n",
+                isShared ? "dag" : "plain", bench.parse, bench.copy, bench.simplify,
+                bench.nodes / 1000, (double) bench.nodesBytes / 1e6, bench.nodesSimplified / 1000,
+                bench.allocsSimplify / 1000);
+    }
+
+    size_t maxNodes = (argc == 3) ? strtoul (argv[2], NULL, 10) : kDefaultMaxNodes;
+
+    if (maxNodes >= kMinNodes)
+        printf ("\n    nodes   slabs and free list, ns   malloc () per node, ns\n");
+
+    for (size_t count = kMinNodes; count <= maxNodes; count *= 16)
+    {
+        allocBench_t alloc = {.count = count, .rounds = (kAllocOperations + count - 1) / count};
+
+        if (ProgramCtor (&alloc.program) != TREE_OK)
+            return 1;
+
+        double slabs   = BenchBest (AllocSlabs,  &alloc);
+        double perNode = BenchBest (AllocMalloc, &alloc);
+
+        ProgramDtor (&alloc.program);
+
+        if (alloc.error != TREE_OK)
+        {
+            fprintf (stderr, "Allocating nodes failed with %d\n", alloc.error);
+
+            return 1;
+        }
+
+        double operations = (double) (alloc.rounds * count);
+
+        printf ("%9lu   %23.2f   %22.2f\n", count, slabs / operations * 1e9, perNode / operations * 1e9);
+    }
+
+    return 0;
+}
+
+// source is lexed again every run, only the rest is timed
+void DagBenchRun (dagBench_t *bench)
+{
+    program_t program = {};
+
+    int status = ProgramCtor (&program);
+
+    tree_t *ast = &program.ast;
+    ast->isShared = bench->isShared;
+
+    if (status == TREE_OK)
+        status = GetTokens (bench->fileName, &program, 1);
+
+    double start = BenchNow ();
+
+    if (status == TREE_OK)
+        status = TreeLoadInfixFromTokens (&program);
+
+    BenchBestOf (&bench->parse, start);
+
+    bench->nodes      = ast->size;
+    bench->nodesBytes = ast->nodes.bytesUsed;
+
+    start = BenchNow ();
+
+    if (status == TREE_OK)
+    {
+        node_t *copy = NodeCopy (ast->root, ast);
+
+        if (copy != NULL)
+            TreeDelete (ast, &copy);
+        else
+            status = TREE_ERROR_CREATING_NODE;
+    }
+
+    BenchBestOf (&bench->copy, start);
+
+    size_t allocs = ast->allocsCount;
+
+    start = BenchNow ();
+
+    if (status == TREE_OK)
+        status = TreeSimplify (&program, ast, SIMPLIFY_EXPRESSIONS);
+
+    BenchBestOf (&bench->simplify, start);
+
+    bench->nodesSimplified = ast->size;
+    bench->allocsSimplify  = ast->allocsCount - allocs;
+
+    if (status != TREE_OK)
+        bench->error = status;
+
+    ProgramDtor (&program);
+}
+
+void BenchBestOf (double *best, double start)
+{
+    double seconds = BenchNow () - start;
+
+    if (*best < 0 || seconds < *best)
+        *best = seconds;
+}
+
+// Chain of nodes is made and deleted to free list in every round, slabs are released at the end
+void AllocSlabs (void *benchPtr)
+{
+    allocBench_t *alloc = (allocBench_t *) benchPtr;
+
+    tree_t *tree = &alloc->program.ast;
+
+    for (size_t round = 0; round < alloc->rounds && alloc->error == TREE_OK; round++)
+    {
+        node_t *chain = NULL;
+
+        for (size_t i = 0; i < alloc->count; i++)
+        {
+            node_t *node = NodeCtorAndFill (tree, TYPE_KEYWORD, {.idx = KEY_ADD}, chain, NULL);
+            if (node == NULL)
+            {
+                alloc->error = TREE_ERROR_CREATING_NODE;
+                break;
+            }
+
+            chain = node;
+        }
+
+        BenchKeep (tree->size);
+
+        if (chain != NULL)
+            TreeDelete (tree, &chain);
+    }
+
+    TreeDtor (tree);
+}
+
+void AllocMalloc (void *benchPtr)
+{
+    allocBench_t *alloc = (allocBench_t *) benchPtr;
+
+    for (size_t round = 0; round < alloc->rounds && alloc->error == TREE_OK; round++)
+    {
+        node_t *chain = NULL;
+        size_t size   = 0;
+
+        for ( ; size < alloc->count; size++)
+        {
+            node_t *node = (node_t *) malloc (sizeof (node_t));
+            if (node == NULL)
+            {
+                alloc->error = TREE_ERROR_COMMON | COMMON_ERROR_ALLOCATING_MEMORY;
+                break;
+            }
+
+            *node = {.type = TYPE_KEYWORD, .value = {.idx = KEY_ADD}, .left = chain};
+
+            chain = node;
+        }
+
+        BenchKeep (size);
+
+        while (chain != NULL)
+        {
+            node_t *left = chain->left;
+
+            free (chain);
+
+            chain = left;
+        }
+    }
+}
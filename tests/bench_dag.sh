@@ -0,0 +1,27 @@
+#!/bin/bash
+# bench_dag.sh [statements] - plain tree against DAG mode on a program with the same expression
+# in every statement and on a generated program with different ones, then node allocation
+# from slabs against malloc () per node
+
+cd "$(dirname "$0")/.." || exit 1
+
+statements=${1:-100000}
+
+if [ ! -x tests/bin/bench_dag ]; then
+    echo "bench_dag: no tests/bin/bench_dag, run 'make bench_dag' in frontend/"
+    exit 1
+fi
+
+source=$(mktemp --suffix=.rap)
+trap 'rm -f "$source"' EXIT
+
+tests/gen_repeated.sh "$statements" > "$source"
+
+echo "$statements statements with the same expression"
+tests/bin/bench_dag "$source" 0 || exit 1
+
+tests/gen_program.sh "$statements" > "$source"
+
+echo
+echo "$statements statements of gen_program.sh"
+tests/bin/bench_dag "$source"
@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "tree_ast.h"
+#include "tokenizator.h"
+#include "tree_load_infix.h"
+
+// Time of one edit: GetTokensAfterEdit () and TreeLoadInfixAfterEdit () against GetTokens ()
+// and TreeLoadInfixFromTokens () of the edited source from scratch. Edits are in random
+// functions: number is changed (the same number of tokens) or statement is added
+const size_t kPathLen = 256;
+
+static const char kStatement[] = "    v0 стал v0 фит 7 тррря\n";
+
+enum benchEdit_t
+{
+    BENCH_EDIT_NUMBER,
+    BENCH_EDIT_STATEMENT,
+};
+
+static int BenchEdits       (const char *fileName, const char *editedFile, benchEdit_t kind,
+                             size_t editsCount);
+static bool MakeEdit        (program_t *program, benchEdit_t kind, uint64_t *seed,
+                             sourceEdit_t *edit, char *number, size_t numberSize);
+static int LoadFresh        (const char *fileName, double *seconds);
+static int SaveSource       (program_t *program, const char *fileName);
+static double SecondsSince  (const timespec *start);
+static uint64_t NextRandom  (uint64_t *seed);
+
+int main (int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        fprintf (stderr, "Launch program like this: %s source_file.rap work_dir edits\n", argv[0]);
+
+        return 1;
+    }
+
+    char editedFile [kPathLen] = {};
+    snprintf (editedFile, kPathLen, "%s/edited.rap", argv[2]);
+
+    size_t editsCount = strtoul (argv[3], NULL, 10);
+
+    printf ("edit          incremental        full   speedup\n");
+
+    if (BenchEdits (argv[1], editedFile, BENCH_EDIT_NUMBER,    editsCount) != 0 ||
+        BenchEdits (argv[1], editedFile, BENCH_EDIT_STATEMENT, editsCount) != 0)
+        return 1;
+
+    return 0;
+}
+
+int BenchEdits (const char *fileName, const char *editedFile, benchEdit_t kind, size_t editsCount)
+{
+    program_t program = {};
+
+    int status = ProgramCtor (&program);
+
+    if (status == TREE_OK)
+        status = GetTokens (fileName, &program, 1);
+
+    if (status == TREE_OK)
+        status = TreeLoadInfixFromTokens (&program);
+
+    uint64_t seed = 0x9E3779B97F4A7C15;
+
+    double incremental = 0;
+    double full        = 0;
+
+    for (size_t editIdx = 0; editIdx < editsCount && status == TREE_OK; editIdx++)
+    {
+        sourceEdit_t edit = {};
+        tokensEdit_t tokensEdit = {};
+        char number [32] = {};
+
+        if (!MakeEdit (&program, kind, &seed, &edit, number, sizeof (number)))
+        {
+            status = TREE_ERROR_COMMON;
+            break;
+        }
+
+        timespec start = {};
+        clock_gettime (CLOCK_MONOTONIC, &start);
+
+        status = GetTokensAfterEdit (&program, &edit, &tokensEdit);
+
+        if (status == TREE_OK)
+            status = TreeLoadInfixAfterEdit (&program, &tokensEdit);
+
+        incremental += SecondsSince (&start);
+
+        if (status == TREE_OK)
+            status = SaveSource (&program, editedFile);
+
+        double seconds = 0;
+
+        if (status == TREE_OK)
+            status = LoadFresh (editedFile, &seconds);
+
+        full += seconds;
+    }
+
+    ProgramDtor (&program);
+
+    if (status != TREE_OK)
+    {
+        fprintf (stderr, "Edit of \"%s\" failed with %d\n", fileName, status);
+
+        return 1;
+    }
+
+    printf ("%-9s   %9.3f ms   %6.1f ms   %6.0fx\n",
+            (kind == BENCH_EDIT_NUMBER) ? "number" : "statement",
+            incremental / (double) editsCount * 1e3, full / (double) editsCount * 1e3, full / incremental);
+
+    return 0;
+}
+
+// Number is the first one after random offset, it's changed to one of up to 3 digits.
+// Statement is put before a random assignment, v0 is declared by the first statement of function
+bool MakeEdit (program_t *program, benchEdit_t kind, uint64_t *seed, sourceEdit_t *edit,
+               char *number, size_t numberSize)
+{
+    const char *data = program->source.data;
+    size_t size      = program->source.size;
+
+    size_t pos = 1 + NextRandom (seed) % (size - 1);
+
+    if (kind == BENCH_EDIT_NUMBER)
+    {
+        // digits of names aren't numbers
+        while (pos < size && (data[pos] < '0' || data[pos] > '9' || data[pos - 1] != ' '))
+            pos++;
+
+        size_t end = pos;
+        while (end < size && data[end] >= '0' && data[end] <= '9')
+            end++;
+
+        int numberLen = snprintf (number, numberSize, "%lu", NextRandom (seed) % 1000);
+
+        *edit = {.begin = pos, .end = end, .text = number, .textLen = (size_t) numberLen};
+
+        return pos < size;
+    }
+
+    const char *assignment = strstr (data + pos, " стал ");
+    if (assignment == NULL)
+        return false;
+
+    size_t lineBegin = (size_t) (assignment - data);
+    while (lineBegin > 0 && data[lineBegin - 1] != '\n')
+        lineBegin--;
+
+    *edit = {.begin = lineBegin, .end = lineBegin, .text = kStatement, .textLen = sizeof (kStatement) - 1};
+
+    return true;
+}
+
+int LoadFresh (const char *fileName, double *seconds)
+{
+    program_t program = {};
+
+    timespec start = {};
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    int status = ProgramCtor (&program);
+
+    if (status == TREE_OK)
+        status = GetTokens (fileName, &program, 1);
+
+    if (status == TREE_OK)
+        status = TreeLoadInfixFromTokens (&program);
+
+    *seconds = SecondsSince (&start);
+
+    ProgramDtor (&program);
+
+    return status;
+}
+
+int SaveSource (program_t *program, const char *fileName)
+{
+    FILE *file = fopen (fileName, "wb");
+    if (file == NULL)
+    {
+        fprintf (stderr, "Error opening file \"%s\"\n", fileName);
+
+        return TREE_ERROR_COMMON |
+               COMMON_ERROR_OPENING_FILE;
+    }
+
+    fwrite (program->source.data, sizeof (char), program->source.size, file);
+    fclose (file);
+
+    return TREE_OK;
+}
+
+double SecondsSince (const timespec *start)
+{
+    timespec end = {};
+    clock_gettime (CLOCK_MONOTONIC, &end);
+
+    return (double) (end.tv_sec - start->tv_sec) + (double) (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// xorshift, so that edits are the same on every run
+uint64_t NextRandom (uint64_t *seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+
+    return *seed;
+}
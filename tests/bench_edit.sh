@@ -0,0 +1,23 @@
+#!/bin/bash
+# bench_edit.sh [statements] [functions] [edits] - incremental lexing and parsing after an edit
+# against lexing and parsing the edited source from scratch, on a generated program
+
+cd "$(dirname "$0")/.." || exit 1
+
+statements=${1:-200000}
+functions=${2:-100}
+edits=${3:-20}
+
+if [ ! -x tests/bin/bench_edit ]; then
+    echo "bench_edit: no tests/bin/bench_edit, run 'make bench_edit' in frontend/"
+    exit 1
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+tests/gen_program.sh "$statements" "$functions" > "$work/source.rap"
+
+echo "$(($(wc -c < "$work/source.rap") / 1000)) KB source, $functions functions"
+
+tests/bin/bench_edit "$work/source.rap" "$work" "$edits"
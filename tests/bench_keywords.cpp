@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tree_ast.h"
+#include "keyword_trie.h"
+#include "lexer_dfa.h"
+#include "bench.h"
+
+// Keyword lookup of one word: linear scan of kKeywords[] with strncmp (), as tokenizer did
+// before the trie, against the trie and the lexer DFA, that is built from it. Words are
+// keywords, names and numbers, separated by spaces
+const size_t kWordsCount = 1 << 20;
+
+static const keywordTrie_t kTrie = KeywordTrieBuild ();
+
+struct words_t
+{
+    char *buffer        = NULL;
+    size_t *offsets     = NULL;
+    size_t *lens        = NULL;
+
+    size_t count        = 0;
+    size_t keywords     = 0;
+};
+
+static int  WordsCtor       (words_t *words, size_t count, unsigned keywordsPercent);
+static void WordsDtor       (words_t *words);
+static bool AreLookupsSame  (const words_t *words);
+
+static void LookupLinear    (void *wordsPtr);
+static void LookupTrie      (void *wordsPtr);
+static void LookupDfa       (void *wordsPtr);
+
+int main ()
+{
+    const unsigned kKeywordsPercents[] = {10, 50, 90};
+
+    printf ("keywords, %%   linear, ns   trie, ns   dfa, ns   trie speedup   dfa speedup\n");
+
+    for (size_t i = 0; i < sizeof (kKeywordsPercents) / sizeof (kKeywordsPercents[0]); i++)
+    {
+        words_t words = {};
+
+        if (WordsCtor (&words, kWordsCount, kKeywordsPercents[i]) != 0)
+            return 1;
+
+        if (!AreLookupsSame (&words))
+        {
+            WordsDtor (&words);
+
+            return 1;
+        }
+
+        double linear = BenchBest (LookupLinear, &words) / (double) words.count * 1e9;
+        double trie   = BenchBest (LookupTrie,   &words) / (double) words.count * 1e9;
+        double dfa    = BenchBest (LookupDfa,    &words) / (double) words.count * 1e9;
+
+        printf ("%11u   %10.1f   %8.1f   %7.1f   %11.2fx   %10.2fx\n", kKeywordsPercents[i],
+                linear, trie, dfa, linear / trie, linear / dfa);
+
+        WordsDtor (&words);
+    }
+
+    return 0;
+}
+
+int WordsCtor (words_t *words, size_t count, unsigned keywordsPercent)
+{
+    const size_t kMaxWordLen = 64;
+
+    words->buffer  = (char *)   calloc (count * kMaxWordLen + 1, sizeof (char));
+    words->offsets = (size_t *) calloc (count, sizeof (size_t));
+    words->lens    = (size_t *) calloc (count, sizeof (size_t));
+
+    if (words->buffer == NULL || words->offsets == NULL || words->lens == NULL)
+    {
+        WordsDtor (words);
+
+        return 1;
+    }
+
+    uint64_t seed = 0x9E3779B97F4A7C15;
+
+    char *pos = words->buffer;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t kind = BenchRandom (&seed) % 100;
+
+        if (kind < keywordsPercent)
+        {
+            const keyword_t *keyword = &kKeywords[BenchRandom (&seed) % kNumberOfKeywords];
+
+            memcpy (pos, keyword->name, keyword->nameLen);
+            words->lens[i] = keyword->nameLen;
+            words->keywords++;
+        }
+        else if (kind % 2 == 0)
+            words->lens[i] = (size_t) sprintf (pos, "v%lu", BenchRandom (&seed) % 100000);
+        else
+            words->lens[i] = (size_t) sprintf (pos, "%lu",  BenchRandom (&seed) % 100000);
+
+        words->offsets[i] = (size_t) (pos - words->buffer);
+
+        pos += words->lens[i];
+        *pos++ = ' ';
+    }
+
+    words->count = count;
+
+    return 0;
+}
+
+void WordsDtor (words_t *words)
+{
+    free (words->buffer);
+    free (words->offsets);
+    free (words->lens);
+
+    *words = {};
+}
+
+// trie and DFA find the same keyword in the whole word
+bool AreLookupsSame (const words_t *words)
+{
+    for (size_t i = 0; i < words->count; i++)
+    {
+        const char *word = words->buffer + words->offsets[i];
+
+        int keyword = KeywordTrieFind (&kTrie, word, words->lens[i]);
+
+        uint8_t accept = LEXER_DFA_ACCEPT_NONE;
+        size_t len = LexerDfaMatch (word, &accept);
+
+        bool isDfaKeyword = (len == words->lens[i] && accept >= kLexerDfaAcceptKeyword);
+
+        if ((keyword != kKeywordTrieNoNode) != isDfaKeyword ||
+            (isDfaKeyword && accept - kLexerDfaAcceptKeyword != keyword))
+        {
+            fprintf (stderr, "Trie and DFA differ on \"%.*s\"\n", (int) words->lens[i], word);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// the first keyword, that word begins with
+void LookupLinear (void *wordsPtr)
+{
+    const words_t *words = (const words_t *) wordsPtr;
+
+    uint64_t found = 0;
+
+    for (size_t i = 0; i < words->count; i++)
+    {
+        const char *word = words->buffer + words->offsets[i];
+
+        for (size_t keyword = 0; keyword < kNumberOfKeywords; keyword++)
+        {
+            if (strncmp (word, kKeywords[keyword].name, kKeywords[keyword].nameLen) == 0)
+            {
+                found += keyword + 1;
+                break;
+            }
+        }
+    }
+
+    BenchKeep (found);
+}
+
+void LookupTrie (void *wordsPtr)
+{
+    const words_t *words = (const words_t *) wordsPtr;
+
+    uint64_t found = 0;
+
+    for (size_t i = 0; i < words->count; i++)
+        found += (uint64_t) (KeywordTrieFind (&kTrie, words->buffer + words->offsets[i], words->lens[i]) + 1);
+
+    BenchKeep (found);
+}
+
+void LookupDfa (void *wordsPtr)
+{
+    const words_t *words = (const words_t *) wordsPtr;
+
+    uint64_t found = 0;
+
+    for (size_t i = 0; i < words->count; i++)
+    {
+        uint8_t accept = LEXER_DFA_ACCEPT_NONE;
+
+        found += LexerDfaMatch (words->buffer + words->offsets[i], &accept) + accept;
+    }
+
+    BenchKeep (found);
+}
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "tree_ast.h"
+#include "tokenizator.h"
+
+// Best time of kBenchRuns runs of GetTokens () with each number of threads from 1 to N
+const int kBenchRuns = 5;
+
+static double BenchGetTokens (const char *fileName, size_t threadsCount, size_t *bytes);
+
+int main (int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf (stderr, "Launch program like this: %s source_file.rap max_threads\n", argv[0]);
+
+        return 1;
+    }
+
+    size_t maxThreads = strtoul (argv[2], NULL, 10);
+
+    double sequential = 0;
+
+    printf ("threads      time        MB/s   speedup\n");
+
+    for (size_t threadsCount = 1; threadsCount <= maxThreads; threadsCount++)
+    {
+        size_t bytes = 0;
+
+        double best = BenchGetTokens (argv[1], threadsCount, &bytes);
+        if (best < 0)
+            return 1;
+
+        if (threadsCount == 1)
+            sequential = best;
+
+        printf ("%7lu   %6.3f s   %9.1f   %6.2fx\n", threadsCount, best,
+                (double) bytes / best / 1e6, sequential / best);
+    }
+
+    return 0;
+}
+
+double BenchGetTokens (const char *fileName, size_t threadsCount, size_t *bytes)
+{
+    double best = -1;
+
+    for (int run = 0; run < kBenchRuns; run++)
+    {
+        program_t program = {};
+
+        if (ProgramCtor (&program) != TREE_OK)
+            return -1;
+
+        timespec start = {};
+        timespec end   = {};
+
+        clock_gettime (CLOCK_MONOTONIC, &start);
+
+        int status = GetTokens (fileName, &program, threadsCount);
+
+        clock_gettime (CLOCK_MONOTONIC, &end);
+
+        *bytes = program.source.size;
+
+        ProgramDtor (&program);
+
+        if (status != TREE_OK)
+        {
+            fprintf (stderr, "GetTokens () failed with %d on \"%s\"\n", status, fileName);
+
+            return -1;
+        }
+
+        double seconds = (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+        if (best < 0 || seconds < best)
+            best = seconds;
+    }
+
+    return best;
+}
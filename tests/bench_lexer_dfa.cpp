@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "tree_ast.h"
+#include "tokenizator.h"
+#include "keyword_trie.h"
+#include "simd_scan.h"
+#include "utils.h"
+#include "bench.h"
+
+// Lexing of a source from memory into tokens and names: FillTokensArray () with lexer DFA
+// against the path it replaced, that is copied here: isdigit (), then TryToFindOperator ()
+// with the longest keyword from the trie, then TokenAddName (). Both of them must give
+// the same tokens, or nothing is timed
+const size_t kSourceBytesPerToken = 8;  // tokens are reserved by source size, like GetTokens () does
+
+static constexpr keywordTrie_t kTrie = KeywordTrieBuild ();
+
+struct lexerBench_t
+{
+    sourceBuffer_t source   = {};
+
+    tokensArray_t tokens    = {};
+    namesTable_t names      = {};
+
+    int error               = TREE_OK;
+};
+
+typedef int (* fillTokens_t) (char *buffer, size_t size, tokensArray_t *tokens, namesTable_t *namesTable);
+
+static int  LexerBenchLex   (lexerBench_t *bench, fillTokens_t fillTokens);
+static void LexerBenchClear (lexerBench_t *bench);
+static bool AreTokensSame   (lexerBench_t *bench);
+
+static void LexOld          (void *benchPtr);
+static void LexDfa          (void *benchPtr);
+
+static int FillTokensOld    (char *buffer, size_t size, tokensArray_t *tokens, namesTable_t *namesTable);
+static int FillTokensDfa    (char *buffer, size_t size, tokensArray_t *tokens, namesTable_t *namesTable);
+
+static int  TryToFindOperator   (char **curPos, tokensArray_t *tokens, uint32_t offset);
+static int  TokenAddNumber      (char **curPos, tokensArray_t *tokens, uint32_t offset);
+static int  TokenAddName        (char **curPos, tokensArray_t *tokens, namesTable_t *namesTable,
+                                 uint32_t offset);
+static bool IsNameChar          (char c);
+
+int main (int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf (stderr, "Launch program like this: %s source_file.rap\n", argv[0]);
+
+        return 1;
+    }
+
+    lexerBench_t bench = {};
+
+    if (SourceBufferOpen (&bench.source, argv[1]) != COMMON_ERROR_OK)
+        return 1;
+
+    if (!AreTokensSame (&bench))
+    {
+        SourceBufferClose (&bench.source);
+
+        return 1;
+    }
+
+    size_t tokensCount = bench.tokens.size;
+    LexerBenchClear (&bench);
+
+    double old = BenchBest (LexOld, &bench);
+    double dfa = BenchBest (LexDfa, &bench);
+
+    double megabytes = (double) bench.source.size / 1e6;
+
+    SourceBufferClose (&bench.source);
+
+    if (bench.error != TREE_OK)
+    {
+        fprintf (stderr, "Lexing failed with %d on \"%s\"\n", bench.error, argv[1]);
+
+        return 1;
+    }
+
+    printf ("%.1f MB, %lu tokens\n", megabytes, tokensCount);
+    printf ("lexer                             MB/s   ns per token\n");
+    printf ("isdigit, trie, TokenAddName   %8.1f   %12.2f\n", megabytes / old,
+            old / (double) tokensCount * 1e9);
+    printf ("lexer DFA                     %8.1f   %12.2f\n", megabytes / dfa,
+            dfa / (double) tokensCount * 1e9);
+    printf ("speedup                       %7.2fx\n", old / dfa);
+
+    return 0;
+}
+
+// tokens and names are left in bench, status is returned
+int LexerBenchLex (lexerBench_t *bench, fillTokens_t fillTokens)
+{
+    LexerBenchClear (bench);
+
+    TREE_DO_AND_RETURN (TokensArrayCtor (&bench->tokens));
+    TREE_DO_AND_RETURN (NamesTableCtor (&bench->names));
+
+    // errors aren't printed, so lines aren't indexed
+    bench->tokens.isQuiet = true;
+
+    TREE_DO_AND_RETURN (TokensArrayReserve (&bench->tokens, bench->source.size / kSourceBytesPerToken));
+
+    return fillTokens (bench->source.data, bench->source.size, &bench->tokens, &bench->names);
+}
+
+void LexerBenchClear (lexerBench_t *bench)
+{
+    TokensArrayDtor (&bench->tokens);
+    NamesTableDtor  (&bench->names);
+}
+
+// names get ids in order of first appearance, so ids are the same too
+bool AreTokensSame (lexerBench_t *bench)
+{
+    int status = LexerBenchLex (bench, FillTokensOld);
+
+    tokensArray_t old = bench->tokens;
+    size_t oldNames   = bench->names.size;
+
+    bench->tokens = {};
+
+    if (status == TREE_OK)
+        status = LexerBenchLex (bench, FillTokensDfa);
+
+    bool isSame = false;
+
+    if (status != TREE_OK)
+    {
+        fprintf (stderr, "Lexing failed with %d\n", status);
+    }
+    else if (old.size != bench->tokens.size || oldNames != bench->names.size)
+    {
+        fprintf (stderr, "Lexers give %lu and %lu tokens, %lu and %lu names\n",
+                 old.size, bench->tokens.size, oldNames, bench->names.size);
+    }
+    else
+    {
+        isSame = true;
+
+        for (size_t i = 0; isSame && i < old.size; i++)
+        {
+            isSame = old.kinds[i]    == bench->tokens.kinds[i]    &&
+                     old.payloads[i] == bench->tokens.payloads[i] &&
+                     old.offsets[i]  == bench->tokens.offsets[i];
+
+            if (!isSame)
+                fprintf (stderr, "Lexers differ at token %lu, offset %u\n", i, old.offsets[i]);
+        }
+    }
+
+    TokensArrayDtor (&old);
+
+    return isSame;
+}
+
+void LexOld (void *benchPtr)
+{
+    lexerBench_t *bench = (lexerBench_t *) benchPtr;
+
+    int status = LexerBenchLex (bench, FillTokensOld);
+
+    if (status != TREE_OK)
+        bench->error = status;
+    else
+        BenchKeep (bench->tokens.size);
+
+    LexerBenchClear (bench);
+}
+
+void LexDfa (void *benchPtr)
+{
+    lexerBench_t *bench = (lexerBench_t *) benchPtr;
+
+    int status = LexerBenchLex (bench, FillTokensDfa);
+
+    if (status != TREE_OK)
+        bench->error = status;
+    else
+        BenchKeep (bench->tokens.size);
+
+    LexerBenchClear (bench);
+}
+
+int FillTokensOld (char *buffer, size_t size, tokensArray_t *tokens, namesTable_t *namesTable)
+{
+    char *end = buffer + size;
+
+    for (char *curPos = buffer; curPos < end && *curPos != '\0';)
+    {
+        curPos = SkipSpaces (curPos);
+
+        if (curPos >= end || *curPos == '\0')
+            break;
+
+        uint32_t offset = (uint32_t) (curPos - buffer);
+
+        if (isdigit (*curPos))
+        {
+            TREE_DO_AND_RETURN (TokenAddNumber (&curPos, tokens, offset));
+            continue;
+        }
+
+        if (TryToFindOperator (&curPos, tokens, offset) == TREE_OK)
+            continue;
+
+        TREE_DO_AND_RETURN (TokenAddName (&curPos, tokens, namesTable, offset));
+    }
+
+    return TREE_OK;
+}
+
+int FillTokensDfa (char *buffer, size_t size, tokensArray_t *tokens, namesTable_t *namesTable)
+{
+    return FillTokensArray (buffer, buffer, buffer + size, tokens, namesTable);
+}
+
+// the longest keyword, that isn't just a beginning of a name, e.g. "TODO" in "TODO_list"
+int TryToFindOperator (char **curPos, tokensArray_t *tokens, uint32_t offset)
+{
+    const char *str = *curPos;
+
+    int found       = kKeywordTrieNoNode;
+    size_t foundLen = 0;
+
+    int cur = 0;
+
+    for (size_t i = 0; str[i] != '\0'; i++)
+    {
+        int child = kTrie.nodes[cur].firstChild;
+
+        while (child != kKeywordTrieNoNode && kTrie.nodes[child].byte != (unsigned char) str[i])
+            child = kTrie.nodes[child].nextSibling;
+
+        if (child == kKeywordTrieNoNode)
+            break;
+
+        cur = child;
+
+        if (kTrie.nodes[cur].keyword == kKeywordTrieNoNode)
+            continue;
+
+        if (IsNameChar (str[i]) && IsNameChar (str[i + 1]))
+            continue;
+
+        found    = kTrie.nodes[cur].keyword;
+        foundLen = i + 1;
+    }
+
+    if (found == kKeywordTrieNoNode)
+        return TREE_ERROR_INVALID_TOKEN;
+
+    TREE_DO_AND_RETURN (TokenAdd (tokens, TYPE_KEYWORD, {.idx = kKeywords[found].idx}, offset));
+
+    (*curPos) += foundLen;
+
+    return TREE_OK;
+}
+
+int TokenAddNumber (char **curPos, tokensArray_t *tokens, uint32_t offset)
+{
+    numberLiteral_t literal = {};
+
+    size_t len = ScanNumber (*curPos, &literal);
+
+    if (literal.fraction != 0 || literal.isOverflow || literal.integer > (uint64_t) kValueNumberMax)
+        return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
+
+    *curPos += len;
+
+    return TokenAdd (tokens, TYPE_CONST_NUM, {.number = (valueNumber_t) literal.integer}, offset);
+}
+
+int TokenAddName (char **curPos, tokensArray_t *tokens, namesTable_t *namesTable, uint32_t offset)
+{
+    if (!isalpha (**curPos) && **curPos != '_')
+        return TREE_ERROR_SYNTAX_IN_SAVE_FILE;
+
+    char *nameStr = *curPos;
+
+    (*curPos) += ScanName (*curPos);
+
+    size_t idx = 0;
+
+    TREE_DO_AND_RETURN (NamesTableFindOrAdd (namesTable, nameStr, (size_t) (*curPos - nameStr), &idx));
+
+    return TokenAdd (tokens, TYPE_NAME, {.idx = idx}, offset);
+}
+
+bool IsNameChar (char c)
+{
+    return isalnum ((unsigned char) c) || c == '_';
+}
@@ -0,0 +1,26 @@
+#!/bin/bash
+# bench_lexer_dfa.sh [statements] - lexer DFA against isdigit, trie and TokenAddName lexer
+# on a generated program, as it is and with every line indented by 24 more spaces
+
+cd "$(dirname "$0")/.." || exit 1
+
+statements=${1:-1000000}
+
+if [ ! -x tests/bin/bench_lexer_dfa ]; then
+    echo "bench_lexer_dfa: no tests/bin/bench_lexer_dfa, run 'make bench_lexer_dfa' in frontend/"
+    exit 1
+fi
+
+source=$(mktemp --suffix=.rap)
+trap 'rm -f "$source"' EXIT
+
+tests/gen_program.sh "$statements" > "$source"
+
+echo "flat source"
+tests/bin/bench_lexer_dfa "$source" || exit 1
+
+sed -i "s/^/$(printf "%24s")/" "$source"
+
+echo
+echo "indented source"
+tests/bin/bench_lexer_dfa "$source"
@@ -0,0 +1,23 @@
+#!/bin/bash
+# bench_lexer_threads.sh [max threads] [statements] - scaling of the parallel lexer:
+# GetTokens () on a generated program with 1..N threads. Only lexing is timed,
+# parsing and saving don't depend on the number of threads
+
+cd "$(dirname "$0")/.." || exit 1
+
+maxThreads=${1:-$(nproc)}
+statements=${2:-1000000}
+
+if [ ! -x tests/bin/bench_lexer ]; then
+    echo "bench_lexer_threads: no tests/bin/bench_lexer, run 'make bench_lexer' in frontend/"
+    exit 1
+fi
+
+source=$(mktemp --suffix=.rap)
+trap 'rm -f "$source"' EXIT
+
+tests/gen_program.sh "$statements" > "$source"
+
+echo "$(($(wc -c < "$source") / 1000000)) MB source, $(nproc) CPUs"
+
+tests/bin/bench_lexer "$source" "$maxThreads"
@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tree_ast.h"
+#include "arena.h"
+#include "bench.h"
+
+// Names table with 10..10^6 distinct names: adding all of them and looking up existing ones,
+// against linear search, as it was before hash interner (it's too slow after 10^5 names).
+// Names are copied from source to arena, when source is edited: it's compared with malloc ()
+// of every name
+const size_t kMaxNamesCount     = 1000000;
+const size_t kLinearMaxNames    = 100000;
+const size_t kLookupsCount      = 1 << 20;
+const size_t kLinearCompares    = 1 << 27;  // lookups of linear search are fewer for more names
+
+struct names_t
+{
+    char *buffer        = NULL;
+    size_t *offsets     = NULL;
+    size_t *lens        = NULL;
+    size_t count        = 0;
+
+    size_t *lookups     = NULL;     // indexes of names
+    size_t lookupsCount = 0;
+
+    namesTable_t table  = {};
+    char **copies       = NULL;
+};
+
+static int  NamesCtor       (names_t *names, size_t count);
+static void NamesDtor       (names_t *names);
+
+static void NamesAdd        (void *namesPtr);
+static void NamesLookup     (void *namesPtr);
+static void NamesLookupLinear (void *namesPtr);
+static void NamesCopyArena  (void *namesPtr);
+static void NamesCopyMalloc (void *namesPtr);
+
+int main ()
+{
+    printf ("  names    add, ns   lookup, ns   linear, ns   arena copy, ns   malloc copy, ns\n");
+
+    for (size_t count = 10; count <= kMaxNamesCount; count *= 10)
+    {
+        names_t names = {};
+
+        if (NamesCtor (&names, count) != 0)
+        {
+            NamesDtor (&names);
+
+            return 1;
+        }
+
+        double add    = BenchBest (NamesAdd,        &names) / (double) count * 1e9;
+        double lookup = BenchBest (NamesLookup,     &names) / (double) names.lookupsCount * 1e9;
+        double arena  = BenchBest (NamesCopyArena,  &names) / (double) count * 1e9;
+        double copy   = BenchBest (NamesCopyMalloc, &names) / (double) count * 1e9;
+
+        printf ("%7lu   %8.1f   %10.1f", count, add, lookup);
+
+        if (count <= kLinearMaxNames)
+        {
+            names.lookupsCount = kLinearCompares / count;
+            if (names.lookupsCount > kLookupsCount)
+                names.lookupsCount = kLookupsCount;
+
+            printf ("   %10.1f", BenchBest (NamesLookupLinear, &names) / (double) names.lookupsCount * 1e9);
+        }
+        else
+        {
+            printf ("   %10s", "-");
+        }
+
+        printf ("   %14.1f   %15.1f\n", arena, copy);
+
+        NamesDtor (&names);
+    }
+
+    return 0;
+}
+
+// names are like in programs: letters, digits and '_', of different length
+int NamesCtor (names_t *names, size_t count)
+{
+    const size_t kMaxNameLen = 32;
+
+    names->buffer  = (char *)   calloc (count * kMaxNameLen, sizeof (char));
+    names->offsets = (size_t *) calloc (count, sizeof (size_t));
+    names->lens    = (size_t *) calloc (count, sizeof (size_t));
+    names->lookups = (size_t *) calloc (kLookupsCount, sizeof (size_t));
+    names->copies  = (char **)  calloc (count, sizeof (char *));
+
+    if (names->buffer == NULL || names->offsets == NULL || names->lens == NULL ||
+        names->lookups == NULL || names->copies == NULL)
+        return 1;
+
+    uint64_t seed = 0x9E3779B97F4A7C15;
+
+    static const char *kPrefixes[] = {"v", "counter_", "x", "tmp", "lastValueOf_"};
+
+    size_t offset = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const char *prefix = kPrefixes[BenchRandom (&seed) % (sizeof (kPrefixes) / sizeof (kPrefixes[0]))];
+
+        names->offsets[i] = offset;
+        names->lens[i]    = (size_t) sprintf (names->buffer + offset, "%s%lu", prefix, i);
+
+        offset += names->lens[i];
+    }
+
+    names->count = count;
+
+    for (size_t i = 0; i < kLookupsCount; i++)
+        names->lookups[i] = BenchRandom (&seed) % count;
+
+    names->lookupsCount = kLookupsCount;
+
+    if (NamesTableCtor (&names->table) != TREE_OK)
+        return 1;
+
+    NamesAdd (names);
+
+    return 0;
+}
+
+void NamesDtor (names_t *names)
+{
+    NamesTableDtor (&names->table);
+
+    free (names->buffer);
+    free (names->offsets);
+    free (names->lens);
+    free (names->lookups);
+    free (names->copies);
+
+    *names = {};
+}
+
+// table is made again
+void NamesAdd (void *namesPtr)
+{
+    names_t *names = (names_t *) namesPtr;
+
+    NamesTableDtor (&names->table);
+
+    if (NamesTableCtor (&names->table) != TREE_OK)
+        return;
+
+    size_t idx = 0;
+
+    for (size_t i = 0; i < names->count; i++)
+    {
+        if (NamesTableFindOrAdd (&names->table, names->buffer + names->offsets[i], names->lens[i],
+                                 &idx) != TREE_OK)
+            return;
+    }
+
+    BenchKeep (idx);
+}
+
+void NamesLookup (void *namesPtr)
+{
+    names_t *names = (names_t *) namesPtr;
+
+    uint64_t found = 0;
+
+    for (size_t i = 0; i < names->lookupsCount; i++)
+    {
+        size_t name = names->lookups[i];
+        size_t idx  = 0;
+
+        NamesTableFindOrAdd (&names->table, names->buffer + names->offsets[name], names->lens[name], &idx);
+
+        found += idx;
+    }
+
+    BenchKeep (found);
+}
+
+void NamesLookupLinear (void *namesPtr)
+{
+    names_t *names = (names_t *) namesPtr;
+
+    const name_t *table = names->table.data;
+
+    uint64_t found = 0;
+
+    for (size_t i = 0; i < names->lookupsCount; i++)
+    {
+        const char *name = names->buffer + names->offsets[names->lookups[i]];
+        size_t len       = names->lens[names->lookups[i]];
+
+        for (size_t idx = 0; idx < names->table.size; idx++)
+        {
+            if (table[idx].len == len && strncmp (table[idx].name, name, len) == 0)
+            {
+                found += idx;
+                break;
+            }
+        }
+    }
+
+    BenchKeep (found);
+}
+
+void NamesCopyArena (void *namesPtr)
+{
+    names_t *names = (names_t *) namesPtr;
+
+    arena_t arena = {};
+    ArenaCtor (&arena, kArenaDefaultBlockSize);
+
+    for (size_t i = 0; i < names->count; i++)
+        names->copies[i] = ArenaStrDup (&arena, names->buffer + names->offsets[i], names->lens[i]);
+
+    BenchKeep ((uintptr_t) names->copies[names->count - 1]);
+
+    ArenaDtor (&arena);
+}
+
+void NamesCopyMalloc (void *namesPtr)
+{
+    names_t *names = (names_t *) namesPtr;
+
+    size_t copied = 0;
+
+    for ( ; copied < names->count; copied++)
+    {
+        char *copy = (char *) malloc (names->lens[copied] + 1);
+        if (copy == NULL)
+            break;
+
+        memcpy (copy, names->buffer + names->offsets[copied], names->lens[copied]);
+        copy[names->lens[copied]] = '\0';
+
+        names->copies[copied] = copy;
+    }
+
+    BenchKeep (copied);
+
+    for (size_t i = 0; i < copied; i++)
+        free (names->copies[i]);
+}
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tree_ast.h"
+#include "tokenizator.h"
+#include "simd_scan.h"
+#include "lexer_dfa.h"
+#include "utils.h"
+#include "bench.h"
+
+// Throughput of scan kernels on a source: walk over whitespace and name runs,
+// counting of newlines and finding of line starts, and whole GetTokens () with one thread.
+// Kernels are chosen by build flags (see simd_scan.h), so the benchmark is built once for
+// each of them
+struct scanBench_t
+{
+    const char *fileName    = NULL;
+    sourceBuffer_t source   = {};
+    uint32_t *lineStarts    = NULL;
+
+    int error               = TREE_OK;
+};
+
+static void ScanWalk        (void *benchPtr);
+static void ScanLines       (void *benchPtr);
+static void ScanLineStarts  (void *benchPtr);
+static void ScanGetTokens   (void *benchPtr);
+
+int main (int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf (stderr, "Launch program like this: %s source_file.rap\n", argv[0]);
+
+        return 1;
+    }
+
+    scanBench_t bench = {.fileName = argv[1]};
+
+    if (SourceBufferOpen (&bench.source, argv[1]) != COMMON_ERROR_OK)
+        return 1;
+
+    bench.lineStarts = (uint32_t *) calloc (ScanCountNewLines (bench.source.data, bench.source.size) + 1,
+                                            sizeof (uint32_t));
+    if (bench.lineStarts == NULL)
+    {
+        SourceBufferClose (&bench.source);
+
+        return 1;
+    }
+
+    double megabytes = (double) bench.source.size / 1e6;
+
+    double walk       = megabytes / BenchBest (ScanWalk,       &bench);
+    double lines      = megabytes / BenchBest (ScanLines,      &bench);
+    double lineStarts = megabytes / BenchBest (ScanLineStarts, &bench);
+    double tokens     = megabytes / BenchBest (ScanGetTokens,  &bench);
+
+    free (bench.lineStarts);
+    SourceBufferClose (&bench.source);
+
+    if (bench.error != TREE_OK)
+    {
+        fprintf (stderr, "GetTokens () failed with %d on \"%s\"\n", bench.error, argv[1]);
+
+        return 1;
+    }
+
+    printf ("%-7s   %9.1f   %9.1f   %11.1f   %9.1f\n", ScanKernelsName (), walk, lines, lineStarts, tokens);
+
+    return 0;
+}
+
+// whitespace and name runs are skipped by kernels, other bytes one by one, like lexer does
+void ScanWalk (void *benchPtr)
+{
+    scanBench_t *bench = (scanBench_t *) benchPtr;
+
+    const char *data = bench->source.data;
+    size_t size      = bench->source.size;
+
+    size_t runs = 0;
+
+    for (size_t pos = 0; pos < size; )
+    {
+        unsigned char c = (unsigned char) data[pos];
+
+        if (LexerDfaIsSpace (c))
+        {
+            pos += ScanSpaces (data + pos);
+            runs++;
+        }
+        else if (LexerDfaIsNameChar (c))
+        {
+            pos += ScanName (data + pos);
+            runs++;
+        }
+        else
+        {
+            pos++;
+        }
+    }
+
+    BenchKeep (runs);
+}
+
+void ScanLines (void *benchPtr)
+{
+    scanBench_t *bench = (scanBench_t *) benchPtr;
+
+    BenchKeep (ScanCountNewLines (bench->source.data, bench->source.size));
+}
+
+void ScanLineStarts (void *benchPtr)
+{
+    scanBench_t *bench = (scanBench_t *) benchPtr;
+
+    BenchKeep (ScanNewLines (bench->source.data, bench->source.size, bench->lineStarts));
+}
+
+void ScanGetTokens (void *benchPtr)
+{
+    scanBench_t *bench = (scanBench_t *) benchPtr;
+
+    program_t program = {};
+
+    int status = ProgramCtor (&program);
+
+    if (status == TREE_OK)
+        status = GetTokens (bench->fileName, &program, 1);
+
+    if (status != TREE_OK)
+        bench->error = status;
+    else
+        BenchKeep (program.tokens.size);
+
+    ProgramDtor (&program);
+}
@@ -0,0 +1,28 @@
+#!/bin/bash
+# bench_scan.sh [statements] [indent] - throughput of scan kernels and of GetTokens () on
+# a generated program with every line indented by indent more spaces, with AVX2, SSE2
+# (if CPU has them) and scalar kernels
+
+cd "$(dirname "$0")/.." || exit 1
+
+statements=${1:-1000000}
+indent=${2:-24}
+
+for bench in bench_scan bench_scan_sse2 bench_scan_scalar; do
+    if [ ! -x "tests/bin/$bench" ]; then
+        echo "bench_scan: no tests/bin/$bench, run 'make bench_scan' in frontend/"
+        exit 1
+    fi
+done
+
+source=$(mktemp --suffix=.rap)
+trap 'rm -f "$source"' EXIT
+
+tests/gen_program.sh "$statements" | sed "s/^/$(printf "%${indent}s")/" > "$source"
+
+echo "$(($(wc -c < "$source") / 1000000)) MB source, $indent more spaces of indentation, MB/s"
+echo "kernels        walk    newlines   line starts   GetTokens"
+
+for bench in bench_scan bench_scan_sse2 bench_scan_scalar; do
+    "tests/bin/$bench" "$source" || exit 1
+done
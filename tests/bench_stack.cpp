@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "stack.h"
+#include "dynamic_array.h"
+#include "bench.h"
+
+// Push and pop throughput of stack_t with N elements. Checks depend on build flags (see stack.h),
+// so the benchmark is built once for each of them. Full verify is O(capacity) per operation,
+// so it's run with fewer operations
+#if defined (STACK_FULL_VERIFY) && defined (PRINT_DEBUG) && !defined (STACK_RELEASE)
+const char kStackMode[] = "full verify";
+#elif defined (PRINT_DEBUG) && !defined (STACK_RELEASE)
+const char kStackMode[] = "amortized";
+#else
+const char kStackMode[] = "release";
+#endif
+
+struct stackBench_t
+{
+    size_t elements     = 0;
+    size_t rounds       = 0;    // elements are pushed and popped in every round
+    int error           = STACK_OK;
+};
+
+static void StackPushPop (void *benchPtr);
+
+int main (int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf (stderr, "Launch program like this: %s max_elements operations\n", argv[0]);
+
+        return 1;
+    }
+
+    size_t maxElements = strtoul (argv[1], NULL, 10);
+    size_t operations  = strtoul (argv[2], NULL, 10);
+
+    for (size_t elements = 10; elements <= maxElements; elements *= 10)
+    {
+        stackBench_t bench = {.elements = elements,
+                              .rounds   = (operations / 2 + elements - 1) / elements};
+
+        double seconds = BenchBest (StackPushPop, &bench);
+
+        if (bench.error != STACK_OK)
+        {
+            StackPrintError (bench.error);
+
+            return 1;
+        }
+
+        printf ("%-11s   %9lu   %10.1f\n", kStackMode, elements,
+                seconds / (double) (2 * bench.rounds * elements) * 1e9);
+    }
+
+    return 0;
+}
+
+void StackPushPop (void *benchPtr)
+{
+    stackBench_t *bench = (stackBench_t *) benchPtr;
+
+    stack_t stack = {};
+
+    bench->error = STACK_CREATE (stack, kDynamicArrayMinCapacity);
+
+    uint64_t sum = 0;
+
+    for (size_t round = 0; round < bench->rounds && bench->error == STACK_OK; round++)
+    {
+        for (size_t i = 0; i < bench->elements && bench->error == STACK_OK; i++)
+            bench->error = StackPush (&stack, i);
+
+        for (size_t i = 0; i < bench->elements && bench->error == STACK_OK; i++)
+        {
+            stackDataType value = 0;
+
+            bench->error = StackPop (&stack, &value);
+            sum += value;
+        }
+    }
+
+    BenchKeep (sum);
+
+    StackDtor (&stack);
+}
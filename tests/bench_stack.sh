@@ -0,0 +1,23 @@
+#!/bin/bash
+# bench_stack.sh [max elements] [operations] - push and pop time of stack_t without checks,
+# with amortized checks of debug build and with full verify on every operation
+
+cd "$(dirname "$0")/.." || exit 1
+
+maxElements=${1:-1000000}
+operations=${2:-20000000}
+
+for bench in bench_stack bench_stack_checked bench_stack_full; do
+    if [ ! -x "tests/bin/$bench" ]; then
+        echo "bench_stack: no tests/bin/$bench, run 'make bench_stack' in frontend/"
+        exit 1
+    fi
+done
+
+echo "mode           elements   ns per op"
+
+tests/bin/bench_stack         "$maxElements" "$operations" || exit 1
+tests/bin/bench_stack_checked "$maxElements" "$operations" || exit 1
+
+# O(elements) per operation
+tests/bin/bench_stack_full $((maxElements < 10000 ? maxElements : 10000)) $((operations / 100))
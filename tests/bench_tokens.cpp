@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tree_ast.h"
+#include "tokenizator.h"
+#include "dynamic_array.h"
+#include "bench.h"
+
+// Token append throughput: tokens of structs, as they were before, in array grown by hand
+// and in dynamicArray_t, against structure of arrays tokensArray_t. Every one of them is
+// filled with capacity hint (lexer reserves tokens by source size) and without it
+const size_t kDefaultTokensCount = 1 << 22;
+
+// token before structure of arrays
+struct tokenStruct_t
+{
+    type_t type     = TYPE_UKNOWN;
+    value_t value   = {.idx = KEY_UKNOWN};
+
+    size_t line     = 1;
+    size_t position = 1;
+};
+
+struct tokensBench_t
+{
+    size_t count    = 0;
+    bool isHinted   = false;
+
+    size_t bytes    = 0;    // memory of filled array
+    int error       = TREE_OK;
+};
+
+static void AppendByHand        (void *benchPtr);
+static void AppendDynamicArray  (void *benchPtr);
+static void AppendTokensArray   (void *benchPtr);
+
+static type_t  TokenTypeOf  (size_t tokenIdx);
+static value_t TokenValueOf (size_t tokenIdx);
+
+int main (int argc, char **argv)
+{
+    size_t count = (argc > 1) ? strtoul (argv[1], NULL, 10) : kDefaultTokensCount;
+
+    struct
+    {
+        const char *name;
+        benchTask_t task;
+    } kContainers[] =
+    {
+        {"structs, grown by hand",  AppendByHand},
+        {"structs, dynamicArray_t", AppendDynamicArray},
+        {"tokensArray_t",           AppendTokensArray},
+    };
+
+    printf ("%lu tokens\n", count);
+    printf ("container                 hint   ns per token   bytes per token\n");
+
+    for (size_t i = 0; i < sizeof (kContainers) / sizeof (kContainers[0]); i++)
+    {
+        for (int isHinted = 0; isHinted <= 1; isHinted++)
+        {
+            tokensBench_t bench = {.count = count, .isHinted = (bool) isHinted};
+
+            double seconds = BenchBest (kContainers[i].task, &bench);
+
+            if (bench.error != TREE_OK)
+            {
+                fprintf (stderr, "Appending tokens failed with %d\n", bench.error);
+
+                return 1;
+            }
+
+            printf ("%-24s   %3s   %12.2f   %15.1f\n", kContainers[i].name, isHinted ? "yes" : "no",
+                    seconds / (double) count * 1e9, (double) bench.bytes / (double) count);
+        }
+    }
+
+    return 0;
+}
+
+// like CheckForReallocTokens () did
+void AppendByHand (void *benchPtr)
+{
+    tokensBench_t *bench = (tokensBench_t *) benchPtr;
+
+    size_t capacity = bench->isHinted ? bench->count : 16;
+    size_t size     = 0;
+
+    tokenStruct_t *tokens = (tokenStruct_t *) calloc (capacity, sizeof (tokenStruct_t));
+
+    for (size_t i = 0; i < bench->count && tokens != NULL; i++)
+    {
+        if (size == capacity)
+        {
+            capacity *= 2;
+
+            tokenStruct_t *newTokens = (tokenStruct_t *) realloc (tokens, capacity * sizeof (tokenStruct_t));
+            if (newTokens == NULL)
+            {
+                free (tokens);
+                tokens = NULL;
+
+                break;
+            }
+
+            tokens = newTokens;
+        }
+
+        tokens[size] = {.type = TokenTypeOf (i), .value = TokenValueOf (i), .line = i / 8, .position = i % 8};
+        size++;
+    }
+
+    if (tokens == NULL)
+        bench->error = TREE_ERROR_COMMON | COMMON_ERROR_ALLOCATING_MEMORY;
+    else
+        BenchKeep (tokens[size - 1].value.idx);
+
+    bench->bytes = capacity * sizeof (tokenStruct_t);
+
+    free (tokens);
+}
+
+void AppendDynamicArray (void *benchPtr)
+{
+    tokensBench_t *bench = (tokensBench_t *) benchPtr;
+
+    dynamicArray_t <tokenStruct_t> tokens = {};
+
+    int status = DynamicArrayCtor (&tokens, bench->isHinted ? bench->count : 0);
+
+    for (size_t i = 0; i < bench->count && status == COMMON_ERROR_OK; i++)
+    {
+        tokenStruct_t *token = NULL;
+
+        status = DynamicArrayAppend (&tokens, &token);
+
+        if (status == COMMON_ERROR_OK)
+            *token = {.type = TokenTypeOf (i), .value = TokenValueOf (i), .line = i / 8, .position = i % 8};
+    }
+
+    if (status != COMMON_ERROR_OK)
+        bench->error = TREE_ERROR_COMMON | status;
+    else
+        BenchKeep (tokens.data[tokens.size - 1].value.idx);
+
+    bench->bytes = tokens.capacity * sizeof (tokenStruct_t);
+
+    DynamicArrayDtor (&tokens);
+}
+
+// line and column aren't stored, they're found by offset
+void AppendTokensArray (void *benchPtr)
+{
+    tokensBench_t *bench = (tokensBench_t *) benchPtr;
+
+    tokensArray_t tokens = {};
+
+    int status = TokensArrayCtor (&tokens);
+
+    if (status == TREE_OK && bench->isHinted)
+        status = TokensArrayReserve (&tokens, bench->count);
+
+    for (size_t i = 0; i < bench->count && status == TREE_OK; i++)
+        status = TokenAdd (&tokens, TokenTypeOf (i), TokenValueOf (i), (uint32_t) (i * 4));
+
+    if (status != TREE_OK)
+        bench->error = status;
+    else
+        BenchKeep (tokens.payloads[tokens.size - 1]);
+
+    bench->bytes = tokens.capacity * (sizeof (tokens.kinds[0]) + sizeof (tokens.payloads[0]) +
+                                      sizeof (tokens.offsets[0]));
+
+    TokensArrayDtor (&tokens);
+}
+
+// keywords, names and numbers, as in programs
+type_t TokenTypeOf (size_t tokenIdx)
+{
+    static const type_t kTypes[] = {TYPE_NAME, TYPE_KEYWORD, TYPE_CONST_NUM, TYPE_KEYWORD};
+
+    return kTypes[tokenIdx % (sizeof (kTypes) / sizeof (kTypes[0]))];
+}
+
+value_t TokenValueOf (size_t tokenIdx)
+{
+    return {.idx = tokenIdx % 1000};
+}
@@ -0,0 +1,54 @@
+# Sourced by checks in tests/ from the repo root. Sets $root, $frontend and $work,
+# a temporary directory that is removed on exit
+
+root=$(pwd)
+frontend=${FRONTEND:-$root/frontend/frontend_release}
+
+if [ ! -x "$frontend" ]; then
+    echo "$(basename "$0"): no $frontend, run 'make release' in frontend/"
+    exit 1
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+mkdir -p "$work/run/ast_forest" "$work/sources" "$work/out"
+
+runs=0
+failed=0
+
+# run_frontend <out prefix> <source> <options> - keeps exit code, .ast and error positions
+run_frontend ()
+{
+    local out=$1
+    local source=$2
+    shift 2
+
+    rm -f "$work/run/ast_forest/tree.ast"
+
+    (cd "$work/run" && "$frontend" "$@" "$source" > /dev/null 2> "$out.err")
+    echo $? > "$out.rc"
+
+    grep -ao "$(basename "$source"):[0-9]*:[0-9]*" "$out.err" > "$out.pos"
+
+    if [ -f "$work/run/ast_forest/tree.ast" ]; then
+        mv "$work/run/ast_forest/tree.ast" "$out.ast"
+    else
+        : > "$out.ast"
+    fi
+}
+
+# compare_runs <reference prefix> <out prefix> <what is run> - counts mismatches in $failed
+compare_runs ()
+{
+    runs=$((runs + 1))
+
+    for what in rc ast pos; do
+        if ! cmp -s "$1.$what" "$2.$what"; then
+            echo "FAIL $3: $what differs"
+            failed=$((failed + 1))
+        fi
+    done
+
+    rm -f "$2".*
+}
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tree.h"
+#include "tree_ast.h"
+#include "tree_compact.h"
+#include "tokenizator.h"
+#include "tree_load_infix.h"
+
+// Tree, that is copied to compact form, must be saved the same by CompactTreeSaveToFile (),
+// and must be the same, when it's copied back: in plain and DAG mode, simplified or not
+static const simplifyLevel_t kLevels[] = {SIMPLIFY_NONE, SIMPLIFY_EXPRESSIONS, SIMPLIFY_STATEMENTS};
+
+const size_t kPathLen = 256;
+
+static int CheckRoundTrip   (const char *workDir, const char *fileName, bool isShared, simplifyLevel_t level);
+static int RoundTrip        (program_t *program, const char *treeFile, const char *compactFile,
+                             const char *backFile);
+static bool AreFilesEqual   (const char *firstFile, const char *secondFile);
+
+int main (int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf (stderr, "Launch program like this: %s work_dir source_file.rap...\n", argv[0]);
+
+        return 1;
+    }
+
+    size_t failed = 0;
+    size_t cases  = 0;
+
+    for (int file = 2; file < argc; file++)
+    {
+        for (int isShared = 0; isShared <= 1; isShared++)
+        {
+            for (size_t i = 0; i < sizeof (kLevels) / sizeof (kLevels[0]); i++)
+            {
+                cases++;
+
+                if (CheckRoundTrip (argv[1], argv[file], isShared, kLevels[i]) != 0)
+                    failed++;
+            }
+        }
+    }
+
+    printf ("compact_roundtrip: %lu cases, %lu failed\n", cases, failed);
+
+    return (failed == 0) ? 0 : 1;
+}
+
+int CheckRoundTrip (const char *workDir, const char *fileName, bool isShared, simplifyLevel_t level)
+{
+    char treeFile    [kPathLen] = {};
+    char compactFile [kPathLen] = {};
+    char backFile    [kPathLen] = {};
+
+    snprintf (treeFile,    kPathLen, "%s/tree.ast",    workDir);
+    snprintf (compactFile, kPathLen, "%s/compact.ast", workDir);
+    snprintf (backFile,    kPathLen, "%s/back.ast",    workDir);
+
+    program_t program = {};
+
+    if (ProgramCtor (&program) != TREE_OK)
+        return 1;
+
+    program.ast.isShared = isShared;
+
+    int status = GetTokens (fileName, &program, 1);
+
+    if (status == TREE_OK)
+        status = TreeLoadInfixFromTokens (&program);
+
+    if (status == TREE_OK)
+        status = TreeSimplify (&program, &program.ast, level);
+
+    if (status == TREE_OK)
+        status = RoundTrip (&program, treeFile, compactFile, backFile);
+
+    ProgramDtor (&program);
+
+    const char *mode = isShared ? "-c " : "";
+
+    if (status != TREE_OK)
+    {
+        printf ("FAIL %s-O%d %s: failed with %d\n", mode, level, fileName, status);
+
+        return 1;
+    }
+
+    int error = 0;
+
+    if (!AreFilesEqual (treeFile, compactFile))
+    {
+        printf ("FAIL %s-O%d %s: compact tree is saved differently\n", mode, level, fileName);
+        error = 1;
+    }
+
+    if (!AreFilesEqual (treeFile, backFile))
+    {
+        printf ("FAIL %s-O%d %s: tree isn't the same after compact tree\n", mode, level, fileName);
+        error = 1;
+    }
+
+    return error;
+}
+
+// tree -> compact -> tree, each of them is saved
+int RoundTrip (program_t *program, const char *treeFile, const char *compactFile, const char *backFile)
+{
+    TREE_DO_AND_RETURN (TreeAstSaveToFile (program, treeFile));
+
+    compactTree_t compact = {};
+
+    int status = CompactTreeCtor (&compact, program->ast.size);
+
+    if (status == TREE_OK)
+        status = CompactTreeFromTree (&compact, &program->ast);
+
+    if (status == TREE_OK)
+        status = CompactTreeVerify (&compact);
+
+    if (status == TREE_OK)
+        status = CompactTreeSaveToFile (program, &compact, compactFile);
+
+    // tree is filled again in the same mode
+    TreeDtor (&program->ast);
+
+    if (status == TREE_OK)
+        status = CompactTreeToTree (&compact, &program->ast);
+
+    CompactTreeDtor (&compact);
+
+    if (status == TREE_OK)
+        status = TreeAstSaveToFile (program, backFile);
+
+    return status;
+}
+
+bool AreFilesEqual (const char *firstFile, const char *secondFile)
+{
+    FILE *first  = fopen (firstFile,  "rb");
+    FILE *second = fopen (secondFile, "rb");
+
+    bool isEqual = (first != NULL && second != NULL);
+
+    while (isEqual)
+    {
+        int firstChar  = fgetc (first);
+        int secondChar = fgetc (second);
+
+        if (firstChar != secondChar)
+            isEqual = false;
+
+        if (firstChar == EOF)
+            break;
+    }
+
+    if (first  != NULL) fclose (first);
+    if (second != NULL) fclose (second);
+
+    return isEqual;
+}
@@ -0,0 +1,28 @@
+#!/bin/bash
+# compact_roundtrip.sh - tree of every program is copied to compact form and back: compact
+# tree must be saved the same as the tree, and the copied back tree must be the same too.
+# Programs are rap_sources, that frontend accepts, generated one and deep ones, in plain and
+# DAG mode, -O0..-O2
+
+cd "$(dirname "$0")/.." || exit 1
+
+. tests/common.sh
+
+if [ ! -x tests/bin/compact_roundtrip ]; then
+    echo "compact_roundtrip: no tests/bin/compact_roundtrip, run 'make compact_roundtrip' in frontend/"
+    exit 1
+fi
+
+for source in $(find "$root/rap_sources" -name '*.rap' | sort); do
+    run_frontend "$work/out/source" "$source"
+
+    [ "$(cat "$work/out/source.rc")" = 0 ] && cp "$source" "$work/sources/$(basename "$source")"
+done
+
+tests/gen_program.sh 3000 > "$work/sources/program.rap"
+
+for kind in blocks ifs powers parens; do
+    tests/gen_deep.sh "$kind" 1000 > "$work/sources/$kind.rap"
+done
+
+tests/bin/compact_roundtrip "$work/out" "$work"/sources/*.rap
@@ -0,0 +1,71 @@
+#!/bin/bash
+# deep_programs.sh - parser and tree walks keep pending nodes on explicit stacks, so 10^6
+# statements in one function, 10^5 nested blocks or ifs, and expressions of 3*10^5 right
+# associative powers or nested parentheses must go through frontend and backend. With small
+# depth budget (-d1000) frontend must stop on nested ones with the budget error, not crash.
+# Statements of one block are an array, so they don't count in depth. Backend has no
+# instruction for '^', so powers are only parsed
+
+cd "$(dirname "$0")/.." || exit 1
+
+. tests/common.sh
+
+backend=${BACKEND:-$root/backend/backend_release}
+
+if [ ! -x "$backend" ]; then
+    echo "deep_programs: no $backend, run 'make release' in backend/"
+    exit 1
+fi
+
+# backend writes asm relative to the directory it's run from
+asm="$work/processor/asm/my_asm/lang_auto_compiled.my_asm"
+mkdir -p "$(dirname "$asm")"
+
+# check <what is run> <condition> - counts failed conditions in $failed
+check ()
+{
+    runs=$((runs + 1))
+
+    if ! eval "$2"; then
+        echo "FAIL $1: $2"
+        failed=$((failed + 1))
+    fi
+}
+
+for kind in statements blocks ifs powers parens; do
+    case "$kind" in
+        statements)     count=1000000 ;;
+        powers|parens)  count=300000  ;;
+        *)              count=100000  ;;
+    esac
+
+    source="$work/sources/$kind.rap"
+    tests/gen_deep.sh "$kind" "$count" > "$source"
+
+    run_frontend "$work/out/$kind" "$source"
+    check "frontend $kind $count" '[ "$(cat "$work/out/$kind.rc")" = 0 ]'
+
+    if [ "$kind" != powers ]; then
+        rm -f "$asm"
+        (cd "$work/run" && "$backend" "$work/out/$kind.ast" > /dev/null 2> "$work/out/$kind.backend.err")
+        backendRc=$?
+        check "backend $kind $count" '[ "$backendRc" = 0 ] && [ -s "$asm" ]'
+    fi
+
+    run_frontend "$work/out/$kind.d1000" "$source" -d1000
+
+    if [ "$kind" = statements ]; then
+        # every statement adds its number to v
+        check "asm of $kind $count" '[ "$(grep -c "^ADD" "$asm")" = "$count" ]'
+        check "frontend -d1000 $kind $count" 'cmp -s "$work/out/$kind.ast" "$work/out/$kind.d1000.ast"'
+    else
+        check "frontend -d1000 $kind $count" '[ "$(cat "$work/out/$kind.d1000.rc")" = 1 ] &&
+                                              grep -aq "deeper than depth budget (1000)" "$work/out/$kind.d1000.err"'
+    fi
+
+    rm -f "$work/out/$kind".*
+done
+
+echo "deep_programs: $runs checks, $failed failed"
+
+[ "$failed" -eq 0 ]
@@ -0,0 +1,481 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "tree.h"
+#include "tree_ast.h"
+#include "tokenizator.h"
+#include "tree_load_infix.h"
+
+// Random edits are applied to program by GetTokensAfterEdit () and TreeLoadInfixAfterEdit (),
+// after each of them the edited source is lexed and parsed from scratch. Tokens, line starts,
+// saved tree and what failed (lexing or parsing) must be the same. Edits break the program
+// as often as they keep it right, and a half of them undo older ones to make it right again
+const size_t kEditsPerSource    = 400;
+const size_t kUndoDepth         = 16;
+const size_t kPathLen           = 256;
+
+static const char *kSnippets[] =
+{
+    "    v0 стал v0 фит 7 тррря\n",
+    "    v99 представься 5 тррря\n",
+    "    панчлайн v0 тррря\n",
+    " фит 1", " хайп (v0 антихайп 2)", "\n", " ", "\t\n\n",
+    "пошумим\n", "воу\n", "тррря", "v0", "v12345", "(", ")", "42", "@",
+    "раунд g()\nпошумим\n    лучше_я_сдохну_чем_стану 0\nвоу\n\n",
+};
+
+// bytes [begin, end) are replaced by text
+struct edit_t
+{
+    size_t begin    = 0;
+    size_t end      = 0;
+
+    char *text      = NULL;
+    size_t textLen  = 0;
+};
+
+struct text_t
+{
+    char *data  = NULL;
+    size_t size = 0;
+};
+
+enum editResult_t
+{
+    EDIT_OK,
+    EDIT_LEXING_FAILED,
+    EDIT_PARSING_FAILED,
+};
+
+static int CheckSource          (const char *workDir, const char *fileName, uint64_t seed, size_t *cases);
+static int CheckEdit            (const char *workDir, program_t *edited, editResult_t result,
+                                 const text_t *text, const char **what);
+static editResult_t ApplyEdit   (program_t *program, const edit_t *edit);
+static editResult_t LoadProgram (program_t *program, const char *fileName);
+
+static bool MakeEdit            (const text_t *text, uint64_t *seed, edit_t *edit);
+static bool MakeUndo            (const text_t *text, const edit_t *edit, edit_t *undo);
+static bool TextEdit            (text_t *text, const edit_t *edit);
+static bool EditSetText         (edit_t *edit, const char *text, size_t textLen);
+
+static bool IsUtf8Continuation  (char byte);
+static bool AreTokensEqual      (program_t *edited, program_t *fresh);
+static bool AreFilesEqual       (const char *firstFile, const char *secondFile);
+static uint64_t NextRandom      (uint64_t *seed);
+
+int main (int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf (stderr, "Launch program like this: %s work_dir source_file.rap...\n", argv[0]);
+
+        return 1;
+    }
+
+    size_t failed = 0;
+    size_t cases  = 0;
+
+    for (int file = 2; file < argc; file++)
+    {
+        if (CheckSource (argv[1], argv[file], (uint64_t) file * 0x9E3779B97F4A7C15, &cases) != 0)
+            failed++;
+    }
+
+    printf ("edit_incremental: %lu cases, %lu failed\n", cases, failed);
+
+    return (failed == 0) ? 0 : 1;
+}
+
+// Source is edited until the first mismatch, after it program isn't the same as the fresh one
+int CheckSource (const char *workDir, const char *fileName, uint64_t seed, size_t *cases)
+{
+    program_t edited = {};
+
+    if (LoadProgram (&edited, fileName) != EDIT_OK)
+    {
+        printf ("FAIL %s: source isn't loaded\n", fileName);
+        ProgramDtor (&edited);
+
+        return 1;
+    }
+
+    text_t text = {};
+
+    text.size = edited.source.size;
+    text.data = (char *) calloc (text.size + 1, sizeof (char));
+    if (text.data == NULL)
+    {
+        ProgramDtor (&edited);
+
+        return 1;
+    }
+
+    memcpy (text.data, edited.source.data, text.size);
+
+    edit_t undos [kUndoDepth] = {};
+    size_t undosCount = 0;
+
+    int error = 0;
+
+    for (size_t editIdx = 0; editIdx < kEditsPerSource && error == 0; editIdx++)
+    {
+        edit_t edit = {};
+        edit_t undo = {};
+
+        // program is never more than kUndoDepth edits away from the right one
+        bool isUndo = (undosCount == kUndoDepth || (undosCount > 0 && NextRandom (&seed) % 2 == 0));
+
+        if (isUndo)
+            edit = undos[--undosCount];
+        else if (!MakeEdit (&text, &seed, &edit))
+            error = 1;
+
+        if (error == 0 && !isUndo && !MakeUndo (&text, &edit, &undo))
+            error = 1;
+
+        if (error == 0 && !TextEdit (&text, &edit))
+            error = 1;
+
+        if (error == 0)
+        {
+            (*cases)++;
+
+            editResult_t result = ApplyEdit (&edited, &edit);
+            const char *what    = NULL;
+
+            error = CheckEdit (workDir, &edited, result, &text, &what);
+
+            if (error != 0)
+                printf ("FAIL %s: edit %lu [%lu, %lu) -> \"%.*s\": %s\n", fileName, editIdx,
+                        edit.begin, edit.end, (int) edit.textLen, edit.text, what);
+        }
+
+        if (error == 0 && !isUndo)
+            undos[undosCount++] = undo;
+        else
+            free (undo.text);
+
+        free (edit.text);
+    }
+
+    for (size_t i = 0; i < undosCount; i++)
+        free (undos[i].text);
+
+    free (text.data);
+    ProgramDtor (&edited);
+
+    return error;
+}
+
+// the same text is lexed and parsed from scratch
+int CheckEdit (const char *workDir, program_t *edited, editResult_t result, const text_t *text,
+               const char **what)
+{
+    char sourceFile [kPathLen] = {};
+    char editedFile [kPathLen] = {};
+    char freshFile  [kPathLen] = {};
+
+    snprintf (sourceFile, kPathLen, "%s/edited.rap", workDir);
+    snprintf (editedFile, kPathLen, "%s/edited.ast", workDir);
+    snprintf (freshFile,  kPathLen, "%s/fresh.ast",  workDir);
+
+    if (edited->source.size != text->size || memcmp (edited->source.data, text->data, text->size) != 0)
+    {
+        *what = "source is edited wrong";
+
+        return 1;
+    }
+
+    FILE *file = fopen (sourceFile, "wb");
+    if (file == NULL)
+    {
+        *what = "edited source isn't saved";
+
+        return 1;
+    }
+
+    fwrite (text->data, sizeof (char), text->size, file);
+    fclose (file);
+
+    program_t fresh = {};
+
+    editResult_t freshResult = LoadProgram (&fresh, sourceFile);
+
+    int error = 0;
+
+    if (result != freshResult)
+    {
+        *what = (freshResult == EDIT_OK)             ? "edit failed, fresh program is loaded" :
+                (freshResult == EDIT_LEXING_FAILED)  ? "fresh program isn't lexed" :
+                                                       "fresh program isn't parsed";
+        error = 1;
+    }
+    else if (result != EDIT_LEXING_FAILED && !AreTokensEqual (edited, &fresh))
+    {
+        *what  = "tokens differ";
+        error  = 1;
+    }
+    else if (result == EDIT_OK &&
+             (TreeAstSaveToFile (edited, editedFile) != TREE_OK ||
+              TreeAstSaveToFile (&fresh, freshFile)  != TREE_OK ||
+              !AreFilesEqual (editedFile, freshFile)))
+    {
+        *what  = "trees differ";
+        error  = 1;
+    }
+
+    ProgramDtor (&fresh);
+
+    return error;
+}
+
+editResult_t ApplyEdit (program_t *program, const edit_t *edit)
+{
+    sourceEdit_t sourceEdit = {.begin   = edit->begin,
+                               .end     = edit->end,
+                               .text    = edit->text,
+                               .textLen = edit->textLen};
+    tokensEdit_t tokensEdit = {};
+
+    if (GetTokensAfterEdit (program, &sourceEdit, &tokensEdit) != TREE_OK)
+        return EDIT_LEXING_FAILED;
+
+    if (TreeLoadInfixAfterEdit (program, &tokensEdit) != TREE_OK)
+        return EDIT_PARSING_FAILED;
+
+    return EDIT_OK;
+}
+
+editResult_t LoadProgram (program_t *program, const char *fileName)
+{
+    if (ProgramCtor (program) != TREE_OK || GetTokens (fileName, program, 1) != TREE_OK)
+        return EDIT_LEXING_FAILED;
+
+    if (TreeLoadInfixFromTokens (program) != TREE_OK)
+        return EDIT_PARSING_FAILED;
+
+    return EDIT_OK;
+}
+
+bool MakeEdit (const text_t *text, uint64_t *seed, edit_t *edit)
+{
+    size_t pos = NextRandom (seed) % (text->size + 1);
+
+    size_t lineBegin = pos;
+    while (lineBegin > 0 && text->data[lineBegin - 1] != '\n')
+        lineBegin--;
+
+    size_t lineEnd = pos;
+    while (lineEnd < text->size && text->data[lineEnd++] != '\n')
+        ;
+
+    edit->begin = pos;
+    edit->end   = pos;
+
+    switch (NextRandom (seed) % 6)
+    {
+        // another number
+        case 0:
+        {
+            while (edit->begin < text->size && (text->data[edit->begin] < '0' || text->data[edit->begin] > '9'))
+                edit->begin++;
+
+            edit->end = edit->begin;
+            while (edit->end < text->size && text->data[edit->end] >= '0' && text->data[edit->end] <= '9')
+                edit->end++;
+
+            char number [32] = {};
+            int numberLen = snprintf (number, sizeof (number), "%lu", NextRandom (seed) % 100000);
+
+            return EditSetText (edit, number, (size_t) numberLen);
+        }
+
+        // snippet at line beginning or at whitespace
+        case 1:
+        {
+            const char *snippet = kSnippets[NextRandom (seed) % (sizeof (kSnippets) / sizeof (kSnippets[0]))];
+
+            if (snippet[strlen (snippet) - 1] == '\n')
+                edit->begin = lineBegin;
+            else
+                while (edit->begin < text->size && text->data[edit->begin] != ' ' && text->data[edit->begin] != '\n')
+                    edit->begin++;
+
+            edit->end = edit->begin;
+
+            return EditSetText (edit, snippet, strlen (snippet));
+        }
+
+        // a few characters, '@' snippet makes lexical errors
+        case 2:
+            edit->end = pos + NextRandom (seed) % 16;
+            if (edit->end > text->size)
+                edit->end = text->size;
+
+            while (edit->begin > 0 && IsUtf8Continuation (text->data[edit->begin]))
+                edit->begin--;
+
+            while (edit->end < text->size && IsUtf8Continuation (text->data[edit->end]))
+                edit->end++;
+
+            return EditSetText (edit, "", 0);
+
+        // the same line again
+        case 3:
+            edit->begin = lineBegin;
+            edit->end   = lineBegin;
+
+            return EditSetText (edit, text->data + lineBegin, lineEnd - lineBegin);
+
+        case 4:
+            edit->begin = lineBegin;
+            edit->end   = lineEnd;
+
+            return EditSetText (edit, "", 0);
+
+        // whitespace is changed, tokens aren't
+        case 5:
+        {
+            while (edit->begin < text->size && !isspace ((unsigned char) text->data[edit->begin]))
+                edit->begin++;
+
+            edit->end = edit->begin;
+            while (edit->end < text->size && isspace ((unsigned char) text->data[edit->end]))
+                edit->end++;
+
+            const char *spaces = (NextRandom (seed) % 2 == 0) ? "\n\n    " : " \t ";
+
+            return EditSetText (edit, spaces, (edit->begin == edit->end) ? 0 : strlen (spaces));
+        }
+
+        default:
+            return false;
+    }
+}
+
+// undo of edit, that isn't applied yet
+bool MakeUndo (const text_t *text, const edit_t *edit, edit_t *undo)
+{
+    undo->begin = edit->begin;
+    undo->end   = edit->begin + edit->textLen;
+
+    return EditSetText (undo, text->data + edit->begin, edit->end - edit->begin);
+}
+
+bool TextEdit (text_t *text, const edit_t *edit)
+{
+    size_t newSize = text->size - (edit->end - edit->begin) + edit->textLen;
+
+    char *data = text->data;
+
+    // tail is moved first, buffer is only grown
+    if (newSize > text->size)
+    {
+        data = (char *) realloc (text->data, newSize + 1);
+        if (data == NULL)
+            return false;
+    }
+
+    memmove (data + edit->begin + edit->textLen, data + edit->end, text->size - edit->end);
+    memcpy  (data + edit->begin, edit->text, edit->textLen);
+
+    data[newSize] = '\0';
+
+    text->data = data;
+    text->size = newSize;
+
+    return true;
+}
+
+// text is copied, it mustn't be in the source itself
+bool EditSetText (edit_t *edit, const char *text, size_t textLen)
+{
+    edit->text = (char *) calloc (textLen + 1, sizeof (char));
+    if (edit->text == NULL)
+        return false;
+
+    memcpy (edit->text, text, textLen);
+    edit->textLen = textLen;
+
+    return true;
+}
+
+bool IsUtf8Continuation (char byte)
+{
+    return ((unsigned char) byte & 0xC0) == 0x80;
+}
+
+// names are compared by strings: edited program keeps ids of old names and adds new ones
+bool AreTokensEqual (program_t *edited, program_t *fresh)
+{
+    tokensArray_t *first  = &edited->tokens;
+    tokensArray_t *second = &fresh->tokens;
+
+    if (first->size != second->size || first->lineStarts.size != second->lineStarts.size)
+        return false;
+
+    if (memcmp (first->lineStarts.data, second->lineStarts.data,
+                first->lineStarts.size * sizeof (first->lineStarts.data[0])) != 0)
+        return false;
+
+    for (size_t i = 0; i < first->size; i++)
+    {
+        if (first->kinds[i] != second->kinds[i] || first->offsets[i] != second->offsets[i])
+            return false;
+
+        if (first->kinds[i] != TYPE_NAME)
+        {
+            if (first->payloads[i] != second->payloads[i])
+                return false;
+
+            continue;
+        }
+
+        const name_t *firstName  = NamesTableFindByIdx (&edited->namesTable, first->payloads[i]);
+        const name_t *secondName = NamesTableFindByIdx (&fresh->namesTable,  second->payloads[i]);
+
+        if (firstName == NULL || secondName == NULL || firstName->len != secondName->len ||
+            memcmp (firstName->name, secondName->name, firstName->len) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+bool AreFilesEqual (const char *firstFile, const char *secondFile)
+{
+    FILE *first  = fopen (firstFile,  "rb");
+    FILE *second = fopen (secondFile, "rb");
+
+    bool isEqual = (first != NULL && second != NULL);
+
+    while (isEqual)
+    {
+        int firstChar  = fgetc (first);
+        int secondChar = fgetc (second);
+
+        if (firstChar != secondChar)
+            isEqual = false;
+
+        if (firstChar == EOF)
+            break;
+    }
+
+    if (first  != NULL) fclose (first);
+    if (second != NULL) fclose (second);
+
+    return isEqual;
+}
+
+// xorshift, so that edits are the same on every run
+uint64_t NextRandom (uint64_t *seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+
+    return *seed;
+}
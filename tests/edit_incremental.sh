@@ -0,0 +1,30 @@
+#!/bin/bash
+# edit_incremental.sh - random edits are applied to programs by GetTokensAfterEdit () and
+# TreeLoadInfixAfterEdit (), after each one the edited source is lexed and parsed from scratch,
+# and the results are compared. Programs are rap_sources, that frontend accepts, generated
+# ones with one and many functions and deep ones
+
+cd "$(dirname "$0")/.." || exit 1
+
+. tests/common.sh
+
+if [ ! -x tests/bin/edit_incremental ]; then
+    echo "edit_incremental: no tests/bin/edit_incremental, run 'make edit_incremental' in frontend/"
+    exit 1
+fi
+
+for source in $(find "$root/rap_sources" -name '*.rap' | sort); do
+    run_frontend "$work/out/source" "$source"
+
+    [ "$(cat "$work/out/source.rc")" = 0 ] && cp "$source" "$work/sources/$(basename "$source")"
+done
+
+tests/gen_program.sh 300 > "$work/sources/program.rap"
+tests/gen_program.sh 600 6 > "$work/sources/functions.rap"
+
+for kind in blocks ifs parens; do
+    tests/gen_deep.sh "$kind" 100 > "$work/sources/$kind.rap"
+done
+
+# syntax errors of edited programs are expected
+tests/bin/edit_incremental "$work/out" "$work"/sources/*.rap 2> /dev/null
@@ -0,0 +1,73 @@
+#!/bin/bash
+# gen_deep.sh <statements|blocks|ifs|powers|parens> <N> - prints rap program, which is deep
+# for the parser and tree walks: N statements in one function, N nested blocks or ifs around
+# one statement, or expression of N right associative powers or in N nested parentheses
+
+kind=${1:?"usage: gen_deep.sh <statements|blocks|ifs|powers|parens> <N>"}
+count=${2:?"usage: gen_deep.sh <statements|blocks|ifs|powers|parens> <N>"}
+
+awk -v kind="$kind" -v count="$count" 'BEGIN {
+    print "раунд f()"
+    print "пошумим"
+    print "    v представься 1 тррря"
+
+    if (kind == "statements")
+    {
+        for (i = 0; i < count; i++)
+            printf "    v стал v фит %d тррря\n", i % 1000
+    }
+    else if (kind == "blocks")
+    {
+        for (i = 0; i < count; i++)
+            print "пошумим"
+
+        print "v стал v фит 1 тррря"
+
+        for (i = 0; i < count; i++)
+            print "воу"
+    }
+    else if (kind == "ifs")
+    {
+        for (i = 0; i < count; i++)
+            print "биф (v)"
+
+        print "v стал v фит 1 тррря"
+    }
+    else if (kind == "powers")
+    {
+        printf "    v стал v"
+
+        for (i = 0; i < count; i++)
+            printf " TODO 1"
+
+        print " тррря"
+    }
+    else if (kind == "parens")
+    {
+        printf "    v стал "
+
+        for (i = 0; i < count; i++)
+            printf "("
+
+        printf "v фит 1"
+
+        for (i = 0; i < count; i++)
+            printf ")"
+
+        print " тррря"
+    }
+    else
+    {
+        print "gen_deep.sh: unknown kind \"" kind "\"" > "/dev/stderr"
+        exit 1
+    }
+
+    print "    лучше_я_сдохну_чем_стану v"
+    print "воу"
+    print ""
+    print "баттл main()"
+    print "пошумим"
+    print "    панчлайн (зачитать f()) тррря"
+    print "    лучше_я_сдохну_чем_стану 0"
+    print "воу"
+}'
@@ -0,0 +1,55 @@
+#!/bin/bash
+# gen_program.sh <statements> [functions] - prints rap program with big functions and main,
+# statements are split between functions. New names are declared through the whole function,
+# so they appear in every part of the file, lines are indented by spaces or tabs and
+# sometimes separated by empty ones
+
+statements=${1:?"usage: gen_program.sh <statements> [functions]"}
+functions=${2:-1}
+
+awk -v statements="$statements" -v functions="$functions" 'BEGIN {
+    for (f = 0; f < functions; f++)
+    {
+        if (f > 0)
+            print ""
+
+        print "раунд f" f "()"
+        print "пошумим"
+
+        names = 0
+
+        for (i = 0; i < statements / functions; i++)
+        {
+            if (i % 50 == 49)
+                print ""
+
+            indent = (i % 7 == 0) ? "\t" : "    "
+
+            if (i % 3 == 0)
+            {
+                printf "%sv%d представься %d фит %d хайп 2 тррря\n", indent, names, i, names % 1000
+                names++
+            }
+            else
+            {
+                a = i % names
+                b = (i * 7) % names
+
+                printf "%sv%d стал (v%d фит %d) хайп v%d антихайп 3 тррря\n", indent, a, b, i % 997, a
+            }
+        }
+
+        print "    лучше_я_сдохну_чем_стану v0"
+        print "воу"
+    }
+
+    print ""
+    print "баттл main()"
+    print "пошумим"
+
+    for (f = 0; f < functions; f++)
+        print "    панчлайн (зачитать f" f "()) тррря"
+
+    print "    лучше_я_сдохну_чем_стану 0"
+    print "воу"
+}'
@@ -0,0 +1,30 @@
+#!/bin/bash
+# gen_repeated.sh <statements> [terms] - prints rap program, where every statement has the same
+# expression of terms variables and constants: v стал (v фит 1 фит v фит 3 ...) хайп 1 фит k.
+# In DAG mode the expression is kept once, simplifier drops "хайп 1" in every statement
+
+statements=${1:?"usage: gen_repeated.sh <statements> [terms]"}
+terms=${2:-40}
+
+awk -v statements="$statements" -v terms="$terms" 'BEGIN {
+    expression = "v"
+
+    for (t = 1; t < terms; t++)
+        expression = expression ((t % 2 == 0) ? " фит v" : " фит " t)
+
+    print "раунд f()"
+    print "пошумим"
+    print "    v представься 1 тррря"
+
+    for (i = 0; i < statements; i++)
+        printf "    v стал (%s) хайп 1 фит %d тррря\n", expression, i % 1000
+
+    print "    лучше_я_сдохну_чем_стану v"
+    print "воу"
+    print ""
+    print "баттл main()"
+    print "пошумим"
+    print "    панчлайн (зачитать f()) тррря"
+    print "    лучше_я_сдохну_чем_стану 0"
+    print "воу"
+}'
@@ -0,0 +1,40 @@
+#!/bin/bash
+# lexer_parallel.sh [max threads] - parallel lexer must give the same result as the
+# sequential one. Frontend is run with -j1 and -j2..N over rap_sources and generated
+# multi-MB programs (valid, CRLF, with errors near the end or NUL in the middle).
+# Exit code, .ast and line:column of every reported error must be the same
+
+cd "$(dirname "$0")/.." || exit 1
+
+maxThreads=${1:-8}
+
+. tests/common.sh
+
+# big enough for several chunks of at least 1 MB
+tests/gen_program.sh 60000 > "$work/sources/big.rap"
+
+big="$work/sources/big.rap"
+lines=$(wc -l < "$big")
+
+sed 's/$/\r/' "$big" > "$work/sources/crlf.rap"
+sed "$((lines - 20))s/тррря/\$ тррря/" "$big" > "$work/sources/lexical_end.rap"
+sed "$((lines / 2))s/ 3 тррря/ 3.5 тррря/" "$big" > "$work/sources/number_middle.rap"
+sed "$((lines - 20))s/ тррря/ фит тррря/" "$big" > "$work/sources/syntax_end.rap"
+
+{ cat "$big"; printf '   \t\n\n  '; } > "$work/sources/trailing.rap"
+{ head -c $(($(wc -c < "$big") / 2)) "$big"; printf ' \0 '; cat "$big"; } > "$work/sources/nul.rap"
+
+for source in $(find "$root/rap_sources" -name '*.rap' | sort) "$work"/sources/*.rap; do
+    name=$(basename "$source" .rap)
+
+    run_frontend "$work/out/$name.j1" "$source" -j1
+
+    for threads in $(seq 2 "$maxThreads"); do
+        run_frontend "$work/out/$name.j$threads" "$source" "-j$threads"
+        compare_runs "$work/out/$name.j1" "$work/out/$name.j$threads" "$source -j$threads vs -j1"
+    done
+done
+
+echo "lexer_parallel: $runs runs, $failed mismatches"
+
+[ "$failed" -eq 0 ]
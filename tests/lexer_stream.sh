@@ -0,0 +1,42 @@
+#!/bin/bash
+# lexer_stream.sh - streaming lexer must give the same result as whole-file mode, however
+# the source is cut into blocks. Frontend is run with tiny blocks (-s1, -s2, -s3, -s5, -s7),
+# so every token and two-byte UTF-8 keyword letter gets split somewhere, and with default
+# blocks. Exit code, .ast and line:column of every reported error must be the same
+
+cd "$(dirname "$0")/.." || exit 1
+
+. tests/common.sh
+
+blockSizes="1 2 3 5 7"
+
+tests/gen_program.sh 300 > "$work/sources/small.rap"
+
+small="$work/sources/small.rap"
+lines=$(wc -l < "$small")
+
+sed 's/$/\r/' "$small" > "$work/sources/crlf.rap"
+sed "$((lines - 10))s/тррря/\$ тррря/" "$small" > "$work/sources/lexical.rap"
+sed "$((lines / 2))s/ 3 тррря/ 3.5 тррря/" "$small" > "$work/sources/fraction.rap"
+sed "$((lines / 2))s/ 3 тррря/ 99999999999 тррря/" "$small" > "$work/sources/overflow.rap"
+sed "$((lines - 10))s/ тррря/ фит тррря/" "$small" > "$work/sources/syntax.rap"
+
+{ head -c $(($(wc -c < "$small") / 2)) "$small"; printf ' \0 '; cat "$small"; } > "$work/sources/nul.rap"
+
+# keywords cross boundaries of default 64 KB blocks too
+tests/gen_program.sh 3000 > "$work/sources/blocks.rap"
+
+for source in $(find "$root/rap_sources" -name '*.rap' | sort) "$work"/sources/*.rap; do
+    name=$(basename "$source" .rap)
+
+    run_frontend "$work/out/$name.whole" "$source"
+
+    for option in $(printf -- '-s%s ' $blockSizes) -s; do
+        run_frontend "$work/out/$name$option" "$source" "$option"
+        compare_runs "$work/out/$name.whole" "$work/out/$name$option" "$source $option vs whole file"
+    done
+done
+
+echo "lexer_stream: $runs runs, $failed mismatches"
+
+[ "$failed" -eq 0 ]
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tree.h"
+#include "tree_ast.h"
+
+// Trivial rewrites must relink the child, that is left, as it is: no node is allocated,
+// only operator and constant are freed, and all nodes of x stay the same. Rewrites, that
+// would hide division by zero, must not be done
+struct simplifyCase_t
+{
+    const char *name            = NULL;
+    keywordIdxes_t operation    = KEY_UKNOWN;
+    valueNumber_t number        = 0;
+    bool isNumberLeft           = false;
+    size_t wraps                = 1;    // x is wrapped in this many operations
+};
+
+static const simplifyCase_t kCases[] =
+{
+    {"x + 0",   KEY_ADD, 0, false},
+    {"0 + x",   KEY_ADD, 0, true},
+    {"x - 0",   KEY_SUB, 0, false},
+    {"x * 1",   KEY_MUL, 1, false},
+    {"1 * x",   KEY_MUL, 1, true},
+    {"x / 1",   KEY_DIV, 1, false},
+    {"x ^ 1",   KEY_POW, 1, false},
+
+    {"((x + 0) + 0) + ... (16 times)", KEY_ADD, 0, false, 16},
+};
+
+// x is left-deep chain of + and - with variables, none of the rules changes it
+const size_t kSubtreeDepth = 64;
+const size_t kSubtreeNodes = 2 * kSubtreeDepth + 1;
+
+// Division by zero is left to runtime, so 0 / divisor is kept, if divisor may be 0
+struct keptCase_t
+{
+    const char *name            = NULL;
+    type_t divisorType          = TYPE_CONST_NUM;
+    value_t divisorValue        = {};
+};
+
+static const keptCase_t kKeptCases[] =
+{
+    {"0 / x",           TYPE_VARIABLE,  {.idx    = 0}},
+    {"0 / (input)",     TYPE_KEYWORD,   {.idx    = KEY_INPUT}},
+    {"0 / 0",           TYPE_CONST_NUM, {.number = 0}},
+};
+
+static node_t *MakeSubtree      (tree_t *tree);
+static void SubtreeNodes        (node_t *subtree, node_t **nodes);
+static int CheckCase            (const simplifyCase_t *simplifyCase, bool isShared);
+static int CheckKeptCase        (const keptCase_t *keptCase, bool isShared);
+
+int main ()
+{
+    size_t failed = 0;
+    size_t cases  = 0;
+
+    for (int isShared = 0; isShared <= 1; isShared++)
+    {
+        for (size_t i = 0; i < sizeof (kCases) / sizeof (kCases[0]); i++)
+        {
+            cases++;
+
+            if (CheckCase (&kCases[i], isShared) != 0)
+                failed++;
+        }
+
+        for (size_t i = 0; i < sizeof (kKeptCases) / sizeof (kKeptCases[0]); i++)
+        {
+            cases++;
+
+            if (CheckKeptCase (&kKeptCases[i], isShared) != 0)
+                failed++;
+        }
+    }
+
+    printf ("simplify_allocs: %lu cases, %lu failed\n", cases, failed);
+
+    return (failed == 0) ? 0 : 1;
+}
+
+int CheckCase (const simplifyCase_t *simplifyCase, bool isShared)
+{
+    program_t program = {};
+
+    if (ProgramCtor (&program) != TREE_OK)
+        return 1;
+
+    tree_t *tree = &program.ast;
+    tree->isShared = isShared;
+
+    node_t *subtree = MakeSubtree (tree);
+    node_t *root    = subtree;
+
+    // in DAG mode leaves of x and constants are shared, so they are counted once
+    size_t subtreeSize = tree->size;
+
+    for (size_t i = 0; i < simplifyCase->wraps && root != NULL; i++)
+    {
+        node_t *number = NodeCtorAndFill (tree, TYPE_CONST_NUM, {.number = simplifyCase->number}, NULL, NULL);
+
+        root = simplifyCase->isNumberLeft ?
+               NodeCtorAndFill (tree, TYPE_KEYWORD, {.idx = simplifyCase->operation}, number, root) :
+               NodeCtorAndFill (tree, TYPE_KEYWORD, {.idx = simplifyCase->operation}, root, number);
+    }
+
+    if (root == NULL)
+    {
+        ProgramDtor (&program);
+
+        return 1;
+    }
+
+    tree->root = root;
+
+    node_t *before [kSubtreeNodes] = {};
+    node_t *after  [kSubtreeNodes] = {};
+
+    SubtreeNodes (subtree, before);
+
+    size_t allocsBefore = tree->allocsCount;
+
+    int status = TreeSimplify (&program, tree, SIMPLIFY_EXPRESSIONS);
+
+    size_t allocs = tree->allocsCount - allocsBefore;
+
+    int error = 0;
+
+    const char *mode = isShared ? "-c " : "";
+
+    if (status != TREE_OK)
+    {
+        printf ("FAIL %s%s: TreeSimplify () returned %d\n", mode, simplifyCase->name, status);
+        error = 1;
+    }
+
+    if (allocs != 0)
+    {
+        printf ("FAIL %s%s: %lu nodes allocated, expected none\n", mode, simplifyCase->name, allocs);
+        error = 1;
+    }
+
+    if (tree->size != subtreeSize)
+    {
+        printf ("FAIL %s%s: %lu nodes are left, expected only %lu nodes of x\n",
+                mode, simplifyCase->name, tree->size, subtreeSize);
+        error = 1;
+    }
+
+    if (tree->root != subtree)
+    {
+        printf ("FAIL %s%s: x isn't relinked in place of the operation\n", mode, simplifyCase->name);
+        error = 1;
+    }
+    else
+    {
+        SubtreeNodes (tree->root, after);
+
+        for (size_t i = 0; i < kSubtreeNodes; i++)
+        {
+            if (before[i] != after[i])
+            {
+                printf ("FAIL %s%s: node %lu of x is replaced\n", mode, simplifyCase->name, i);
+                error = 1;
+
+                break;
+            }
+        }
+    }
+
+    ProgramDtor (&program);
+
+    return error;
+}
+
+int CheckKeptCase (const keptCase_t *keptCase, bool isShared)
+{
+    program_t program = {};
+
+    if (ProgramCtor (&program) != TREE_OK)
+        return 1;
+
+    tree_t *tree = &program.ast;
+    tree->isShared = isShared;
+
+    node_t *divisor = NodeCtorAndFill (tree, keptCase->divisorType, keptCase->divisorValue, NULL, NULL);
+    node_t *zero    = NodeCtorAndFill (tree, TYPE_CONST_NUM, {.number = 0}, NULL, NULL);
+
+    node_t *root = NodeCtorAndFill (tree, TYPE_KEYWORD, {.idx = KEY_DIV}, zero, divisor);
+    if (root == NULL)
+    {
+        ProgramDtor (&program);
+
+        return 1;
+    }
+
+    tree->root = root;
+
+    size_t size = tree->size;
+
+    int status = TreeSimplify (&program, tree, SIMPLIFY_EXPRESSIONS);
+
+    int error = 0;
+
+    const char *mode = isShared ? "-c " : "";
+
+    if (status != TREE_OK)
+    {
+        printf ("FAIL %s%s: TreeSimplify () returned %d\n", mode, keptCase->name, status);
+        error = 1;
+    }
+
+    if (tree->root != root || root->left != zero || root->right != divisor || tree->size != size)
+    {
+        printf ("FAIL %s%s: division, that may be by zero, is simplified\n", mode, keptCase->name);
+        error = 1;
+    }
+
+    ProgramDtor (&program);
+
+    return error;
+}
+
+node_t *MakeSubtree (tree_t *tree)
+{
+    node_t *subtree = NodeCtorAndFill (tree, TYPE_VARIABLE, {.idx = 0}, NULL, NULL);
+
+    for (size_t i = 1; i <= kSubtreeDepth && subtree != NULL; i++)
+    {
+        node_t *variable = NodeCtorAndFill (tree, TYPE_VARIABLE, {.idx = i % 4}, NULL, NULL);
+
+        subtree = NodeCtorAndFill (tree, TYPE_KEYWORD, {.idx = (i % 2) ? KEY_SUB : KEY_ADD},
+                                   subtree, variable);
+    }
+
+    return subtree;
+}
+
+// nodes of chain from MakeSubtree () in preorder
+void SubtreeNodes (node_t *subtree, node_t **nodes)
+{
+    size_t count = 0;
+
+    for (node_t *node = subtree; count < kSubtreeNodes; node = node->left)
+    {
+        nodes[count++] = node;
+
+        if (node->right != NULL)
+            nodes[count++] = node->right;
+    }
+}